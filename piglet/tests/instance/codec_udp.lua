@@ -31,6 +31,16 @@ tests =
         assert(not rv)
     end,
 
+    bench = function()
+        local daq = DAQHeader.new()
+        local rb = RawBuffer.new("AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA")
+        local cd = CodecData.new()
+        local dd = DecodeData.new()
+
+        local rv = Codec.bench(daq, rb, cd, dd, { iterations = 100 })
+        assert(rv.iterations == 100)
+    end,
+
     log = function()
         local rb = RawBuffer.new()
         Codec.log(rb)
@@ -35,6 +35,13 @@ tests =
         Inspector.eval(p)
     end,
 
+    bench = function()
+        local p, rb = get_packet()
+        local rv = Inspector.bench(p, { iterations = 100, warmup = 10 })
+        assert(rv.iterations == 100)
+        assert(rv.nsecs_per_op >= 0)
+    end,
+
     clear = function()
         local p, rb = get_packet()
         Inspector.clear(p)
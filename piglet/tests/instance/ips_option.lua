@@ -36,6 +36,16 @@ tests =
         assert(rv)
     end,
 
+    bench = function()
+        local rb = RawBuffer.new("foobar")
+        local cur = Cursor.new(rb)
+        local p = Packet.new(rb)
+
+        local rv = IpsOption.bench(cur, p, { iterations = 100, warmup = 10 })
+        assert(rv.iterations == 100)
+        assert(rv.cycles_per_op >= 0)
+    end,
+
     action = function()
         local rb = RawBuffer.new("foobar")
         local p = Packet.new(rb)
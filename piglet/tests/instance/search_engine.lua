@@ -12,5 +12,18 @@ tests =
 {
     initialize = function()
         assert(SearchEngine)
+    end,
+
+    search = function()
+        SearchEngine.add_pattern("foo", false)
+        SearchEngine.add_pattern("BAR", true)
+        assert(SearchEngine.prep_patterns() == 0)
+
+        assert(SearchEngine.search("xfooxbarxFOO") == 2)
+        assert(SearchEngine.search(RawBuffer.new("nothing")) == 0)
+
+        local rv = SearchEngine.bench("xfooxbarx", { iterations = 100 })
+        assert(rv.iterations == 100)
+        assert(rv.cycles_per_byte >= 0)
     end
 }
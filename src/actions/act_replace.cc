@@ -21,11 +21,15 @@
 #include "config.h"
 #endif
 
+#include "codecs/ip/checksum.h"
 #include "detection/detection_engine.h"
 #include "framework/ips_action.h"
 #include "framework/module.h"
 #include "packet_io/active.h"
 #include "protocols/packet.h"
+#include "protocols/packet_manager.h"
+#include "protocols/tcp.h"
+#include "protocols/udp.h"
 
 #include "actions.h"
 
@@ -40,35 +44,95 @@ using namespace snort;
 // queue foo
 //--------------------------------------------------------------------------
 
-static inline void Replace_ApplyChange(Packet* p, std::string& data, unsigned offset)
+// replacements are the same length as the content they overwrite so the
+// transport checksum can be adjusted for each edit instead of recomputed
+// over the whole packet by encode_update().  returns the checksum field or
+// nullptr if the packet must be fully updated.
+static uint16_t* get_cksum(Packet* p, const uint8_t*& l4)
 {
-    uint8_t* start = const_cast<uint8_t*>(p->data) + offset;
+    if ( p->is_fragment() )
+        return nullptr;
+
+    if ( p->is_tcp() and p->ptrs.tcph )
+    {
+        l4 = (const uint8_t*)p->ptrs.tcph;
+        return const_cast<uint16_t*>(&p->ptrs.tcph->th_sum);
+    }
+
+    if ( p->is_udp() and p->ptrs.udph )
+    {
+        l4 = (const uint8_t*)p->ptrs.udph;
+        return const_cast<uint16_t*>(&p->ptrs.udph->uh_chk);
+    }
+
+    return nullptr;
+}
+
+static inline void Replace_ApplyChange(
+    Packet* p, const snort::Replacement& r, const uint8_t* l4, uint16_t* cksum)
+{
+    if ( r.offset >= p->dsize )
+        return;
+
+    uint8_t* start = const_cast<uint8_t*>(p->data) + r.offset;
     const uint8_t* end = p->data + p->dsize;
     unsigned len;
 
-    if ( (start + data.size()) >= end )
-        len = p->dsize - offset;
+    if ( (start + r.data.size()) >= end )
+        len = p->dsize - r.offset;
     else
-        len = data.size();
+        len = r.data.size();
+
+    if ( !cksum )
+    {
+        memcpy(start, r.data.c_str(), len);
+        return;
+    }
+
+    // sum the 16 bit words of the transport segment touched by the edit
+    const uint8_t* wb = l4 + ((start - l4) & ~1);
+    const uint8_t* we = l4 + ((start + len - l4 + 1) & ~1);
+
+    if ( we > end )
+        we = end;
+
+    uint16_t before = checksum::cksum_add((const uint16_t*)wb, we - wb);
+    memcpy(start, r.data.c_str(), len);
+    uint16_t after = checksum::cksum_add((const uint16_t*)wb, we - wb);
 
-    memcpy(start, data.c_str(), len);
+    // cksum_add() returns the complemented sum
+    *cksum = checksum::adjust(*cksum, (uint16_t)~before, (uint16_t)~after);
 }
 
 static void Replace_ModifyPacket(Packet* p)
 {
-    std::string data;
-    unsigned offset;
-    bool modified = false;
+    const std::vector<snort::Replacement>& rpl = DetectionEngine::get_replacements();
 
-    while ( DetectionEngine::get_replacement(data, offset) )
-    {
-        modified = true;
-        Replace_ApplyChange(p, data, offset);
-    }
+    if ( rpl.empty() )
+        return;
+
+    const uint8_t* l4 = nullptr;
+    uint16_t* cksum = get_cksum(p, l4);
 
-    if ( modified )
+    // a zero udp checksum over ipv4 means none was computed
+    bool skip = cksum and p->is_udp() and !*cksum and !p->is_ip6();
+
+    // applied newest first as before
+    for ( auto it = rpl.rbegin(); it != rpl.rend(); ++it )
+        Replace_ApplyChange(p, *it, l4, skip ? nullptr : cksum);
+
+    if ( !cksum )
         p->packet_flags |= PKT_MODIFIED;
 
+    else
+    {
+        // 0 is reserved for no checksum in udp
+        if ( !skip and p->is_udp() and !*cksum )
+            *cksum = 0xffff;
+
+        PacketManager::header_modified(p);
+    }
+
     DetectionEngine::clear_replacement();
 }
 
@@ -0,0 +1,101 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// snort_bench.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "snort_bench.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace snort;
+
+Benchmark::Benchmark(const char* s, uint64_t n, const char* u) :
+    name(s), unit(u), items(n ? n : 1)
+{ }
+
+void Benchmark::add_field(const char* key, const std::string& val)
+{
+    fields += ", \"";
+    fields += key;
+    fields += "\": \"";
+    fields += val;
+    fields += "\"";
+}
+
+void Benchmark::add_field(const char* key, uint64_t val)
+{
+    fields += ", \"";
+    fields += key;
+    fields += "\": ";
+    fields += std::to_string(val);
+}
+
+void Benchmark::add_sample(Clock::duration d, uint64_t c)
+{
+    samples.emplace_back(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+    total_cycles += c;
+}
+
+void Benchmark::report()
+{
+    uint64_t total_ns = 0;
+
+    for ( auto ns : samples )
+        total_ns += ns;
+
+    std::sort(samples.begin(), samples.end());
+
+    auto pct = [this](unsigned p)
+    { return samples[(samples.size() - 1) * p / 100]; };
+
+    uint64_t total_items = items * samples.size();
+    double secs = total_ns ? total_ns / 1e9 : 1e-9;
+
+    FILE* fh = stdout;
+    const char* path = getenv("SNORT_BENCH_OUTPUT");
+
+    if ( path and *path )
+        fh = fopen(path, "a");
+
+    if ( !fh )
+        fh = stdout;
+
+    fprintf(fh, "{\"bench\": \"%s\", \"unit\": \"%s\", \"calls\": %zu"
+        ", \"items_per_call\": %" PRIu64 ", \"items_per_sec\": %.0f"
+        ", \"nsecs_per_item\": %.2f, \"cycles_per_item\": %.2f"
+        ", \"p50_nsecs\": %" PRIu64 ", \"p99_nsecs\": %" PRIu64 ", \"max_nsecs\": %" PRIu64
+        "%s}\n",
+        name.c_str(), unit.c_str(), samples.size(), items, total_items / secs,
+        (double)total_ns / total_items, (double)total_cycles / total_items,
+        pct(50), pct(99), samples.back(), fields.c_str());
+
+    if ( fh != stdout )
+        fclose(fh);
+    else
+        fflush(fh);
+
+    samples.clear();
+    total_cycles = 0;
+}
+
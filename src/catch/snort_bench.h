@@ -0,0 +1,103 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// snort_bench.h
+
+#ifndef SNORT_BENCH_H
+#define SNORT_BENCH_H
+
+// Benchmarks are hidden catch test cases tagged [.bench] so they only run
+// when selected, eg snort --catch-test [bench].  Each Benchmark times a
+// callable in repeated calls and emits one JSON object per line with the
+// throughput and the per call latency distribution, to the file named by
+// SNORT_BENCH_OUTPUT if set or else to stdout, so runs from different
+// builds can be compared.
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "main/snort_types.h"
+
+namespace snort
+{
+class SO_PUBLIC Benchmark
+{
+public:
+    // items is the number of units (packets, bytes, lookups) per call
+    Benchmark(const char* name, uint64_t items, const char* unit = "items");
+
+    // calls fun at least min_calls times and for at least min_msecs
+    template<typename Fun>
+    void run(Fun fun)
+    {
+        fun();  // warm up caches and lazy allocations
+
+        auto start = Clock::now();
+
+        do
+        {
+            uint64_t c = cycles();
+            auto t = Clock::now();
+            fun();
+            add_sample(Clock::now() - t, cycles() - c);
+        }
+        while ( samples.size() < min_calls or Clock::now() - start < min_time );
+
+        report();
+    }
+
+    // extra name / value pairs included in the report
+    void add_field(const char* key, const std::string& val);
+    void add_field(const char* key, uint64_t val);
+
+    void set_min_calls(unsigned n)
+    { min_calls = n; }
+
+    void set_min_msecs(unsigned n)
+    { min_time = std::chrono::milliseconds(n); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static uint64_t cycles()
+    {
+#if defined(__i386__) || defined(__x86_64__)
+        return __builtin_ia32_rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    void add_sample(Clock::duration, uint64_t);
+    void report();
+
+    std::string name;
+    std::string unit;
+    std::string fields;
+    uint64_t items;
+
+    unsigned min_calls = 10;
+    Clock::duration min_time = std::chrono::milliseconds(500);
+
+    std::vector<uint64_t> samples;  // nsecs per call
+    uint64_t total_cycles = 0;
+};
+}
+#endif
+
@@ -42,6 +42,10 @@
 
 #include "checksum.h"
 
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
 #define CD_IPV4_NAME "ipv4"
@@ -628,7 +632,7 @@ void Ipv4Codec::log(TextLog* const text_log, const uint8_t* raw_pkt, const uint1
 
 static THREAD_LOCAL std::mt19937* thread_rand = nullptr;
 
-static inline uint16_t IpId_Next()
+uint16_t ip::IpId_Next()
 {
     return (*thread_rand)() % UINT16_MAX;
 }
@@ -648,7 +652,7 @@ bool Ipv4Codec::encode(const uint8_t* const raw_in, const uint16_t /*raw_len*/,
     /* IPv4 encoded header is hardcoded 20 bytes */
     ip4h_out->ip_verhl = 0x45;
     ip4h_out->ip_off = 0;
-    ip4h_out->ip_id = IpId_Next();
+    ip4h_out->ip_id = ip::IpId_Next();
     ip4h_out->ip_tos = ip4h_in->ip_tos;
     ip4h_out->ip_proto = ip4h_in->ip_proto;
     ip4h_out->ip_len = htons((uint16_t)buf.size());
@@ -788,3 +792,122 @@ const BaseApi* cd_ipv4[] =
     nullptr
 };
 
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+static uint16_t recompute(const uint16_t* buf, size_t len)
+{ return checksum::cksum_add(buf, len); }
+
+TEST_CASE("checksum adjust matches recompute", "[checksum]")
+{
+    std::mt19937 gen(1624);
+    uint16_t buf[30];
+
+    for ( unsigned run = 0; run < 10000; ++run )
+    {
+        for ( auto& w : buf )
+            w = gen();
+
+        unsigned idx = gen() % 30;
+        uint16_t old_val = buf[idx];
+        uint16_t cksum = recompute(buf, sizeof(buf));
+
+        // favor the values that are both zero in ones complement
+        switch ( run % 4 )
+        {
+        case 0: buf[idx] = 0x0000; break;
+        case 1: buf[idx] = 0xffff; break;
+        default: buf[idx] = gen(); break;
+        }
+
+        CHECK(checksum::adjust(cksum, old_val, buf[idx]) == recompute(buf, sizeof(buf)));
+    }
+}
+
+TEST_CASE("checksum adjust zero edges", "[checksum]")
+{
+    uint16_t buf[4] = { 0x1234, 0x0000, 0xabcd, 0x5678 };
+    uint16_t cksum = recompute(buf, sizeof(buf));
+
+    // 0x0000 and 0xffff are the same value in the sum
+    buf[1] = 0xffff;
+    CHECK(recompute(buf, sizeof(buf)) == cksum);
+    CHECK(checksum::adjust(cksum, (uint16_t)0x0000, (uint16_t)0xffff) == cksum);
+    CHECK(checksum::adjust(cksum, (uint16_t)0xffff, (uint16_t)0x0000) == cksum);
+
+    // a field going to or from zero
+    buf[2] = 0x0000;
+    CHECK(checksum::adjust(cksum, (uint16_t)0xabcd, (uint16_t)0x0000) ==
+        recompute(buf, sizeof(buf)));
+
+    uint16_t zero = recompute(buf, sizeof(buf));
+    buf[2] = 0xabcd;
+    CHECK(checksum::adjust(zero, (uint16_t)0x0000, (uint16_t)0xabcd) == cksum);
+
+    // the covered data sums to 0xffff so the checksum is 0x0000
+    uint16_t ones[2] = { 0xff00, 0x00ff };
+    cksum = recompute(ones, sizeof(ones));
+    CHECK(cksum == 0x0000);
+
+    ones[0] = 0xfe00;
+    CHECK(checksum::adjust(cksum, (uint16_t)0xff00, (uint16_t)0xfe00) ==
+        recompute(ones, sizeof(ones)));
+}
+
+TEST_CASE("checksum adjust buffers", "[checksum]")
+{
+    std::mt19937 gen(791);
+    uint8_t buf[60];
+    uint8_t orig[sizeof(buf)];
+
+    for ( unsigned run = 0; run < 10000; ++run )
+    {
+        for ( auto& b : buf )
+            b = gen();
+
+        uint16_t cksum = recompute((uint16_t*)buf, sizeof(buf));
+        memcpy(orig, buf, sizeof(buf));
+
+        // several edits in a span, including an odd length tail
+        unsigned len = 1 + gen() % sizeof(buf);
+        unsigned edits = 1 + gen() % 8;
+
+        for ( unsigned i = 0; i < edits; ++i )
+        {
+            unsigned off = gen() % len;
+            buf[off] = (i & 1) ? 0xff : gen();
+        }
+
+        CHECK(checksum::adjust(cksum, orig, buf, len) == recompute((uint16_t*)buf, sizeof(buf)));
+    }
+
+    // no edits leave the checksum alone
+    uint16_t cksum = recompute((uint16_t*)buf, sizeof(buf));
+    memcpy(orig, buf, sizeof(buf));
+    CHECK(checksum::adjust(cksum, orig, buf, sizeof(buf)) == cksum);
+}
+
+TEST_CASE("checksum adjust 32 bit fields", "[checksum]")
+{
+    std::mt19937 gen(32);
+    uint32_t buf[10];
+
+    for ( unsigned run = 0; run < 10000; ++run )
+    {
+        for ( auto& w : buf )
+            w = gen();
+
+        unsigned idx = gen() % 10;
+        uint32_t old_val = buf[idx];
+        uint16_t cksum = recompute((uint16_t*)buf, sizeof(buf));
+
+        buf[idx] = (run & 1) ? gen() : 0;
+
+        CHECK(checksum::adjust(cksum, old_val, buf[idx]) ==
+            recompute((uint16_t*)buf, sizeof(buf)));
+    }
+}
+#endif
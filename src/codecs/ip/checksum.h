@@ -21,6 +21,7 @@
 #define CODECS_CHECKSUM_H
 
 #include <cstddef>
+#include <cstring>
 
 #include <protocols/protocol_ids.h>
 
@@ -64,6 +65,15 @@ inline uint16_t icmp_cksum(const uint16_t* buf, std::size_t len, const Pseudohea
 inline uint16_t icmp_cksum(const uint16_t* buf, std::size_t len);
 inline uint16_t ip_cksum(const uint16_t* buf, std::size_t len);
 
+//  incrementally update a checksum when one covered field changes (RFC 1624).
+//  the field values are taken as stored in the packet (network order).
+inline uint16_t adjust(uint16_t cksum, uint16_t old_val, uint16_t new_val);
+inline uint16_t adjust(uint16_t cksum, uint32_t old_val, uint32_t new_val);
+
+//  same for any number of edits within len bytes starting at a 16 bit
+//  boundary of the covered data; old_buf is a copy made before the edits.
+inline uint16_t adjust(uint16_t cksum, const void* old_buf, const void* new_buf, std::size_t len);
+
 /*
  *  NOTE: Since multiple dynamic libraries use checksums, the choice
  *          is to either include all of the checksum details in a header,
@@ -328,6 +338,49 @@ inline uint16_t ip_cksum(const uint16_t* buf, std::size_t len)
 
 inline uint16_t cksum_add(const uint16_t* buf, std::size_t len)
 { return detail::cksum_add(buf, len, 0); }
+
+inline uint16_t adjust(uint16_t cksum, uint16_t old_val, uint16_t new_val)
+{
+    // HC' = ~(~HC + ~m + m')
+    uint32_t sum = (uint16_t)~cksum;
+    sum += (uint16_t)~old_val;
+    sum += new_val;
+
+    sum = (sum >> 16) + (sum & 0x0000ffff);
+    sum += (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+inline uint16_t adjust(uint16_t cksum, uint32_t old_val, uint32_t new_val)
+{
+    cksum = adjust(cksum, (uint16_t)(old_val >> 16), (uint16_t)(new_val >> 16));
+    return adjust(cksum, (uint16_t)old_val, (uint16_t)new_val);
+}
+
+inline uint16_t adjust(uint16_t cksum, const void* old_buf, const void* new_buf, std::size_t len)
+{
+    const uint8_t* ob = static_cast<const uint8_t*>(old_buf);
+    const uint8_t* nb = static_cast<const uint8_t*>(new_buf);
+    uint32_t sum = (uint16_t)~cksum;
+
+    for ( std::size_t i = 0; i < len; i += 2 )
+    {
+        uint16_t ow = 0, nw = 0;
+        std::size_t n = (len - i > 1) ? 2 : 1;
+
+        memcpy(&ow, ob + i, n);
+        memcpy(&nw, nb + i, n);
+
+        if ( ow != nw )
+        {
+            sum += (uint16_t)~ow;
+            sum += nw;
+        }
+    }
+    sum = (sum >> 16) + (sum & 0x0000ffff);
+    sum += (sum >> 16);
+    return (uint16_t)~sum;
+}
 } // namespace checksum
 
 #endif  /* CODECS_CHECKSUM_H */
@@ -348,6 +348,9 @@ bool DetectionEngine::get_replacement(std::string& s, unsigned& off)
     return true;
 }
 
+const std::vector<snort::Replacement>& DetectionEngine::get_replacements()
+{ return Analyzer::get_switcher()->get_context()->rpl; }
+
 void DetectionEngine::clear_replacement()
 {
     Analyzer::get_switcher()->get_context()->rpl.clear();
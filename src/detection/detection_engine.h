@@ -83,6 +83,7 @@ public:
 
     static void add_replacement(const std::string&, unsigned);
     static bool get_replacement(std::string&, unsigned&);
+    static const std::vector<snort::Replacement>& get_replacements();
     static void clear_replacement();
 
     static bool detect(Packet*, bool offload_ok = false);
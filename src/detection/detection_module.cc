@@ -29,7 +29,6 @@
 
 #include "log/messages.h"
 #include "main/snort_config.h"
-#include "main/thread_config.h"
 #include "trace/trace.h"
 
 #include "detect_trace.h"
@@ -119,14 +118,6 @@ const TraceOption* DetectionModule::get_trace_options() const
 #endif
 }
 
-bool DetectionModule::end(const char*, int, SnortConfig* sc)
-{
-    if ( sc->offload_threads and ThreadConfig::get_instance_max() != 1 )
-        ParseError("You can not enable experimental offload with more than one packet thread.");
-
-    return true;
-}
-
 bool DetectionModule::set(const char*, Value& v, SnortConfig* sc)
 {
     if ( v.is("asn1") )
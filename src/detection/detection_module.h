@@ -32,7 +32,6 @@ public:
     DetectionModule();
 
     bool set(const char*, Value&, SnortConfig*) override;
-    bool end(const char*, int, SnortConfig*) override;
 
     const PegInfo* get_pegs() const override
     { return pc_names; }
@@ -288,6 +288,26 @@ int fpLogEvent(const RuleTreeNode* rtn, const OptTreeNode* otn, Packet* p)
 **    int - 1 max_events variable hit, 0 successful.
 **
 */
+static inline bool sortOrderByPriority(const OptTreeNode* otn1, const OptTreeNode* otn2)
+{
+    if ( otn1->sigInfo.priority != otn2->sigInfo.priority )
+        return otn1->sigInfo.priority < otn2->sigInfo.priority;
+
+    /* This improves stability of repeated tests */
+    return otn1->sigInfo.sid < otn2->sigInfo.sid;
+}
+
+// FIXIT-L pattern length is not a valid event sort criterion for
+// non-literals
+static inline bool sortOrderByContentLength(const OptTreeNode* otn1, const OptTreeNode* otn2)
+{
+    if ( otn1->longestPatternLen != otn2->longestPatternLen )
+        return otn1->longestPatternLen > otn2->longestPatternLen;
+
+    /* This improves stability of repeated tests */
+    return otn1->sigInfo.sid > otn2->sigInfo.sid;
+}
+
 int fpAddMatch(OtnxMatchData* omd, const OptTreeNode* otn)
 {
     RuleTreeNode* rtn = getRuntimeRtnFromOtn(otn);
@@ -314,15 +334,31 @@ int fpAddMatch(OtnxMatchData* omd, const OptTreeNode* otn)
         return 1;
     }
 
-    // don't store the same otn again
+    /*
+    **  Keep each list in event_queue order as it is built so the final
+    **  selection doesn't have to sort.  Priority and length ordering do
+    **  NOT take precedence over 'alert drop pass ...' ordering.
+    */
+    bool by_priority = sc->event_queue_config->order == SNORT_EVENTQ_PRIORITY;
+    unsigned pos = pmi->iMatchCount;
+
     for ( unsigned i = 0; i < pmi->iMatchCount; i++ )
     {
+        // don't store the same otn again
         if ( pmi->MatchArray[i] == otn )
             return 0;
+
+        if ( pos == pmi->iMatchCount and ( by_priority ?
+            sortOrderByPriority(otn, pmi->MatchArray[i]) :
+            sortOrderByContentLength(otn, pmi->MatchArray[i]) ) )
+            pos = i;
     }
 
     //  add the event to the appropriate list
-    pmi->MatchArray[ pmi->iMatchCount ] = otn;
+    for ( unsigned i = pmi->iMatchCount; i > pos; i-- )
+        pmi->MatchArray[i] = pmi->MatchArray[i - 1];
+
+    pmi->MatchArray[pos] = otn;
     pmi->iMatchCount++;
     omd->have_match = true;
     return 0;
@@ -462,62 +498,6 @@ static void rule_tree_match(
     }
 }
 
-static int sortOrderByPriority(const void* e1, const void* e2)
-{
-    const OptTreeNode* otn1;
-    const OptTreeNode* otn2;
-
-    if (!e1 || !e2)
-        return 0;
-
-    otn1 = *(OptTreeNode* const*)e1;
-    otn2 = *(OptTreeNode* const*)e2;
-
-    if ( otn1->sigInfo.priority < otn2->sigInfo.priority )
-        return -1;
-
-    if ( otn1->sigInfo.priority > otn2->sigInfo.priority )
-        return +1;
-
-    /* This improves stability of repeated tests */
-    if ( otn1->sigInfo.sid < otn2->sigInfo.sid )
-        return -1;
-
-    if ( otn1->sigInfo.sid > otn2->sigInfo.sid )
-        return +1;
-
-    return 0;
-}
-
-// FIXIT-L pattern length is not a valid event sort criterion for
-// non-literals
-static int sortOrderByContentLength(const void* e1, const void* e2)
-{
-    const OptTreeNode* otn1;
-    const OptTreeNode* otn2;
-
-    if (!e1 || !e2)
-        return 0;
-
-    otn1 = *(OptTreeNode* const*)e1;
-    otn2 = *(OptTreeNode* const*)e2;
-
-    if (otn1->longestPatternLen < otn2->longestPatternLen)
-        return +1;
-
-    if (otn1->longestPatternLen > otn2->longestPatternLen)
-        return -1;
-
-    /* This improves stability of repeated tests */
-    if ( otn1->sigInfo.sid < otn2->sigInfo.sid )
-        return +1;
-
-    if ( otn1->sigInfo.sid > otn2->sigInfo.sid )
-        return -1;
-
-    return 0;
-}
-
 /*
 **  DESCRIPTION
 **    This function flags an alert per session.
@@ -635,9 +615,6 @@ static inline int fpFinalSelectEvent(OtnxMatchData* omd, Packet* p)
 
     unsigned tcnt = 0;
     EventQueueConfig* eq = p->context->conf->event_queue_config;
-    int (*compar)(const void *, const void *);
-    compar = ( eq->order == SNORT_EVENTQ_PRIORITY )
-        ? &sortOrderByPriority : sortOrderByContentLength;
 
     for ( unsigned i = 0; i < p->context->conf->num_rule_types; i++ )
     {
@@ -649,9 +626,9 @@ static inline int fpFinalSelectEvent(OtnxMatchData* omd, Packet* p)
         if ( omd->matchInfo[i].iMatchCount )
         {
             /*
-             * We must always sort so if we que 8 and log 3 and they are
-             * all from the same action group we want them sorted so we get
-             * the highest 3 in priority, priority and length sort do NOT
+             * fpAddMatch keeps the rules sorted so if we que 8 and log 3
+             * and they are all from the same action group we get the
+             * highest 3 in priority, priority and length sort do NOT
              * take precedence over 'alert drop pass ...' ordering.  If
              * order is 'drop alert', and we log 3 for drop alerts do not
              * get logged.  IF order is 'alert drop', and we log 3 for
@@ -659,10 +636,6 @@ static inline int fpFinalSelectEvent(OtnxMatchData* omd, Packet* p)
              * built in drop/block/reset comes before alert/pass/log as
              * part of the natural ordering....Jan '06..
              */
-            /* Sort the rules in this action group */
-            qsort(omd->matchInfo[i].MatchArray, omd->matchInfo[i].iMatchCount,
-                sizeof(void*), compar);
-
             /* Process each event in the action (alert,drop,log,...) groups */
             for (unsigned j = 0; j < omd->matchInfo[i].iMatchCount; j++)
             {
@@ -676,16 +649,7 @@ static inline int fpFinalSelectEvent(OtnxMatchData* omd, Packet* p)
                         return 1;
                 }
 
-                //  Loop here so we don't log the same event multiple times.
-                for (unsigned k = 0; k < j; k++)
-                {
-                    if ( omd->matchInfo[i].MatchArray[k] == otn )
-                    {
-                        otn = nullptr;
-                        break;
-                    }
-                }
-
+                // fpAddMatch doesn't store the same otn twice so each event is logged once
                 if ( otn && !fpSessionAlerted(p, otn) )
                 {
                     if ( DetectionEngine::queue_event(otn) )
@@ -43,6 +43,14 @@
 #include "managers/module_manager.h"
 #include "utils/stats.h"
 
+#ifdef UNIT_TEST
+#include <set>
+
+#include "catch/snort_bench.h"
+#include "catch/snort_catch.h"
+#include "framework/mpse_batch.h"
+#endif
+
 using namespace snort;
 
 // FIXIT-L this could be offloader specific
@@ -181,11 +189,13 @@ bool MpseRegexOffload::get(Packet*& p)
 
 ThreadRegexOffload::ThreadRegexOffload(unsigned max) : RegexOffload(max)
 {
-    unsigned i = ThreadConfig::get_instance_max();
+    unsigned pkt_threads = ThreadConfig::get_instance_max();
+    unsigned pkt_id = get_instance_id();
     const SnortConfig* sc = SnortConfig::get_conf();
+    unsigned n = 0;
 
     for ( auto* req : idle )
-        req->thread = new std::thread(worker, req, sc, i++);
+        req->thread = new std::thread(worker, req, sc, get_thread_id(pkt_threads, pkt_id, max, n++));
 }
 
 ThreadRegexOffload::~ThreadRegexOffload()
@@ -266,25 +276,29 @@ bool ThreadRegexOffload::get(Packet*& p)
     return false;
 }
 
+// returns false when the worker should exit.  the predicate is required; a
+// request put while the worker was finishing the previous one would otherwise
+// wait out the full timeout since its notification was already missed.
+static bool wait_for_request(RegexRequest* req)
+{
+    std::unique_lock<std::mutex> lock(req->mutex);
+
+    while ( !req->offload and req->go )
+    {
+        req->cond.wait_for(lock, std::chrono::seconds(1),
+            [req]() { return req->offload or !req->go; });
+    }
+    return req->go;
+}
+
 void ThreadRegexOffload::worker(
     RegexRequest* req, const SnortConfig* initial_config, unsigned id)
 {
     set_instance_id(id);
     SnortConfig::set_conf(initial_config);
 
-    while ( true )
+    while ( wait_for_request(req) )
     {
-        {
-            std::unique_lock<std::mutex> lock(req->mutex);
-            req->cond.wait_for(lock, std::chrono::seconds(1));
-
-            if ( !req->go )
-                break;
-
-            if ( !req->offload )
-                continue;
-        }
-
         assert(req->packet);
         assert(req->packet->is_offloaded());
         assert(req->packet->context->searches.items.size() > 0);
@@ -329,3 +343,176 @@ void ThreadRegexOffload::worker(
     RuleLatency::tterm();
 }
 
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+TEST_CASE("offload thread ids", "[regex_offload]")
+{
+    for ( unsigned pkt_threads = 1; pkt_threads <= 8; ++pkt_threads )
+    {
+        for ( unsigned max = 0; max <= 4; ++max )
+        {
+            unsigned slots = ThreadRegexOffload::get_num_slots(pkt_threads, max);
+            std::set<unsigned> ids;
+
+            for ( unsigned p = 0; p < pkt_threads; ++p )
+                ids.insert(p);
+
+            for ( unsigned p = 0; p < pkt_threads; ++p )
+            {
+                for ( unsigned n = 0; n < max; ++n )
+                {
+                    unsigned id = ThreadRegexOffload::get_thread_id(pkt_threads, p, max, n);
+                    CHECK(id < slots);
+                    CHECK(ids.insert(id).second);
+                }
+            }
+            // every slot is used by exactly one thread
+            CHECK(ids.size() == slots);
+        }
+    }
+}
+
+TEST_CASE("offload request wakeup", "[regex_offload]")
+{
+    RegexRequest req;
+
+    SECTION("request put before wait")
+    {
+        // the notification is long gone when the worker gets here
+        req.offload = true;
+        req.cond.notify_one();
+
+        auto start = std::chrono::steady_clock::now();
+        CHECK(wait_for_request(&req));
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500));
+    }
+    SECTION("request put while waiting")
+    {
+        std::thread t([&req]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            std::unique_lock<std::mutex> lock(req.mutex);
+            req.offload = true;
+            req.cond.notify_one();
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        CHECK(wait_for_request(&req));
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500));
+        t.join();
+    }
+    SECTION("stop")
+    {
+        req.go = false;
+        CHECK_FALSE(wait_for_request(&req));
+    }
+}
+
+//--------------------------------------------------------------------------
+// benchmark
+//--------------------------------------------------------------------------
+
+// stands in for the fast pattern search; touches every byte like a dfa would
+class BenchMpse : public Mpse
+{
+public:
+    BenchMpse() : Mpse("bench") { }
+
+    int add_pattern(const uint8_t*, unsigned, const PatternDescriptor&, void*) override
+    { return 0; }
+
+    int prep_patterns(SnortConfig*) override
+    { return 0; }
+
+protected:
+    using Mpse::_search;
+
+    int _search(const uint8_t* buf, int n, MpseMatch, void*, int* state) override
+    {
+        unsigned s = *state;
+
+        for ( int i = 0; i < n; ++i )
+            s = (s * 31 + buf[i]) & 0xffff;
+
+        *state = s;
+        return s == 0;
+    }
+};
+
+// the same large PDUs searched in line by the packet thread and handed to
+// offload threads, which is the trade offload_threads makes
+TEST_CASE("offload vs run to completion", "[.bench][regex_offload]")
+{
+    const unsigned num_pdus = 16;
+    const unsigned pdu_len = 64 * 1024;
+
+    BenchMpse mpse;
+    MpseGroup group(&mpse);
+    std::vector<uint8_t> data(pdu_len, 'x');
+    std::vector<IpsContext*> contexts;
+
+    for ( unsigned i = 0; i < num_pdus; ++i )
+        contexts.emplace_back(new IpsContext(1));
+
+    auto load = [&](IpsContext* c)
+    {
+        MpseBatchKey<> key(data.data(), data.size());
+        c->searches.items.emplace(key, MpseBatchItem(&group));
+    };
+
+    {
+        Benchmark bench("regex_offload.inline", num_pdus * pdu_len, "bytes");
+
+        bench.run([&]()
+        {
+            for ( auto* c : contexts )
+            {
+                load(c);
+                c->searches.search();
+                c->searches.receive_responses();
+                c->searches.items.clear();
+            }
+        });
+    }
+
+    for ( unsigned threads : { 1, 2, 4 } )
+    {
+        ThreadRegexOffload offload(threads);
+        std::string name = "regex_offload.threads_" + std::to_string(threads);
+        Benchmark bench(name.c_str(), num_pdus * pdu_len, "bytes");
+        bench.add_field("offload_threads", threads);
+
+        bench.run([&]()
+        {
+            Packet* p;
+
+            for ( auto* c : contexts )
+            {
+                while ( !offload.available() )
+                {
+                    if ( offload.get(p) )
+                        p->clear_offloaded();
+                }
+                load(c);
+                c->packet->set_offloaded();
+                offload.put(c->packet);
+            }
+            while ( offload.count() )
+            {
+                if ( offload.get(p) )
+                    p->clear_offloaded();
+            }
+        });
+        offload.stop();
+    }
+
+    for ( auto* c : contexts )
+        delete c;
+
+    // the group doesn't own the mpse
+    group.normal_mpse = nullptr;
+}
+#endif
@@ -88,6 +88,14 @@ public:
     void put(snort::Packet*) override;
     bool get(snort::Packet*&) override;
 
+    // offload thread ids follow the packet thread ids; each packet thread has
+    // its own block of max ids so state slots are not shared
+    static unsigned get_thread_id(unsigned pkt_threads, unsigned pkt_id, unsigned max, unsigned n)
+    { return pkt_threads + pkt_id * max + n; }
+
+    static unsigned get_num_slots(unsigned pkt_threads, unsigned max)
+    { return pkt_threads * (1 + max); }
+
 private:
     static void worker(RegexRequest*, const snort::SnortConfig*, unsigned id);
 };
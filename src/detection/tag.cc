@@ -25,18 +25,20 @@
 
 #include "tag.h"
 
+#include <unordered_map>
+#include <vector>
+
 #include "detection/ips_context.h"
 #include "events/event.h"
-#include "hash/hash_defs.h"
-#include "hash/xhash.h"
+#include "flow/flow.h"
+#include "hash/hash_key_operations.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
 #include "main/snort_debug.h"
 #include "parser/parser.h"
 #include "protocols/packet.h"
 #include "sfip/sf_ip.h"
-#include "utils/cpp_macros.h"
-#include "utils/util.h"
+#include "utils/stats.h"
 
 #include "treenodes.h"
 
@@ -45,7 +47,6 @@
 using namespace snort;
 
 /*  D E F I N E S  **************************************************/
-#define MAX_TAG_NODES   256
 
 /* by default we'll set a 5 minute timeout if we see no activity
  * on a tag with a 'count' metric so that we prune dead sessions
@@ -54,13 +55,21 @@ using namespace snort;
 #define TAG_PRUNE_QUANTUM   300
 #define TAG_MEMCAP          4194304  /* 4MB */
 
+/* the timing wheel must span the prune quantum so an idle tag is
+ * filed in a slot that comes around no later than its deadline
+ */
+#define TAG_WHEEL_TICK      8        /* seconds per slot */
+#define TAG_WHEEL_SLOTS     64
+
 #define GID_TAG             2
 #define TAG_LOG_PKT         1
 
+static_assert(TAG_WHEEL_TICK * TAG_WHEEL_SLOTS > TAG_PRUNE_QUANTUM + TAG_WHEEL_TICK,
+    "tag wheel is too short");
+
 /*  D A T A   S T R U C T U R E S  **********************************/
-/**Key used for identifying a session or host.
+/**Key used for identifying a session without a flow.
  */
-PADDING_GUARD_BEGIN
 struct tTagFlowKey
 {
     SfIp sip;  ///source IP address
@@ -69,16 +78,38 @@ struct tTagFlowKey
     /* ports */
     uint16_t sp; ///source port
     uint16_t dp; ///destination port
+
+    bool operator==(const tTagFlowKey& k) const
+    { return sp == k.sp and dp == k.dp and sip == k.sip and dip == k.dip; }
+};
+
+static inline uint32_t hash_ip(const SfIp& ip, uint32_t c)
+{
+    const uint32_t* w = ip.get_ip6_ptr();
+    uint32_t a = w[0], b = w[1];
+    c += w[2];
+    mix(a, b, c);
+    a += w[3];
+    finalize(a, b, c);
+    return c;
+}
+
+struct TagHostHash
+{
+    size_t operator()(const SfIp& ip) const
+    { return hash_ip(ip, 0); }
+};
+
+struct TagFlowHash
+{
+    size_t operator()(const tTagFlowKey& k) const
+    { return hash_ip(k.dip, hash_ip(k.sip, (k.sp << 16) | k.dp)); }
 };
-PADDING_GUARD_END
 
 /**Node identifying a session or host based tagging.
  */
 struct TagNode
 {
-    /**key identifying a session or host. */
-    tTagFlowKey key;
-
     /** number of packets/seconds/bytes to tag for */
     int seconds;
     int packets;
@@ -97,6 +128,9 @@ struct TagNode
     /** last UNIX second that this node had a successful match */
     uint32_t last_access;
 
+    /** timing wheel entry currently tracking this node */
+    uint32_t wheel_seq;
+
     /** event id number for correlation with trigger events */
     uint16_t event_id;
     struct timeval event_time;
@@ -105,9 +139,9 @@ struct TagNode
 };
 
 /*  G L O B A L S  **************************************************/
-static THREAD_LOCAL uint32_t last_prune_time = 0;
 static THREAD_LOCAL uint32_t tag_alloc_faults = 0;
 static THREAD_LOCAL uint32_t tag_memory_usage = 0;
+static THREAD_LOCAL unsigned s_flow_tags = 0;
 
 static THREAD_LOCAL bool s_exclusive = false;
 static THREAD_LOCAL unsigned s_sessions = 0;
@@ -117,219 +151,386 @@ static THREAD_LOCAL unsigned s_sessions = 0;
 // (consecutive) sessions to be captured.
 static const unsigned s_max_sessions = 1;
 
+static void TagFree(TagNode&, unsigned size);
 
-/*  P R O T O T Y P E S  ********************************************/
-static TagNode* TagAlloc(XHash*);
-static void TagFree(XHash*, TagNode*);
-static int PruneTagCache(uint32_t, int);
-static int PruneTime(XHash* tree, uint32_t thetime);
-static void TagSession(const Packet*, TagData*, uint32_t, uint16_t, void*);
-static void TagHost(const Packet*, TagData*, uint32_t, uint16_t, void*);
-static void AddTagNode(const Packet*, TagData*, int, uint32_t, uint16_t, void*);
-static inline void SwapTag(TagNode*);
+/**Calculated memory needed per node insertion into respective table. Its includes
+ * memory needed for the map node, key and wheel entry.
+ */
+template<typename Key>
+static constexpr unsigned memory_per_node()
+{
+    return sizeof(Key) + sizeof(TagNode) + 2 * sizeof(void*) +
+        sizeof(Key) + sizeof(uint32_t);
+}
 
-class TagSessionCache : public XHash
+/*  T A G   T A B L E  **********************************************/
+// Tags not attached to a flow are kept by key and expired with a timing
+// wheel instead of scanning an LRU.  Each node is filed in the slot of
+// its idle deadline; when a slot comes due, nodes that were touched since
+// are refiled and the rest are released.  Stale wheel entries left by
+// removed or refiled nodes are skipped by sequence number.
+template<typename Key, typename Hash>
+class TagTable
 {
 public:
-    TagSessionCache(int rows, int key_len)
-        : XHash(rows, key_len)
+    TagNode* find(const Key& key)
     {
-        initialize();
-        anr_enabled = false;
-        recycle_nodes = false;
+        auto it = nodes.find(key);
+        return it == nodes.end() ? nullptr : &it->second;
     }
 
-    ~TagSessionCache() override
+    TagNode* add(const Key& key, const TagNode& tn)
     {
-        delete_hash_table();
+        auto res = nodes.emplace(key, tn);
+
+        if ( !res.second )
+            return nullptr;
+
+        if ( !wheel_tick )
+            wheel_tick = tn.last_access / TAG_WHEEL_TICK;
+
+        file(res.first->first, res.first->second);
+        return &res.first->second;
     }
 
-    void free_user_data(HashNode* hnode) override
+    void remove(const Key& key)
     {
-        TagFree(this, (TagNode*)hnode->data);
+        auto it = nodes.find(key);
+
+        if ( it != nodes.end() )
+            release(it);
     }
-};
 
-class TagHostCache : public XHash
-{
-public:
-    TagHostCache(int rows, int key_len)
-        : XHash(rows, key_len)
+    // release nodes idle past the quantum as of now
+    unsigned expire(uint32_t now)
     {
-        initialize();
-        anr_enabled = false;
-        recycle_nodes = false;
+        uint32_t now_tick = now / TAG_WHEEL_TICK;
+        unsigned pruned = 0;
+        unsigned turns = 0;
+
+        while ( wheel_tick < now_tick and turns++ < TAG_WHEEL_SLOTS )
+        {
+            ++wheel_tick;
+            due.clear();
+            due.swap(wheel[wheel_tick % TAG_WHEEL_SLOTS]);
+
+            for ( auto& e : due )
+            {
+                auto it = nodes.find(e.key);
+
+                if ( it == nodes.end() or it->second.wheel_seq != e.seq )
+                    continue;
+
+                if ( it->second.last_access + TAG_PRUNE_QUANTUM < now )
+                {
+                    release(it);
+                    ++pruned;
+                }
+                else
+                    file(it->first, it->second);
+            }
+        }
+        wheel_tick = now_tick;
+        return pruned;
     }
 
-    ~TagHostCache() override
+    // release up to max nodes in deadline order regardless of idle time
+    unsigned evict(unsigned max)
     {
-        delete_hash_table();
+        unsigned pruned = 0;
+
+        for ( unsigned i = 1; i <= TAG_WHEEL_SLOTS and pruned < max; ++i )
+        {
+            auto& slot = wheel[(wheel_tick + i) % TAG_WHEEL_SLOTS];
+
+            while ( !slot.empty() and pruned < max )
+            {
+                WheelEntry e = slot.back();
+                slot.pop_back();
+
+                auto it = nodes.find(e.key);
+
+                if ( it != nodes.end() and it->second.wheel_seq == e.seq )
+                {
+                    release(it);
+                    ++pruned;
+                }
+            }
+        }
+        return pruned;
     }
 
-    void free_user_data(HashNode* hnode) override
+    bool empty() const
+    { return nodes.empty(); }
+
+    ~TagTable()
     {
-        TagFree(this, (TagNode*)hnode->data);
+        for ( auto& kv : nodes )
+            TagFree(kv.second, memory_per_node<Key>());
     }
+
+private:
+    struct WheelEntry
+    {
+        Key key;
+        uint32_t seq;
+    };
+
+    using NodeMap = std::unordered_map<Key, TagNode, Hash>;
+
+    void file(const Key& key, TagNode& tn)
+    {
+        uint32_t tick = (tn.last_access + TAG_PRUNE_QUANTUM) / TAG_WHEEL_TICK;
+
+        if ( tick <= wheel_tick )
+            tick = wheel_tick + 1;
+
+        tn.wheel_seq = ++seq;
+        wheel[tick % TAG_WHEEL_SLOTS].push_back({ key, tn.wheel_seq });
+    }
+
+    void release(typename NodeMap::iterator it)
+    {
+        TagFree(it->second, memory_per_node<Key>());
+        nodes.erase(it);
+    }
+
+    NodeMap nodes;
+    std::vector<WheelEntry> wheel[TAG_WHEEL_SLOTS];
+    std::vector<WheelEntry> due;
+    uint32_t wheel_tick = 0;
+    uint32_t seq = 0;
 };
 
-static THREAD_LOCAL TagHostCache* host_tag_cache = nullptr;
+using TagHostTable = TagTable<SfIp, TagHostHash>;
+using TagSessionTable = TagTable<tTagFlowKey, TagFlowHash>;
 
-// FIXIT-M utilize Flow instead of separate cache
-static THREAD_LOCAL TagSessionCache* ssn_tag_cache = nullptr;
+static THREAD_LOCAL TagHostTable* host_tags = nullptr;
 
+// session tags for packets without a flow
+static THREAD_LOCAL TagSessionTable* ssn_tags = nullptr;
 
-/**Calculated memory needed per node insertion into respective cache. Its includes
- * memory needed for allocating TagNode, HashNode and key size.
- *
- * @param hash - pointer to XHash that should point to either ssn_tag_cache_ptr
- * or host_tag_cache_ptr.
- *
- * @returns number of bytes needed
- */
-static inline unsigned int memory_per_node(XHash* hash)
+/*  F L O W   T A G S  **********************************************/
+// session tags ride on the flow so they need no lookup and go away
+// with the session instead of waiting to be pruned.
+class TagFlowData : public FlowData
 {
-    if ( hash == ssn_tag_cache )
-        return sizeof(tTagFlowKey) + sizeof(HashNode) + sizeof(TagNode);
-    else if ( hash == host_tag_cache )
-        return sizeof(SfIp) + sizeof(HashNode) + sizeof(TagNode);
+public:
+    TagFlowData(const TagNode& tn) : FlowData(inspector_id), node(tn)
+    { ++s_flow_tags; }
 
-    return 0;
-}
+    ~TagFlowData() override
+    {
+        TagFree(node, 0);
+        --s_flow_tags;
+    }
 
-/** Allocate a TagNode
- *
- * Allocates a TagNode while guaranteeing that total memory usage remains within TAG_MEMCAP.
- * Least used nodes may be deleted from ssn_tag_cache and host_tag_cache to make space if
- * the limit is being exceeded.
- *
- * @param hash - pointer to XHash that should point to either ssn_tag_cache_ptr
- * or host_tag_cache_ptr.
- *
- * @returns a pointer to new TagNode or null if memory couldn't * be allocated
- */
-static TagNode* TagAlloc(
-    XHash* hash
-    )
-{
-    TagNode* tag_node = nullptr;
+    size_t size_of() override
+    { return sizeof(*this); }
 
-    if (tag_memory_usage + memory_per_node(hash) > TAG_MEMCAP)
+    static void init()
     {
-        /* aggressively prune */
-        struct timeval tv;
-        struct timezone tz;
-        int pruned_nodes = 0;
+        static unsigned id = FlowData::create_flow_data_id();
+        inspector_id = id;
+    }
 
-        tag_alloc_faults++;
+    static unsigned inspector_id;
+    TagNode node;
+};
 
-        gettimeofday(&tv, &tz);
+unsigned TagFlowData::inspector_id = 0;
 
-        pruned_nodes = PruneTagCache((uint32_t)tv.tv_sec, 0);
+static inline TagFlowData* get_flow_tag(const Flow* flow)
+{ return flow ? (TagFlowData*)flow->get_flow_data(TagFlowData::inspector_id) : nullptr; }
 
-        if (pruned_nodes == 0)
-        {
-            /* if we can't prune due to time, just try to nuke
-             * 5 not so recently used nodes */
-            pruned_nodes = PruneTagCache(0, 5);
+/*  M E M O R Y  ****************************************************/
+static int PruneTagCache(uint32_t thetime, int mustdie)
+{
+    int pruned = 0;
 
-            /* unlikely to happen since memcap has been reached */
-            if (pruned_nodes == 0)
-                return nullptr;
-        }
+    if (mustdie == 0)
+    {
+        pruned = ssn_tags->expire(thetime);
+        pruned += host_tags->expire(thetime);
     }
+    else
+    {
+        pruned = ssn_tags->evict(mustdie);
 
-    tag_node = (TagNode*)snort_calloc(sizeof(TagNode));
-    tag_memory_usage += memory_per_node(hash);
+        if ( pruned < mustdie )
+            pruned += host_tags->evict(mustdie - pruned);
+    }
 
-    return tag_node;
+    pc.tag_prunes += pruned;
+    return pruned;
 }
 
-/**Frees allocated TagNode.
+/** Reserve memory for a table node
+ *
+ * Guarantees that total memory usage remains within TAG_MEMCAP.  Idle nodes
+ * and then those closest to expiry may be released to make space if the
+ * limit is being exceeded.
  *
- * @param hash - pointer to XHash that should point to either ssn_tag_cache_ptr
- * or host_tag_cache_ptr.
- * @param node - pointer to node to be freed
+ * @returns true if the node can be added
  */
-static void TagFree(
-    XHash* hash,
-    TagNode* node
-    )
+static bool TagAlloc(unsigned size, uint32_t now)
 {
-    if (node == nullptr)
-        return;
+    if (tag_memory_usage + size > TAG_MEMCAP)
+    {
+        tag_alloc_faults++;
 
-    if ( node->metric & TAG_METRIC_SESSION )
-        s_exclusive = false;
+        /* aggressively prune */
+        if ( !PruneTagCache(now, 0) )
+        {
+            /* if we can't prune due to time, just try to nuke
+             * 5 not so recently used nodes */
+            if ( !PruneTagCache(now, 5) )
+                return false;
+        }
+    }
 
-    snort_free((void*)node);
-    tag_memory_usage -= memory_per_node(hash);
+    tag_memory_usage += size;
+    return true;
 }
 
-/**
- * swap the sips and dips, dp's and sp's
+/**Accounts for a released TagNode.
  *
- * @param np TagNode ptr
+ * @param node - node being released
+ * @param size - memory reserved for the node, 0 for flow tags
  */
-static inline void SwapTag(TagNode* np)
+static void TagFree(TagNode& node, unsigned size)
 {
-    SfIp tip;
-    uint16_t tport;
-
-    tip = np->key.sip;
-    np->key.sip = np->key.dip;
-    np->key.dip = tip;
+    if ( node.metric & TAG_METRIC_SESSION )
+        s_exclusive = false;
 
-    tport = np->key.sp;
-    np->key.sp = np->key.dp;
-    np->key.dp = tport;
+    tag_memory_usage -= size;
 }
 
 void InitTag()
 {
-    unsigned int hashTableSize = TAG_MEMCAP/sizeof(TagNode);
+    TagFlowData::init();
 
-    ssn_tag_cache = new TagSessionCache(hashTableSize, sizeof(tTagFlowKey));
-    host_tag_cache = new TagHostCache(hashTableSize, sizeof(SfIp));
+    ssn_tags = new TagSessionTable;
+    host_tags = new TagHostTable;
 }
 
 void CleanupTag()
 {
-    delete ssn_tag_cache;
-    delete host_tag_cache;
+    delete ssn_tags;
+    delete host_tags;
+
+    ssn_tags = nullptr;
+    host_tags = nullptr;
 }
 
-static void TagSession(const Packet* p, TagData* tag, uint32_t time, uint16_t event_id, void* log_list)
+/*  T A G G I N G  **************************************************/
+static void init_node(TagNode& tn, const Packet* p, const TagData* tag, int mode,
+    uint32_t now, uint16_t event_id, void* log_list)
 {
-    AddTagNode(p, tag, TAG_SESSION, time, event_id, log_list);
+    tn = { };
+    tn.metric = tag->tag_metric;
+    tn.last_access = now;
+    tn.event_id = event_id;
+    tn.event_time.tv_sec = p->pkth->ts.tv_sec;
+    tn.event_time.tv_usec = p->pkth->ts.tv_usec;
+    tn.mode = mode;
+    tn.log_list = log_list;
+
+    if (tn.metric & TAG_METRIC_SECONDS)
+    {
+        /* set the expiration time for this tag */
+        tn.seconds = now + tag->tag_seconds;
+    }
+
+    if (tn.metric & TAG_METRIC_BYTES)
+    {
+        /* set the expiration time for this tag */
+        tn.bytes = tag->tag_bytes;
+    }
+
+    if (tn.metric & TAG_METRIC_PACKETS)
+    {
+        /* set the expiration time for this tag */
+        tn.packets = tag->tag_packets;
+    }
 }
 
-static void TagHost(const Packet* p, TagData* tag, uint32_t time, uint16_t event_id, void* log_list)
+static void update_node(TagNode& returned, TagNode& tn)
 {
-    int mode;
+    if (tn.metric & TAG_METRIC_SECONDS)
+        returned.seconds = tn.seconds;
+    else
+        returned.seconds += tn.seconds;
 
-    switch (tag->tag_direction)
+    /* get rid of the new tag since we are using an existing one */
+    TagFree(tn, 0);
+}
+
+static void AddSessionNode(const Packet* p, TagNode& tn)
+{
+    if ( p->flow )
     {
-    case TAG_HOST_DST:
-        mode = TAG_HOST_DST;
-        break;
-    case TAG_HOST_SRC:
-        mode = TAG_HOST_SRC;
-        break;
-    default:
-        mode = TAG_HOST_SRC;
-        break;
+        if ( TagFlowData* fd = get_flow_tag(p->flow) )
+            update_node(fd->node, tn);
+        else
+            p->flow->set_flow_data(new TagFlowData(tn));
+
+        return;
     }
 
-    AddTagNode(p, tag, mode, time, event_id, log_list);
+    tTagFlowKey key;
+    key.sip = *p->ptrs.ip_api.get_src();
+    key.dip = *p->ptrs.ip_api.get_dst();
+    key.sp = p->ptrs.sp;
+    key.dp = p->ptrs.dp;
+
+    /* check for duplicates */
+    TagNode* returned = ssn_tags->find(key);
+
+    if (returned == nullptr)
+    {
+        tTagFlowKey rkey { key.dip, key.sip, key.dp, key.sp };
+        returned = ssn_tags->find(rkey);
+    }
+
+    if ( returned )
+        update_node(*returned, tn);
+
+    else if ( TagAlloc(memory_per_node<tTagFlowKey>(), tn.last_access) )
+        ssn_tags->add(key, tn);
+
+    else
+        ErrorMessage("AddTagNode(): Unable to allocate %u bytes of memory for new TagNode\n",
+            memory_per_node<tTagFlowKey>());
+}
+
+static void AddHostNode(const Packet* p, TagNode& tn)
+{
+    const SfIp& src = *p->ptrs.ip_api.get_src();
+    const SfIp& dst = *p->ptrs.ip_api.get_dst();
+
+    /* check for duplicates */
+    TagNode* returned = host_tags->find(src);
+
+    if (returned == nullptr)
+        returned = host_tags->find(dst);
+
+    if ( returned )
+        update_node(*returned, tn);
+
+    /* if we're supposed to be tagging the other side, swap it
+       around -- Lawrence Reed */
+    else if ( TagAlloc(memory_per_node<SfIp>(), tn.last_access) )
+        host_tags->add(tn.mode == TAG_HOST_DST ? dst : src, tn);
+
+    else
+        ErrorMessage("AddTagNode(): Unable to allocate %u bytes of memory for new TagNode\n",
+            memory_per_node<SfIp>());
 }
 
 static void AddTagNode(const Packet* p, TagData* tag, int mode, uint32_t now,
     uint16_t event_id, void* log_list)
 {
-    TagNode* idx;  /* index pointer */
-    TagNode* returned;
-    XHash* tag_cache_ptr = nullptr;
-
     debug_log(detection_trace, TRACE_TAG, p, "Adding new Tag Head\n");
 
     if ( tag->tag_metric & TAG_METRIC_SESSION )
@@ -343,102 +544,52 @@ static void AddTagNode(const Packet* p, TagData* tag, int mode, uint32_t now,
         s_exclusive = true;
         ++s_sessions;
     }
-    if (mode == TAG_SESSION)
-    {
-        tag_cache_ptr = ssn_tag_cache;
-    }
-    else
-    {
-        tag_cache_ptr = host_tag_cache;
-    }
-    idx = TagAlloc(tag_cache_ptr);
-
-    /* If a TagNode couldn't be allocated, just write an error message
-     * and return - won't be able to track this one. */
-    if (idx == nullptr)
-    {
-        ErrorMessage("AddTagNode(): Unable to allocate %u bytes of memory for new TagNode\n",
-            (unsigned)sizeof(TagNode));
-        return;
-    }
-
-    idx->key.sip = *p->ptrs.ip_api.get_src();
-    idx->key.dip = *p->ptrs.ip_api.get_dst();
-    idx->key.sp = p->ptrs.sp;
-    idx->key.dp = p->ptrs.dp;
-    idx->metric = tag->tag_metric;
-    idx->last_access = now;
-    idx->event_id = event_id;
-    idx->event_time.tv_sec = p->pkth->ts.tv_sec;
-    idx->event_time.tv_usec = p->pkth->ts.tv_usec;
-    idx->mode = mode;
-    idx->pkt_count = 0;
-    idx->log_list = log_list;
-
-    if (idx->metric & TAG_METRIC_SECONDS)
-    {
-        /* set the expiration time for this tag */
-        idx->seconds = now + tag->tag_seconds;
-    }
 
-    if (idx->metric & TAG_METRIC_BYTES)
-    {
-        /* set the expiration time for this tag */
-        idx->bytes = tag->tag_bytes;
-    }
+    TagNode tn;
+    init_node(tn, p, tag, mode, now, event_id, log_list);
 
-    if (idx->metric & TAG_METRIC_PACKETS)
-    {
-        /* set the expiration time for this tag */
-        idx->packets = tag->tag_packets;
-    }
+    if ( mode == TAG_SESSION )
+        AddSessionNode(p, tn);
+    else
+        AddHostNode(p, tn);
+}
 
-    /* check for duplicates */
-    returned = (TagNode*)tag_cache_ptr->get_user_data(idx);
+static void TagSession(const Packet* p, TagData* tag, uint32_t time, uint16_t event_id, void* log_list)
+{
+    AddTagNode(p, tag, TAG_SESSION, time, event_id, log_list);
+}
 
-    if (returned == nullptr)
-    {
-        SwapTag(idx);
-        returned = (TagNode*)tag_cache_ptr->get_user_data(idx);
-        SwapTag(idx);
-    }
+static void TagHost(const Packet* p, TagData* tag, uint32_t time, uint16_t event_id, void* log_list)
+{
+    int mode;
 
-    if (returned == nullptr)
+    switch (tag->tag_direction)
     {
-        /* if we're supposed to be tagging the other side, swap it
-           around -- Lawrence Reed */
-        if (mode == TAG_HOST_DST)
-        {
-            SwapTag(idx);
-        }
-
-        if (tag_cache_ptr->insert(idx, idx) != HASH_OK)
-        {
-            TagFree(tag_cache_ptr, idx);
-            return;
-        }
+    case TAG_HOST_DST:
+        mode = TAG_HOST_DST;
+        break;
+    case TAG_HOST_SRC:
+        mode = TAG_HOST_SRC;
+        break;
+    default:
+        mode = TAG_HOST_SRC;
+        break;
     }
-    else
-    {
-        if (idx->metric & TAG_METRIC_SECONDS)
-            returned->seconds = idx->seconds;
-        else
-            returned->seconds += idx->seconds;
 
-        /* get rid of the new tag since we are using an existing one */
-        TagFree(tag_cache_ptr, idx);
-    }
+    AddTagNode(p, tag, mode, time, event_id, log_list);
 }
 
+/*  C H E C K I N G  ************************************************/
 int CheckTagList(Packet* p, Event& event, void** log_list)
 {
-    TagNode idx;
     TagNode* returned = nullptr;
-    XHash* taglist = nullptr;
+    TagFlowData* flow_tag = nullptr;
+    tTagFlowKey key;
+    const SfIp* host = nullptr;
     char create_event = 1;
 
     /* check for active tags */
-    if (!host_tag_cache->get_num_nodes() && !ssn_tag_cache->get_num_nodes())
+    if ( !s_flow_tags && host_tags->empty() && ssn_tags->empty() )
     {
         return 0;
     }
@@ -448,52 +599,40 @@ int CheckTagList(Packet* p, Event& event, void** log_list)
         return 0;
     }
 
-    idx.key.sip = *p->ptrs.ip_api.get_src();
-    idx.key.dip = *p->ptrs.ip_api.get_dst();
-    idx.key.sp = p->ptrs.sp;
-    idx.key.dp = p->ptrs.dp;
+    pc.tag_lookups++;
 
     /* check for session tags... */
-    returned = (TagNode*)ssn_tag_cache->get_user_data(&idx);
+    if ( s_flow_tags && (flow_tag = get_flow_tag(p->flow)) )
+        returned = &flow_tag->node;
 
-    if (returned == nullptr)
+    else if ( !ssn_tags->empty() )
     {
-        idx.key.dip = *p->ptrs.ip_api.get_src();
-        idx.key.sip = *p->ptrs.ip_api.get_dst();
-        idx.key.dp = p->ptrs.sp;
-        idx.key.sp = p->ptrs.dp;
+        key.sip = *p->ptrs.ip_api.get_src();
+        key.dip = *p->ptrs.ip_api.get_dst();
+        key.sp = p->ptrs.sp;
+        key.dp = p->ptrs.dp;
 
-        returned = (TagNode*)ssn_tag_cache->get_user_data(&idx);
+        returned = ssn_tags->find(key);
 
         if (returned == nullptr)
         {
-            returned = (TagNode*)host_tag_cache->get_user_data(&idx);
-
-            if (returned == nullptr)
-            {
-                /*
-                **  Only switch sip, because that's all we check for
-                **  the host tags.
-                */
-                idx.key.sip = *p->ptrs.ip_api.get_src();
+            key = { key.dip, key.sip, key.dp, key.sp };
+            returned = ssn_tags->find(key);
+        }
+    }
 
-                returned = (TagNode*)host_tag_cache->get_user_data(&idx);
-            }
+    /* ...then host tags */
+    if ( returned == nullptr && !host_tags->empty() )
+    {
+        host = p->ptrs.ip_api.get_dst();
+        returned = host_tags->find(*host);
 
-            if (returned != nullptr)
-            {
-                taglist = host_tag_cache;
-            }
-        }
-        else
+        if (returned == nullptr)
         {
-            taglist = ssn_tag_cache;
+            host = p->ptrs.ip_api.get_src();
+            returned = host_tags->find(*host);
         }
     }
-    else
-    {
-        taglist = ssn_tag_cache;
-    }
 
     if (returned != nullptr)
     {
@@ -550,79 +689,24 @@ int CheckTagList(Packet* p, Event& event, void** log_list)
 
         if ( !returned->metric )
         {
-            if (taglist->release_node(&returned->key) != HASH_OK)
-            {
-                LogMessage("WARNING: failed to remove tagNode from hash.\n");
-            }
-        }
-    }
+            if ( flow_tag )
+                p->flow->free_flow_data(flow_tag);
 
-    if ( (unsigned)(p->pkth->ts.tv_sec) > last_prune_time + TAG_PRUNE_QUANTUM )
-    {
-        PruneTagCache(p->pkth->ts.tv_sec, 0);
-        last_prune_time = p->pkth->ts.tv_sec;
-    }
-
-    if ( returned && create_event )
-        return 1;
-
-    return 0;
-}
-
-static int PruneTagCache(uint32_t thetime, int mustdie)
-{
-    int pruned = 0;
+            else if ( host )
+                host_tags->remove(*host);
 
-    if (mustdie == 0)
-    {
-        if (ssn_tag_cache->get_num_nodes() != 0)
-            pruned = PruneTime(ssn_tag_cache, thetime);
-
-        if (host_tag_cache->get_num_nodes() != 0)
-            pruned += PruneTime(host_tag_cache, thetime);
-    }
-    else
-    {
-        while (pruned < mustdie &&
-            (ssn_tag_cache->get_num_nodes() > 0 || host_tag_cache->get_num_nodes() > 0))
-        {
-            if ( ssn_tag_cache->delete_lru_node() )
-                ++pruned;
-            else
-                LogMessage("WARNING: failed to remove tagNode from ssn hash.\n");
-
-            if ( host_tag_cache->delete_lru_node() )
-                ++pruned;
             else
-                LogMessage("WARNING: failed to remove tagNode from host hash.\n");
+                ssn_tags->remove(key);
         }
     }
 
-    return pruned;
-}
-
-static int PruneTime(XHash* tree, uint32_t thetime)
-{
-    int pruned = 0;
-    TagNode* lru_node = nullptr;
+    /* the wheels only do work when a slot comes due */
+    PruneTagCache(p->pkth->ts.tv_sec, 0);
 
-    while ((lru_node = (TagNode*)tree->get_lru_user_data()) != nullptr)
-    {
-        if ((lru_node->last_access + TAG_PRUNE_QUANTUM) < thetime)
-        {
-            if (tree->release_node(&lru_node->key) != HASH_OK)
-            {
-                LogMessage("WARNING: failed to remove tagNode from hash.\n");
-            }
-            pruned++;
-        }
-        else
-        {
-            break;
-        }
-    }
+    if ( returned && create_event )
+        return 1;
 
-    return pruned;
+    return 0;
 }
 
 void SetTags(const Packet* p, const OptTreeNode* otn, uint16_t event_id)
@@ -652,3 +736,304 @@ void SetTags(const Packet* p, const OptTreeNode* otn, uint16_t event_id)
     }
 }
 
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+#include <arpa/inet.h>
+
+#include "catch/snort_catch.h"
+
+// tags start well past the epoch so every wheel slot is in play
+#define T0 1000000
+
+struct TagTest
+{
+    IpsContext ctx;
+    Packet& p = *ctx.packet;
+    SfIp src, dst;
+    Event event;
+    void* log_list = nullptr;
+
+    TagTest()
+    {
+        InitTag();
+        s_sessions = 0;
+        p.pkth = ctx.pkth;
+        set_ips(0x0a000001, 0x0a000002, 1234, 80);
+    }
+
+    ~TagTest()
+    {
+        p.flow = nullptr;
+        CleanupTag();
+    }
+
+    void set_ips(uint32_t s, uint32_t d, uint16_t sp = 1234, uint16_t dp = 80)
+    {
+        s = htonl(s);
+        d = htonl(d);
+        src.set(&s, AF_INET);
+        dst.set(&d, AF_INET);
+        p.ptrs.ip_api.set(src, dst);
+        p.ptrs.sp = sp;
+        p.ptrs.dp = dp;
+    }
+
+    void tag(int type, int metric, uint32_t now, uint32_t count = 0, int dir = TAG_HOST_SRC)
+    {
+        TagData td = { };
+        td.tag_type = type;
+        td.tag_metric = metric;
+        td.tag_direction = dir;
+        td.tag_seconds = td.tag_packets = td.tag_bytes = count;
+
+        if ( type == TAG_SESSION )
+            TagSession(&p, &td, now, 1, nullptr);
+        else
+            TagHost(&p, &td, now, 1, nullptr);
+    }
+
+    int check(uint32_t now, uint32_t len = 100)
+    {
+        ctx.pkth->ts.tv_sec = now;
+        p.pktlen = len;
+        return CheckTagList(&p, event, &log_list);
+    }
+};
+
+TEST_CASE("tag host insert and lookup", "[tag]")
+{
+    TagTest t;
+    t.tag(TAG_HOST, TAG_METRIC_PACKETS, T0, 10);
+
+    CHECK(host_tags->find(t.src));
+    CHECK(!host_tags->find(t.dst));
+    CHECK(ssn_tags->empty());
+    CHECK(tag_memory_usage == memory_per_node<SfIp>());
+
+    // either end of any session with the host is tagged
+    t.set_ips(0x0a000009, 0x0a000001);
+    CHECK(t.check(T0) == 1);
+    CHECK(host_tags->find(t.dst)->pkt_count == 1);
+
+    t.set_ips(0x0a000009, 0x0a00000a);
+    CHECK(t.check(T0) == 0);
+
+    // a second alert for the host extends the existing node
+    t.set_ips(0x0a000001, 0x0a000003);
+    t.tag(TAG_HOST, TAG_METRIC_PACKETS, T0, 10);
+    CHECK(tag_memory_usage == memory_per_node<SfIp>());
+
+    t.set_ips(0x0a000004, 0x0a000005);
+    t.tag(TAG_HOST, TAG_METRIC_PACKETS, T0, 10, TAG_HOST_DST);
+    CHECK(host_tags->find(t.dst));
+    CHECK(!host_tags->find(t.src));
+    CHECK(tag_memory_usage == 2 * memory_per_node<SfIp>());
+
+    CleanupTag();
+    CHECK(tag_memory_usage == 0);
+}
+
+TEST_CASE("tag session insert and lookup", "[tag]")
+{
+    TagTest t;
+    t.tag(TAG_SESSION, TAG_METRIC_PACKETS, T0, 10);
+
+    CHECK(!ssn_tags->empty());
+    CHECK(host_tags->empty());
+    CHECK(tag_memory_usage == memory_per_node<tTagFlowKey>());
+
+    CHECK(t.check(T0) == 1);
+
+    // the reply direction matches the same node
+    t.set_ips(0x0a000002, 0x0a000001, 80, 1234);
+    CHECK(t.check(T0) == 1);
+
+    t.tag(TAG_SESSION, TAG_METRIC_PACKETS, T0, 10);
+    CHECK(tag_memory_usage == memory_per_node<tTagFlowKey>());
+
+    // other ports are another session
+    t.set_ips(0x0a000002, 0x0a000001, 80, 1235);
+    CHECK(t.check(T0) == 0);
+
+    CleanupTag();
+    CHECK(tag_memory_usage == 0);
+}
+
+TEST_CASE("tag expiry by packets", "[tag]")
+{
+    TagTest t;
+    t.tag(TAG_SESSION, TAG_METRIC_PACKETS, T0, 3);
+
+    // each packet is spaced to keep the tag alive while the wheel wraps
+    uint32_t now = T0;
+
+    for ( int i = 0; i < 3; ++i )
+    {
+        now += TAG_PRUNE_QUANTUM - 1;
+        CHECK(t.check(now) == 1);
+    }
+    CHECK(ssn_tags->empty());
+    CHECK(t.check(now) == 0);
+    CHECK(tag_memory_usage == 0);
+}
+
+TEST_CASE("tag expiry by bytes", "[tag]")
+{
+    TagTest t;
+    t.tag(TAG_HOST, TAG_METRIC_BYTES, T0, 250);
+
+    uint32_t now = T0;
+
+    for ( int i = 0; i < 3; ++i )
+    {
+        now += TAG_PRUNE_QUANTUM - 1;
+        CHECK(t.check(now, 100) == 1);
+    }
+    CHECK(host_tags->empty());
+    CHECK(t.check(now) == 0);
+    CHECK(tag_memory_usage == 0);
+}
+
+TEST_CASE("tag expiry by seconds", "[tag]")
+{
+    TagTest t;
+    const uint32_t secs = 2 * TAG_WHEEL_TICK * TAG_WHEEL_SLOTS;
+    t.tag(TAG_HOST, TAG_METRIC_SECONDS, T0, secs);
+
+    uint32_t now = T0;
+
+    while ( now + TAG_PRUNE_QUANTUM - 1 <= T0 + secs )
+    {
+        now += TAG_PRUNE_QUANTUM - 1;
+        CHECK(t.check(now) == 1);
+    }
+    CHECK(!host_tags->empty());
+
+    // the first packet past the deadline ends the tag without an event
+    CHECK(t.check(T0 + secs + 1) == 0);
+    CHECK(host_tags->empty());
+    CHECK(tag_memory_usage == 0);
+}
+
+TEST_CASE("tag idle expiry", "[tag]")
+{
+    TagTest t;
+    t.tag(TAG_HOST, TAG_METRIC_PACKETS, T0, 100);
+
+    // touch the node past a full turn of the wheel
+    uint32_t last = T0;
+
+    while ( last < T0 + 2 * TAG_WHEEL_TICK * TAG_WHEEL_SLOTS )
+    {
+        last += TAG_PRUNE_QUANTUM - TAG_WHEEL_TICK;
+        CHECK(t.check(last) == 1);
+    }
+
+    // unrelated traffic keeps the wheel turning
+    t.set_ips(0x0b000001, 0x0b000002);
+    PegCount prunes = pc.tag_prunes;
+
+    CHECK(t.check(last + TAG_PRUNE_QUANTUM) == 0);
+    CHECK(!host_tags->empty());
+
+    CHECK(t.check(last + TAG_PRUNE_QUANTUM + 2 * TAG_WHEEL_TICK) == 0);
+    CHECK(host_tags->empty());
+    CHECK(pc.tag_prunes == prunes + 1);
+    CHECK(tag_memory_usage == 0);
+
+    // a jump of more than a turn still visits every slot
+    t.tag(TAG_SESSION, TAG_METRIC_PACKETS, T0 + 10000, 100);
+    t.tag(TAG_HOST, TAG_METRIC_PACKETS, T0 + 10000, 100);
+    t.set_ips(0x0c000001, 0x0c000002);
+
+    CHECK(t.check(T0 + 10000 + 10 * TAG_WHEEL_TICK * TAG_WHEEL_SLOTS) == 0);
+    CHECK(ssn_tags->empty());
+    CHECK(host_tags->empty());
+    CHECK(tag_memory_usage == 0);
+}
+
+TEST_CASE("tag eviction at the memcap", "[tag]")
+{
+    TagTest t;
+    const unsigned cap = TAG_MEMCAP / memory_per_node<SfIp>();
+    const uint32_t faults = tag_alloc_faults;
+    const PegCount prunes = pc.tag_prunes;
+
+    for ( unsigned i = 0; i < cap; ++i )
+    {
+        t.set_ips(0x0a000000 + i, 0x0b000000);
+        t.tag(TAG_HOST, TAG_METRIC_PACKETS, T0, 10);
+    }
+    CHECK(tag_alloc_faults == faults);
+    CHECK(tag_memory_usage == cap * memory_per_node<SfIp>());
+
+    // nothing is idle so the nodes due first make room
+    t.set_ips(0x0c000000, 0x0b000000);
+    t.tag(TAG_HOST, TAG_METRIC_PACKETS, T0 + 1, 10);
+
+    CHECK(tag_alloc_faults == faults + 1);
+    CHECK(pc.tag_prunes == prunes + 5);
+    CHECK(tag_memory_usage <= TAG_MEMCAP);
+    CHECK(host_tags->find(t.src));
+
+    unsigned found = 0;
+
+    for ( unsigned i = 0; i < cap; ++i )
+    {
+        uint32_t ip = htonl(0x0a000000 + i);
+        SfIp sip;
+        sip.set(&ip, AF_INET);
+
+        if ( host_tags->find(sip) )
+            ++found;
+    }
+    CHECK(found == cap - 5);
+    CHECK(tag_memory_usage == (found + 1) * memory_per_node<SfIp>());
+
+    CleanupTag();
+    CHECK(tag_memory_usage == 0);
+}
+
+TEST_CASE("tag flow data teardown", "[tag]")
+{
+    TagTest t;
+    Flow flow;
+    t.p.flow = &flow;
+
+    t.tag(TAG_SESSION, TAG_METRIC_PACKETS | TAG_METRIC_SESSION, T0, 10);
+
+    CHECK(s_flow_tags == 1);
+    CHECK(s_exclusive);
+    CHECK(ssn_tags->empty());
+    CHECK(tag_memory_usage == 0);
+    CHECK(get_flow_tag(&flow));
+    CHECK(t.check(T0) == 1);
+
+    // the tag goes with the session instead of waiting on the wheel
+    flow.free_flow_data();
+
+    CHECK(s_flow_tags == 0);
+    CHECK(!s_exclusive);
+    CHECK(t.check(T0) == 0);
+}
+
+TEST_CASE("tag flow data ends with its metric", "[tag]")
+{
+    TagTest t;
+    Flow flow;
+    t.p.flow = &flow;
+
+    t.tag(TAG_SESSION, TAG_METRIC_PACKETS, T0, 2);
+    CHECK(s_flow_tags == 1);
+
+    CHECK(t.check(T0) == 1);
+    CHECK(t.check(T0) == 1);
+
+    CHECK(s_flow_tags == 0);
+    CHECK(!get_flow_tag(&flow));
+}
+#endif
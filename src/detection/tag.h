@@ -23,9 +23,8 @@
 
 // rule option tag causes logging of some number of subsequent packets
 // following an alert.  this module is use by the tag option to implement
-// that functionality.  uses its own hash table.
-//
-// FIXIT-L convert tags to use flow instead of hash table.
+// that functionality.  session tags are kept on the flow when there is one;
+// host tags and flowless session tags use their own tables.
 
 #include <cstdint>
 
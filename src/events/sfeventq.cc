@@ -68,8 +68,8 @@ SF_EVENTQ* sfeventq_new(int max_nodes, int log_nodes, int event_size)
 
     SF_EVENTQ* eq = (SF_EVENTQ*)snort_calloc(sizeof(SF_EVENTQ));
 
-    /* Initialize the memory for the nodes that we are going to use. */
-    eq->node_mem = (SF_EVENTQ_NODE*)snort_calloc(max_nodes, sizeof(SF_EVENTQ_NODE));
+    /* Initialize the memory for the queue slots that we are going to use. */
+    eq->events = (void**)snort_calloc(max_nodes, sizeof(void*));
     eq->event_mem = (char*)snort_calloc(max_nodes + 1, event_size);
 
     eq->max_nodes = max_nodes;
@@ -126,7 +126,6 @@ unsigned sfeventq_reset(SF_EVENTQ* eq)
 {
     unsigned fails = eq->fails;
     eq->fails = 0;
-    eq->head = nullptr;
     eq->cur_nodes = 0;
     eq->cur_events = 0;
     eq->reserve_event = (char*)(&eq->event_mem[eq->max_nodes * eq->event_size]);
@@ -138,11 +137,11 @@ void sfeventq_free(SF_EVENTQ* eq)
     if (eq == nullptr)
         return;
 
-    /* Free the memory for the nodes that were in use. */
-    if (eq->node_mem != nullptr)
+    /* Free the memory for the queue slots. */
+    if (eq->events != nullptr)
     {
-        snort_free(eq->node_mem);
-        eq->node_mem = nullptr;
+        snort_free(eq->events);
+        eq->events = nullptr;
     }
 
     if (eq->event_mem != nullptr)
@@ -155,35 +154,9 @@ void sfeventq_free(SF_EVENTQ* eq)
 }
 
 /*
-**  This function returns a ptr to the node to use.  We allocate the last
-**  event node if we have exhausted the event queue.  Before we allocate
-**  the last node, we determine if the incoming event has a higher
-**  priority than the last node.  If it does, we allocate the node, otherwise
-**  we drop it because it is lower priority.
-**
-**  If the last node is allocated, we have to point the reserve_event to
-**  the allocated event memory, since the reserved_event memory was used
-**  for the incoming event.
-**
-**  @return SF_EVENTQ_NODE *
-**
-**  @retval null - resource exhaustion and event is lower priority than last node
-**  @retval !null - ptr to node memory.
-*/
-static SF_EVENTQ_NODE* get_eventq_node(SF_EVENTQ* eq, void*)
-{
-    if (eq->cur_nodes >= eq->max_nodes)
-        return nullptr;
-
-    //  We grab the next node from the node memory.
-    return &eq->node_mem[eq->cur_nodes++];
-}
-
-/*
-**  Add this event to the queue using the supplied ordering
-**  function.  If the queue is exhausted, then we compare the
-**  event to be added with the last event, and decide whether
-**  it is a higher priority than the last node.
+**  Add this event to the end of the queue.  If the queue is
+**  exhausted the event is dropped; events are ranked before
+**  they are queued so the earlier ones take precedence.
 **
 **  @return integer
 **
@@ -194,37 +167,13 @@ int sfeventq_add(SF_EVENTQ* eq, void* event)
 {
     assert(event);
 
-    /*
-    **  If get_eventq_node() returns null, this means that
-    **  we have exhausted the eventq and the incoming event
-    **  is lower in priority then the last ranked event.
-    **  So we just drop it.
-    */
-    SF_EVENTQ_NODE* node = get_eventq_node(eq, event);
-
-    if ( !node )
+    if (eq->cur_nodes >= eq->max_nodes)
     {
         ++eq->fails;
         return -1;
     }
 
-    node->event = event;
-    node->next  = nullptr;
-    node->prev  = nullptr;
-
-    if (eq->cur_nodes == 1)
-    {
-        //  This is the first node
-        eq->head = eq->last = node;
-        return 0;
-    }
-
-    //  This means we are the last node.
-    node->prev = eq->last;
-
-    eq->last->next = node;
-    eq->last = node;
-
+    eq->events[eq->cur_nodes++] = event;
     return 0;
 }
 
@@ -240,26 +189,19 @@ int sfeventq_add(SF_EVENTQ* eq, void* event)
 */
 int sfeventq_action(SF_EVENTQ* eq, int (* action_func)(void*, void*), void* user)
 {
-    SF_EVENTQ_NODE* node;
-    int logged = 0;
-
     if (action_func == nullptr)
         return -1;
 
-    if (eq->head == nullptr)
+    if (eq->cur_nodes == 0)
         return 0;
 
-    for (node = eq->head; node != nullptr; node = node->next)
-    {
-        if (logged >= eq->log_nodes)
-            return 1;
+    int n = eq->cur_nodes < eq->log_nodes ? eq->cur_nodes : eq->log_nodes;
 
-        if (action_func(node->event, user))
+    for (int i = 0; i < n; i++)
+    {
+        if (action_func(eq->events[i], user))
             return -1;
-
-        logged++;
     }
 
     return 1;
 }
-
@@ -20,24 +20,14 @@
 #ifndef SFEVENTQ_H
 #define SFEVENTQ_H
 
-struct SF_EVENTQ_NODE
-{
-    void* event;
-
-    SF_EVENTQ_NODE* prev;
-    SF_EVENTQ_NODE* next;
-};
-
 struct SF_EVENTQ
 {
     /*
     **  Handles the actual ordering and memory
-    **  of the event queue and it's nodes.
+    **  of the event queue.  Events are kept in
+    **  a fixed array in insertion order.
     */
-    SF_EVENTQ_NODE* head;
-    SF_EVENTQ_NODE* last;
-
-    SF_EVENTQ_NODE* node_mem;
+    void** events;
     char* event_mem;
 
     /*
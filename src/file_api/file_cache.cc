@@ -24,6 +24,7 @@
 #include "file_cache.h"
 
 #include "flow/flow_key.h"
+#include "hash/concurrent_xhash.h"
 #include "hash/hash_defs.h"
 #include "hash/xhash.h"
 #include "log/messages.h"
@@ -85,8 +86,16 @@ static int64_t time_elapsed_ms(struct timeval* now, struct timeval* expire_time,
 FileCache::FileCache(int64_t max_files_cached)
 {
     max_files = max_files_cached;
-    fileHash = new ExpectedFileCache(max_files, sizeof(FileHashKey), sizeof(FileNode));
-    fileHash->set_max_nodes(max_files);
+
+    // every stripe must be able to hold one file per packet thread plus one
+    // or pruning can evict a context still in use, so small caps get fewer
+    // stripes
+    int minimal_files = ThreadConfig::get_instance_max() + 1;
+    unsigned stripes = ConcurrentXHash<ExpectedFileCache>::get_stripes(max_files, minimal_files);
+
+    fileHash = new ConcurrentXHash<ExpectedFileCache>(
+        stripes, max_files, sizeof(FileHashKey), sizeof(FileNode));
+    fileHash->set_max_nodes(max_files, minimal_files);
 }
 
 FileCache::~FileCache()
@@ -119,7 +128,10 @@ void FileCache::set_max_files(int64_t max)
     }
     else
         max_files = max;
-    fileHash->set_max_nodes(max_files);
+
+    // the stripe count is fixed at construction so a later, smaller cap
+    // still keeps the minimum in every stripe
+    fileHash->set_max_nodes(max_files, minimal_files);
 }
 
 FileContext* FileCache::add(const FileHashKey& hashKey, int64_t timeout)
@@ -139,8 +151,6 @@ FileContext* FileCache::add(const FileHashKey& hashKey, int64_t timeout)
 
     new_node.file = new FileContext;
 
-    std::lock_guard<std::mutex> lock(cache_mutex);
-
     if (fileHash->insert((void*)&hashKey, &new_node) != HASH_OK)
     {
         /* Uh, shouldn't get here...
@@ -160,19 +170,20 @@ FileContext* FileCache::add(const FileHashKey& hashKey, int64_t timeout)
 
 FileContext* FileCache::find(const FileHashKey& hashKey, int64_t timeout)
 {
-    std::lock_guard<std::mutex> lock(cache_mutex);
+    std::unique_lock<std::mutex> lock;
+    ExpectedFileCache* stripe = fileHash->lock(&hashKey, lock);
 
-    if ( !fileHash->get_num_nodes() )
+    if ( !stripe->get_num_nodes() )
         return nullptr;
 
-    HashNode* hash_node = fileHash->find_node(&hashKey);
+    HashNode* hash_node = stripe->find_node(&hashKey);
     if ( !hash_node )
         return nullptr;
 
     FileNode* node = (FileNode*)hash_node->data;
     if ( !node )
     {
-        fileHash->release_node(hash_node);
+        stripe->release_node(hash_node);
         return nullptr;
     }
 
@@ -181,7 +192,7 @@ FileContext* FileCache::find(const FileHashKey& hashKey, int64_t timeout)
 
     if ( timercmp(&node->cache_expire_time, &now, <) )
     {
-        fileHash->release_node(hash_node);
+        stripe->release_node(hash_node);
         return nullptr;
     }
 
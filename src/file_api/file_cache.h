@@ -30,6 +30,11 @@
 
 class ExpectedFileCache;
 
+namespace snort
+{
+template<typename> class ConcurrentXHash;
+}
+
 class FileCache
 {
 public:
@@ -73,12 +78,12 @@ private:
     FileVerdict check_verdict(snort::Packet*, snort::FileInfo*, snort::FilePolicyBase*);
     int store_verdict(snort::Flow*, snort::FileInfo*, int64_t timeout);
 
-    /* The hash table of expected files */
-    ExpectedFileCache* fileHash = nullptr;
+    /* The hash table of expected files, shared by all packet threads */
+    snort::ConcurrentXHash<ExpectedFileCache>* fileHash = nullptr;
     int64_t block_timeout = DEFAULT_FILE_BLOCK_TIMEOUT;
     int64_t lookup_timeout = DEFAULT_FILE_LOOKUP_TIMEOUT;
     int64_t max_files = DEFAULT_MAX_FILES_CACHED;
-    std::mutex cache_mutex;
+    std::mutex cache_mutex;  // for the settings; fileHash locks itself
 };
 
 #endif
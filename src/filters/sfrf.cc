@@ -35,7 +35,6 @@
 #include "sfip/sf_ip.h"
 #include "sfip/sf_ipvar.h"
 #include "utils/cpp_macros.h"
-#include "utils/sflsq.h"
 #include "utils/util.h"
 
 using namespace snort;
@@ -194,8 +193,11 @@ static void SFRF_ConfigNodeFree(void* item)
 static void SFRF_SidNodeFree(void* item)
 {
     tSFRFSidNode* pSidnode = (tSFRFSidNode*)item;
-    sflist_free_all(pSidnode->configNodeList, SFRF_ConfigNodeFree);
-    snort_free(pSidnode);
+
+    for ( auto* cfgNode : pSidnode->configNodeList )
+        SFRF_ConfigNodeFree(cfgNode);
+
+    delete pSidnode;
 }
 
 int SFRF_Alloc(unsigned int memcap)
@@ -284,23 +286,16 @@ int SFRF_ConfigAdd(SnortConfig*, RateFilterConfig* rf_config, tSFRFConfigNode* c
     if ( !pSidNode )
     {
         /* Create the pSidNode hash node data */
-        pSidNode = (tSFRFSidNode*)snort_calloc(sizeof(tSFRFSidNode));
+        pSidNode = new tSFRFSidNode();
 
+        pSidNode->policyId = policy_id;
         pSidNode->gid = cfgNode->gid;
         pSidNode->sid = cfgNode->sid;
-        pSidNode->configNodeList = sflist_new();
-
-        if ( !pSidNode->configNodeList )
-        {
-            snort_free(pSidNode);
-            return -4;
-        }
 
         /* Add the pSidNode to the hash table */
         if ( genHash->insert((void*)&key, pSidNode) )
         {
-            sflist_free(pSidNode->configNodeList);
-            snort_free(pSidNode);
+            delete pSidNode;
             return -5;
         }
     }
@@ -315,10 +310,8 @@ int SFRF_ConfigAdd(SnortConfig*, RateFilterConfig* rf_config, tSFRFConfigNode* c
     pNewConfigNode->tid = rf_config->count;
     if ( pNewConfigNode->tid == 0 )
     {
-        // tid overflow. rare but possible
+        // tid overflow. rare but possible; pSidNode stays owned by the hash
         snort_free(pNewConfigNode);
-        sflist_free(pSidNode->configNodeList);
-        snort_free(pSidNode);
         return -6;
     }
 
@@ -329,7 +322,7 @@ int SFRF_ConfigAdd(SnortConfig*, RateFilterConfig* rf_config, tSFRFConfigNode* c
         pNewConfigNode->sid);
     fflush(stdout);
 #endif
-    sflist_add_tail(pSidNode->configNodeList,pNewConfigNode);
+    pSidNode->configNodeList.emplace_back(pNewConfigNode);
 
     return 0;
 }
@@ -454,7 +447,6 @@ int SFRF_TestThreshold(
 {
     GHash* genHash;
     tSFRFSidNode* pSidNode;
-    tSFRFConfigNode* cfgNode;
     int newStatus = -1;
     int status = -1;
     tSFRFGenHashKey key;
@@ -502,7 +494,7 @@ int SFRF_TestThreshold(
     }
 
     /* No List of Threshold objects - bail and log it */
-    if ( !pSidNode->configNodeList )
+    if ( pSidNode->configNodeList.empty() )
     {
 #ifdef SFRF_DEBUG
         printf("--SFRF_DEBUG: %d-%u-%u: No user configuration\n",
@@ -515,11 +507,7 @@ int SFRF_TestThreshold(
     /* For each permanent thresholding object, test/add/update the config object
        We maintain a list of thd objects for each gid+sid
        each object has it's own unique thd_id */
-    SF_LNODE* cursor;
-
-    for ( cfgNode  = (tSFRFConfigNode*)sflist_first(pSidNode->configNodeList, &cursor);
-        cfgNode != nullptr;
-        cfgNode  = (tSFRFConfigNode*)sflist_next(&cursor) )
+    for ( auto* cfgNode : pSidNode->configNodeList )
     {
         switch (cfgNode->tracking)
         {
@@ -575,7 +563,6 @@ int SFRF_TestThreshold(
 void SFRF_ShowObjects(RateFilterConfig* config)
 {
     tSFRFSidNode* pSidnode;
-    tSFRFConfigNode* cfgNode;
     unsigned int gid;
     GHashNode* sidHashNode;
 
@@ -601,11 +588,7 @@ void SFRF_ShowObjects(RateFilterConfig* config)
             /* For each permanent thresholding object, test/add/update the thd object
                We maintain a list of thd objects for each gid+sid
                each object has it's own unique thd_id */
-            SF_LNODE* cursor;
-
-            for (cfgNode  = (tSFRFConfigNode*)sflist_first(pSidnode->configNodeList, &cursor);
-                 cfgNode != nullptr;
-                 cfgNode = (tSFRFConfigNode*)sflist_next(&cursor) )
+            for ( auto* cfgNode : pSidnode->configNodeList )
             {
                 printf(".........SFRF_ID  =%d\n",cfgNode->tid);
                 printf(".........tracking =%d\n",cfgNode->tracking);
@@ -25,6 +25,7 @@
 // Implements rate_filter feature for snort
 
 #include <ctime>
+#include <vector>
 
 #include "actions/actions.h"
 #include "framework/counts.h"
@@ -120,7 +121,7 @@ struct tSFRFSidNode
     unsigned sid;
 
     // List of threshold configuration nodes of type tSFRFConfigNode
-    struct sf_list* configNodeList;
+    std::vector<tSFRFConfigNode*> configNodeList;
 };
 
 struct tSFRFGenHashKey
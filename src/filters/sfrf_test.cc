@@ -23,6 +23,7 @@
 #endif
 
 #include "catch/snort_catch.h"
+#include "hash/ghash.h"
 #include "main/snort_config.h"
 #include "parser/parse_ip.h"
 #include "sfip/sf_ip.h"
@@ -1021,3 +1022,69 @@ TEST_CASE("sfrf minimum memcap", "[sfrf]")
     }
     Term();
 }
+
+static tSFRFSidNode* get_sid_node(unsigned gid, unsigned sid)
+{
+    tSFRFGenHashKey key = { get_ips_policy()->policy_id, sid };
+    return (tSFRFSidNode*)rfc->genHash[gid]->find(&key);
+}
+
+static int add_node(unsigned gid, unsigned sid, SFRF_TRACK track, int action, const char* ip)
+{
+    tSFRFConfigNode cfg;
+
+    cfg.gid = gid;
+    cfg.sid = sid;
+    cfg.tracking = track;
+    cfg.count = 1;
+    cfg.seconds = 1;
+    cfg.newAction = (Actions::Type)action;
+    cfg.timeout = 1;
+    cfg.applyTo = ip ? sfip_var_from_string(ip, "sfrf_test") : nullptr;
+
+    return SFRF_ConfigAdd(nullptr, rfc, &cfg);
+}
+
+static int test_node(unsigned gid, unsigned sid, long now)
+{
+    EventData ev = { 0, gid, sid, IP4_SRC, IP4_DST, (float)now, 0 };
+    return EventTest(&ev);
+}
+
+TEST_CASE("sfrf config list", "[sfrf]")
+{
+    SnortConfig sc;
+    set_default_policy(&sc);
+    rfc = RateFilter_ConfigNew();
+    rfc->memcap = MEM_DEFAULT;
+    SFRF_Alloc(rfc->memcap);
+
+    CHECK(add_node(300, 1, TRK_SRC, 1, IP4_EXT) == 0);
+    CHECK(add_node(300, 1, TRK_RUL, 2, IP_ANY) == 0);
+    CHECK(add_node(300, 1, TRK_DST, 3, IP_ANY) == 0);
+
+    // nodes are kept in configuration order with ascending tids
+    tSFRFSidNode* node = get_sid_node(300, 1);
+    REQUIRE(node);
+    REQUIRE(node->configNodeList.size() == 3);
+
+    CHECK(node->configNodeList[0]->tracking == TRK_SRC);
+    CHECK(node->configNodeList[1]->tracking == TRK_RUL);
+    CHECK(node->configNodeList[2]->tracking == TRK_DST);
+
+    CHECK(node->configNodeList[0]->tid < node->configNodeList[1]->tid);
+    CHECK(node->configNodeList[1]->tid < node->configNodeList[2]->tid);
+
+    // the walk skips nodes that don't apply and the first node over its
+    // rate sets the action
+    CHECK(test_node(300, 1, 100) == RULE_ORIG);
+    CHECK(test_node(300, 1, 100) == 2);
+
+    // a tid overflow rejects the node but leaves the sid node in the hash
+    rfc->count = -1;
+    CHECK(add_node(300, 1, TRK_RUL, 4, IP_ANY) == -6);
+    CHECK(get_sid_node(300, 1) == node);
+    CHECK(node->configNodeList.size() == 3);
+
+    Term();
+}
@@ -41,7 +41,6 @@
 #include "main/thread.h"
 #include "sfip/sf_ipvar.h"
 #include "utils/dyn_array.h"
-#include "utils/sflsq.h"
 #include "utils/util.h"
 
 using namespace snort;
@@ -212,8 +211,11 @@ void sfthd_objs_free(ThresholdObjects* thd_objs)
 static void sfthd_item_free(void* item)
 {
     THD_ITEM* sfthd_item = (THD_ITEM*)item;
-    sflist_free_all(sfthd_item->sfthd_node_list, sfthd_node_free);
-    snort_free(sfthd_item);
+
+    for ( auto* sfthd_node : sfthd_item->sfthd_node_list )
+        sfthd_node_free(sfthd_node);
+
+    delete sfthd_item;
 }
 
 void sfthd_free(THD_STRUCT* thd)
@@ -323,24 +325,16 @@ static int sfthd_create_threshold_local(
     if ( !sfthd_item )
     {
         /* Create the sfthd_item hash node data */
-        sfthd_item = (THD_ITEM*)snort_calloc(sizeof(THD_ITEM));
+        sfthd_item = new THD_ITEM();
 
         sfthd_item->gen_id = config->gen_id;
         sfthd_item->sig_id = config->sig_id;
         sfthd_item->policyId = policy_id;
-        sfthd_item->sfthd_node_list = sflist_new();
-
-        if (!sfthd_item->sfthd_node_list)
-        {
-            snort_free(sfthd_item);
-            return -4;
-        }
 
         /* Add the sfthd_item to the hash table */
         if ( sfthd_hash->insert((void*)&key, sfthd_item) )
         {
-            sflist_free(sfthd_item->sfthd_node_list);
-            snort_free(sfthd_item);
+            delete sfthd_item;
             return -5;
         }
     }
@@ -349,28 +343,20 @@ static int sfthd_create_threshold_local(
      * Test that we only have one Limit/Threshold/Both Object at the tail,
      * we can have multiple suppression nodes at the head
      */
-    if ( sfthd_item->sfthd_node_list->count > 0  )
+    if ( !sfthd_item->sfthd_node_list.empty() )
     {
-        THD_NODE* p;
-        if ( !sfthd_item->sfthd_node_list->tail)
-        {
-            /* can you say paranoid- if there is a count, there should be a tail */
-            return -10;
-        }
-        p = (THD_NODE*)sfthd_item->sfthd_node_list->tail->ndata;
-        if (p) /* just to be safe- if there is a tail, there is is node data */
+        THD_NODE* p = sfthd_item->sfthd_node_list.back();
+
+        if ( p->type != THD_TYPE_SUPPRESS && config->type != THD_TYPE_SUPPRESS )
         {
-            if ( p->type != THD_TYPE_SUPPRESS && config->type != THD_TYPE_SUPPRESS )
-            {
 #ifdef THD_DEBUG
-                printf("THD_DEBUG: Could not add a 2nd Threshold object, "
-                    "you can only have 1 per sid: gid=%u, sid=%u\n",
-                    config->gen_id, config->sig_id);
+            printf("THD_DEBUG: Could not add a 2nd Threshold object, "
+                "you can only have 1 per sid: gid=%u, sid=%u\n",
+                config->gen_id, config->sig_id);
 #endif
-                /* cannot add more than one threshold per sid in
-                   version 3.0, wait for 3.2 and CIDR blocks */
-                return THD_TOO_MANY_THDOBJ;
-            }
+            /* cannot add more than one threshold per sid in
+               version 3.0, wait for 3.2 and CIDR blocks */
+            return THD_TOO_MANY_THDOBJ;
         }
     }
 
@@ -412,49 +398,18 @@ static int sfthd_create_threshold_local(
       thresholding node.
     */
     {
-        SF_LNODE* lnode;
-        NODE_DATA ndata;
+        auto& nodes = sfthd_item->sfthd_node_list;
+        auto pos = nodes.begin();
 
-        /* Walk the list and insert based on priorities if suppress */
-        for ( ndata = sflist_first(sfthd_item->sfthd_node_list, &lnode);
-            ndata;
-            ndata = sflist_next(&lnode) )
-        {
-            THD_NODE* sfthd_n = (THD_NODE*)ndata;
+        /* insert before the first node of lower priority, else at the tail */
+        while ( pos != nodes.end() and sfthd_node->priority <= (*pos)->priority )
+            ++pos;
 
-            /* check if the new node is higher priority */
-            if ( sfthd_node->priority > sfthd_n->priority  )
-            {
-                /* insert before current node */
 #ifdef THD_DEBUG
-                printf("Threshold node added after based on priority\n"); fflush(stdout);
-#endif
-                sflist_add_before(sfthd_item->sfthd_node_list,lnode,sfthd_node);
-                return 0;
-            }
-
-            /* last node, just insert it here */
-            if ( !lnode->next  )
-            {
-                /* if last node, insert at end of list */
-#ifdef THD_DEBUG
-                printf("Threshold node added to tail\n"); fflush(stdout);
-#endif
-                sflist_add_tail(sfthd_item->sfthd_node_list,sfthd_node);
-                return 0;
-            }
-        }
-    }
-
-    /*
-     sfthd_node list is empty - add as head node
-     */
-    assert(!sfthd_item->sfthd_node_list->count);
-    {
-#ifdef THD_DEBUG
-        printf("Threshold node added to head of list\n"); fflush(stdout);
+        printf("Threshold node added at position %zu\n", (size_t)(pos - nodes.begin()));
+        fflush(stdout);
 #endif
-        sflist_add_head(sfthd_item->sfthd_node_list,sfthd_node);
+        nodes.insert(pos, sfthd_node);
     }
 
     return 0;
@@ -1036,7 +991,6 @@ int sfthd_test_threshold(
     tThdItemKey key;
     GHash* sfthd_hash;
     THD_ITEM* sfthd_item;
-    THD_NODE* sfthd_node;
     THD_NODE* g_thd_node = nullptr;
 #ifdef THD_DEBUG
     int cnt;
@@ -1089,7 +1043,7 @@ int sfthd_test_threshold(
     }
 
     /* No List of Threshold objects - bail and log it */
-    if (sfthd_item->sfthd_node_list == nullptr)
+    if ( sfthd_item->sfthd_node_list.empty() )
     {
         goto global_test;
     }
@@ -1101,11 +1055,7 @@ int sfthd_test_threshold(
 #ifdef THD_DEBUG
     cnt=0;
 #endif
-    SF_LNODE* cursor;
-
-    for (sfthd_node = (THD_NODE*)sflist_first(sfthd_item->sfthd_node_list, &cursor);
-        sfthd_node != nullptr;
-        sfthd_node = (THD_NODE*)sflist_next(&cursor))
+    for ( auto* sfthd_node : sfthd_item->sfthd_node_list )
     {
 #ifdef THD_DEBUG
         cnt++;
@@ -1197,7 +1147,6 @@ global_test:
 int sfthd_show_objects(ThresholdObjects* thd_objs)
 {
     THD_ITEM* sfthd_item;
-    THD_NODE* sfthd_node;
     unsigned gen_id;
     GHashNode* item_hash_node;
 
@@ -1223,11 +1172,7 @@ int sfthd_show_objects(ThresholdObjects* thd_objs)
             /* For each permanent thresholding object, test/add/update the thd object
                We maintain a list of thd objects for each gen_id+sig_id
                each object has it's own unique thd_id */
-            SF_LNODE* cursor;
-
-            for ( sfthd_node  = (THD_NODE*)sflist_first(sfthd_item->sfthd_node_list, &cursor);
-                sfthd_node != 0;
-                sfthd_node = (THD_NODE*)sflist_next(&cursor) )
+            for ( auto* sfthd_node : sfthd_item->sfthd_node_list )
             {
                 printf(".........THD_ID  =%d\n",sfthd_node->thd_id);
 
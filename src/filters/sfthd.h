@@ -23,6 +23,8 @@
 #ifndef SFTHD_H
 #define SFTHD_H
 
+#include <vector>
+
 #include "framework/counts.h"
 #include "main/policy.h"
 #include "sfip/sf_ip.h"
@@ -35,8 +37,6 @@ class XHash;
 struct SnortConfig;
 }
 
-typedef struct sf_list SF_LIST;
-
 /*!
     Max GEN_ID value - Set this to the Max Used by Snort, this is used for the
     dimensions of the gen_id lookup array.
@@ -139,7 +139,7 @@ struct THD_NODE
 /*!
     The THD_ITEM acts as a container of gen_id+sig_id based threshold objects,
     this allows multiple threshold objects to be applied to a single
-    gen_id+sig_id pair. The sflist is created using the priority field,
+    gen_id+sig_id pair. The node list is sorted by the priority field,
     so highest priority objects are first in the list. When processing the
     highest priority object will trigger first.
 
@@ -154,7 +154,7 @@ struct THD_ITEM
      * List of THD_NODE's - walk this list and hash the
      * 'THD_NODE->sfthd_id + src_ip or dst_ip' to get the correct THD_IP_NODE.
      */
-    SF_LIST* sfthd_node_list;
+    std::vector<THD_NODE*> sfthd_node_list;
 };
 
 // Temporary structure useful when parsing the Snort rules
@@ -24,6 +24,7 @@
 
 #include "catch/snort_catch.h"
 #include "main/snort_config.h"
+#include "hash/ghash.h"
 #include "hash/xhash.h"
 #include "parser/parse_ip.h"
 #include "sfip/sf_ip.h"
@@ -811,6 +812,7 @@ static void Term()
     }
 
     delete dThd;
+    dThd = nullptr;
 }
 
 static int SetupCheck(int i)
@@ -967,3 +969,69 @@ TEST_CASE("sfthd detect", "[sfthd]")
     Term();
 }
 
+
+static int add_thd(unsigned sid, int type, int priority, const char* ip)
+{
+    sfip_var_t* set = ip ? sfip_var_from_string(ip, "sfthd_test") : nullptr;
+
+    return sfthd_create_threshold(nullptr, pThdObjs, 100, sid, THD_TRK_SRC, type,
+        priority, 1, 60, set, get_network_policy()->policy_id);
+}
+
+static int test_thd(unsigned sid, const char* src, long now)
+{
+    SfIp sip, dip;
+    sip.set(src);
+    dip.set(IP4_DST);
+
+    return sfthd_test_threshold(
+        pThdObjs, pThd, 100, sid, &sip, &dip, now, get_network_policy()->policy_id);
+}
+
+TEST_CASE("sfthd node order", "[sfthd]")
+{
+    SnortConfig sc;
+    set_default_policy(&sc);
+    pThdObjs = sfthd_objs_new();
+    pThd = sfthd_new(MEM_DEFAULT, MEM_DEFAULT);
+
+    CHECK(add_thd(200, THD_TYPE_LIMIT, 10, IP_ANY) == 0);
+    CHECK(add_thd(200, THD_TYPE_SUPPRESS, 0, IP4_SRC) == 0);
+    CHECK(add_thd(200, THD_TYPE_SUPPRESS, 0, IP4_DST) == 0);
+    CHECK(add_thd(200, THD_TYPE_THRESHOLD, 20, IP_ANY) == THD_TOO_MANY_THDOBJ);
+
+    tThdItemKey key = { get_network_policy()->policy_id, 200 };
+    THD_ITEM* item = (THD_ITEM*)pThdObjs->sfthd_array[100]->find(&key);
+    REQUIRE(item);
+
+    // suppressions go first in the order added and the limit stays at the tail
+    auto& nodes = item->sfthd_node_list;
+    REQUIRE(nodes.size() == 3);
+
+    CHECK(nodes[0]->type == THD_TYPE_SUPPRESS);
+    CHECK(nodes[1]->type == THD_TYPE_SUPPRESS);
+    CHECK(nodes[2]->type == THD_TYPE_LIMIT);
+
+    CHECK(nodes[0]->thd_id < nodes[1]->thd_id);
+    CHECK(nodes[0]->priority == THD_PRIORITY_SUPPRESS);
+    CHECK(nodes[2]->priority == 10);
+
+    // lower priority limits go after higher ones
+    CHECK(add_thd(201, THD_TYPE_SUPPRESS, 0, IP4_SRC) == 0);
+    CHECK(add_thd(201, THD_TYPE_LIMIT, 10, IP_ANY) == 0);
+
+    key.sig_id = 201;
+    item = (THD_ITEM*)pThdObjs->sfthd_array[100]->find(&key);
+    REQUIRE(item);
+    REQUIRE(item->sfthd_node_list.size() == 2);
+    CHECK(item->sfthd_node_list.front()->type == THD_TYPE_SUPPRESS);
+    CHECK(item->sfthd_node_list.back()->type == THD_TYPE_LIMIT);
+
+    // the walk reaches every suppression before the limit
+    CHECK(test_thd(200, IP4_SRC, 1) == LOG_SU);
+    CHECK(test_thd(200, IP4_DST, 1) == LOG_SU);
+    CHECK(test_thd(200, IP4_EXT, 1) == LOG_OK);
+    CHECK(test_thd(200, IP4_EXT, 2) == LOG_NO);
+
+    Term();
+}
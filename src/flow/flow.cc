@@ -38,9 +38,11 @@
 
 using namespace snort;
 
+static const unsigned s_mem_tag = memory::MemoryCap::register_tag("flow");
+
 Flow::Flow()
 {
-    memory::MemoryCap::update_allocations(sizeof(*this) + sizeof(FlowStash));
+    memory::MemoryCap::update_allocations(sizeof(*this) + sizeof(FlowStash), s_mem_tag);
     constexpr size_t offset = offsetof(Flow, key);
     // FIXIT-L need a struct to zero here to make future proof
     memset((uint8_t*)this+offset, 0, sizeof(*this)-offset);
@@ -48,7 +50,7 @@ Flow::Flow()
 
 Flow::~Flow()
 {
-    memory::MemoryCap::update_deallocations(sizeof(*this) + sizeof(FlowStash));
+    memory::MemoryCap::update_deallocations(sizeof(*this) + sizeof(FlowStash), s_mem_tag);
     term();
 }
 
@@ -344,6 +346,16 @@ void Flow::free_flow_data()
     }
 }
 
+size_t Flow::get_flow_data_memory() const
+{
+    size_t n = 0;
+
+    for ( FlowData* fd = flow_data; fd; fd = fd->next )
+        n += fd->size_of() + fd->get_mem_in_use();
+
+    return n;
+}
+
 void Flow::call_handlers(Packet* p, bool eof)
 {
     FlowData* fd = flow_data;
@@ -185,6 +185,9 @@ public:
     void free_flow_data(FlowData*);
     void free_flow_data();
 
+    // fixed size plus tracked supplemental allocations of all flow data
+    size_t get_flow_data_memory() const;
+
     void call_handlers(Packet* p, bool eof = false);
     void markup_packet_flags(Packet*);
     void set_client_initiate(Packet*);
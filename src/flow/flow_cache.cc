@@ -24,6 +24,8 @@
 
 #include "flow/flow_cache.h"
 
+#include <algorithm>
+
 #include "detection/detection_engine.h"
 #include "hash/hash_defs.h"
 #include "hash/zhash.h"
@@ -41,8 +43,17 @@
 #include "ha.h"
 #include "session.h"
 
+#ifdef UNIT_TEST
+#include <random>
+
+#include "catch/snort_bench.h"
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
+static const unsigned s_mem_tag = memory::MemoryCap::register_tag("flow");
+
 #define SESSION_CACHE_FLAG_PURGING  0x01
 
 static const unsigned ALLOWED_FLOWS_ONLY = 1;
@@ -90,6 +101,37 @@ unsigned FlowCache::get_count()
     return hash_table ? hash_table->get_num_nodes() : 0;
 }
 
+void FlowCache::get_top_memory_flows(std::vector<std::pair<size_t, Flow*>>& top, unsigned max)
+{
+    top.clear();
+
+    if ( !max )
+        return;
+
+    auto by_size = [](const std::pair<size_t, Flow*>& a, const std::pair<size_t, Flow*>& b)
+    { return a.first > b.first; };
+
+    // keep a min heap of the largest max flows seen so far
+    for ( auto flow = static_cast<Flow*>(hash_table->lru_first()); flow;
+        flow = static_cast<Flow*>(hash_table->lru_next()) )
+    {
+        size_t n = flow->get_flow_data_memory();
+
+        if ( top.size() < max )
+        {
+            top.emplace_back(n, flow);
+            std::push_heap(top.begin(), top.end(), by_size);
+        }
+        else if ( n > top.front().first )
+        {
+            std::pop_heap(top.begin(), top.end(), by_size);
+            top.back() = { n, flow };
+            std::push_heap(top.begin(), top.end(), by_size);
+        }
+    }
+    std::sort_heap(top.begin(), top.end(), by_size);
+}
+
 Flow* FlowCache::find(const FlowKey* key)
 {
     Flow* flow = (Flow*)hash_table->get_user_data(key);
@@ -133,7 +175,7 @@ Flow* FlowCache::allocate(const FlowKey* key)
         {
             Flow* new_flow = new Flow();
             push(new_flow);
-            memory::MemoryCap::update_allocations(sizeof(HashNode) + sizeof(FlowKey));
+            memory::MemoryCap::update_allocations(sizeof(HashNode) + sizeof(FlowKey), s_mem_tag);
         }
         else if ( !prune_stale(timestamp, nullptr) )
         {
@@ -154,7 +196,8 @@ Flow* FlowCache::allocate(const FlowKey* key)
     if ( flow->session && flow->pkt_type != key->pkt_type )
         flow->term();
 
-    memory::MemoryCap::update_allocations(config.proto[to_utype(key->pkt_type)].cap_weight);
+    memory::MemoryCap::update_allocations(
+        config.proto[to_utype(key->pkt_type)].cap_weight, s_mem_tag);
     flow->last_data_seen = timestamp;
 
     return flow;
@@ -169,7 +212,8 @@ void FlowCache::remove(Flow* flow)
     // and Flow::retire try remove the flow from hash. Flow::reset should
     // just mark the flow as pending instead of trying to remove it.
     if ( !hash_table->release_node(flow->key) )
-        memory::MemoryCap::update_deallocations(config.proto[to_utype(flow->key->pkt_type)].cap_weight);
+        memory::MemoryCap::update_deallocations(
+            config.proto[to_utype(flow->key->pkt_type)].cap_weight, s_mem_tag);
 }
 
 bool FlowCache::release(Flow* flow, PruneReason reason, bool do_cleanup)
@@ -430,7 +474,7 @@ unsigned FlowCache::delete_active_flows(unsigned mode, unsigned num_to_delete, u
         //The flow should not be removed from the hash before reset
         hash_table->remove();
         delete flow;
-        memory::MemoryCap::update_deallocations(sizeof(HashNode) + sizeof(FlowKey));
+        memory::MemoryCap::update_deallocations(sizeof(HashNode) + sizeof(FlowKey), s_mem_tag);
         --flows_allocated;
         ++deleted;
         --num_to_delete;
@@ -457,7 +501,7 @@ unsigned FlowCache::delete_flows(unsigned num_to_delete)
 
             delete flow;
             delete_stats.update(FlowDeleteState::FREELIST);
-            memory::MemoryCap::update_deallocations(sizeof(HashNode) + sizeof(FlowKey));
+            memory::MemoryCap::update_deallocations(sizeof(HashNode) + sizeof(FlowKey), s_mem_tag);
 
             --flows_allocated;
             ++deleted;
@@ -492,7 +536,7 @@ unsigned FlowCache::purge()
     while ( Flow* flow = (Flow*)hash_table->pop() )
     {
         delete flow;
-        memory::MemoryCap::update_deallocations(sizeof(HashNode) + sizeof(FlowKey));
+        memory::MemoryCap::update_deallocations(sizeof(HashNode) + sizeof(FlowKey), s_mem_tag);
         --flows_allocated;
     }
 
@@ -501,3 +545,82 @@ unsigned FlowCache::purge()
 
     return retired;
 }
+
+#ifdef UNIT_TEST
+//-------------------------------------------------------------------------
+// benchmark
+//-------------------------------------------------------------------------
+
+// the find / allocate / prune path of the flow cache with a skewed mix of
+// hot flows and new flows.  the flows never see a reply so a full cache
+// makes room by pruning the oldest uni flow.
+TEST_CASE("flow cache find and allocate", "[.bench][flow_cache]")
+{
+    const unsigned max_flows = 65536;
+    const unsigned num_keys = 8 * max_flows;
+
+    std::mt19937 gen(1);
+    std::vector<FlowKey> keys(num_keys);
+
+    for ( unsigned i = 0; i < num_keys; ++i )
+    {
+        FlowKey& key = keys[i];
+        memset(&key, 0, sizeof(key));
+
+        key.ip_l[2] = key.ip_h[2] = htonl(0xffff);
+        key.ip_l[3] = htonl(0x0a000000 | (gen() & 0xffffff));
+        key.ip_h[3] = htonl(0xc0a80000 | (i & 0xffff));
+        key.port_l = 1024 + gen() % 60000;
+        key.port_h = 80;
+        key.ip_protocol = 6;
+        key.pkt_type = PktType::TCP;
+        key.version = 4;
+    }
+
+    // 7 of 8 packets belong to the hot half of the table
+    std::vector<unsigned> order(512 * 1024);
+
+    for ( auto& k : order )
+        k = (gen() % 8) ? gen() % (max_flows / 2) : gen() % num_keys;
+
+    // pruning suspends the tracer
+    PacketTracer::thread_init();
+
+    FlowCacheConfig fcg;
+    fcg.max_flows = max_flows;
+    FlowCache cache(fcg);
+
+    for ( unsigned i = 0; i < max_flows; ++i )
+        cache.allocate(&keys[i]);
+
+    unsigned misses = 0;
+
+    Benchmark bench("flow_cache.find_allocate", order.size(), "pkts");
+    bench.add_field("max_flows", max_flows);
+
+    bench.run([&]()
+    {
+        misses = 0;
+
+        for ( auto k : order )
+        {
+            const FlowKey* key = &keys[k];
+
+            if ( cache.find(key) )
+                continue;
+
+            ++misses;
+            cache.allocate(key);
+        }
+    });
+
+    CHECK(misses > 0);
+    CHECK(misses < order.size() / 2);
+    CHECK(cache.get_count() <= max_flows);
+
+    cache.purge();
+    CHECK(cache.get_flows_allocated() == 0);
+
+    PacketTracer::thread_term();
+}
+#endif
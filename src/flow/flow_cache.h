@@ -27,6 +27,8 @@
 
 #include <ctime>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "framework/counts.h"
 
@@ -64,6 +66,9 @@ public:
     unsigned purge();
     unsigned get_count();
 
+    // walks the entire cache; for diagnostics only
+    void get_top_memory_flows(std::vector<std::pair<size_t, snort::Flow*>>&, unsigned max);
+
     unsigned get_max_flows() const
     { return config.max_flows; }
 
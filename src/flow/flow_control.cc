@@ -118,6 +118,9 @@ unsigned FlowControl::delete_flows(unsigned num_to_delete)
 bool FlowControl::prune_one(PruneReason reason, bool do_cleanup)
 { return cache->prune_one(reason, do_cleanup); }
 
+void FlowControl::get_top_memory_flows(std::vector<std::pair<size_t, Flow*>>& top, unsigned max)
+{ cache->get_top_memory_flows(top, max); }
+
 void FlowControl::timeout_flows(time_t cur_time)
 {
     cache->timeout(1, cur_time);
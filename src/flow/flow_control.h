@@ -26,6 +26,7 @@
 // processed.  flows are pruned as needed to process new flows.
 
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "flow/flow_config.h"
@@ -66,6 +67,7 @@ public:
     void purge_flows();
     unsigned delete_flows(unsigned num_to_delete);
     bool prune_one(PruneReason, bool do_cleanup);
+    void get_top_memory_flows(std::vector<std::pair<size_t, snort::Flow*>>&, unsigned max);
     snort::Flow* stale_flow_cleanup(FlowCache*, snort::Flow*, snort::Packet*);
     void timeout_flows(time_t cur_time);
     void check_expected_flow(snort::Flow*, snort::Packet*);
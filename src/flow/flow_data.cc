@@ -55,7 +55,7 @@ FlowData::~FlowData()
 
 void FlowData::update_allocations(size_t n)
 {
-    memory::MemoryCap::update_allocations(n);
+    memory::MemoryCap::update_allocations(n, mem_tag);
 
     if (n > 0)
     {
@@ -66,7 +66,7 @@ void FlowData::update_allocations(size_t n)
 
 void FlowData::update_deallocations(size_t n)
 {
-    memory::MemoryCap::update_deallocations(n);
+    memory::MemoryCap::update_deallocations(n, mem_tag);
 
     if (n > 0)
     {
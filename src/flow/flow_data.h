@@ -46,6 +46,12 @@ public:
     void update_deallocations(size_t);
     Inspector* get_handler() { return handler; }
 
+    size_t get_mem_in_use() const
+    { return mem_in_use; }
+
+    unsigned get_memory_tag() const
+    { return mem_tag; }
+
     // return fixed size (could be an approx avg)
     // this must be fixed for life of flow data instance
     // track significant supplemental allocations with the above updaters
@@ -55,6 +61,12 @@ public:
     virtual void handle_retransmit(Packet*) { }
     virtual void handle_eof(Packet*) { }
 
+protected:
+    // attribute this flow data's memory to a MemoryCap tag
+    // must be set before the flow data is attached to a flow
+    void set_memory_tag(unsigned tag)
+    { mem_tag = tag; }
+
 public:  // FIXIT-L privatize
     FlowData* next;
     FlowData* prev;
@@ -64,6 +76,7 @@ private:
     Inspector* handler;
     size_t mem_in_use = 0;
     unsigned net_allocation_calls = 0;
+    unsigned mem_tag = 0;
     unsigned id;
 };
 
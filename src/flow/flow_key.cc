@@ -455,40 +455,19 @@ bool FlowKey::is_equal(const void* s1, const void* s2, size_t)
 
 unsigned FlowHashKeyOps::do_hash(const unsigned char* k, int)
 {
-    uint32_t a, b, c;
-    a = b = c = hardener;
+    // FlowKey is a fixed 52 bytes so the block loop is unrolled:
+    // ip_l, ip_h, mpls + ports, groups + asid + vlan, then the tail
+    // word with ip_proto, pkt_type, version and flags
+    static_assert(sizeof(FlowKey) == 52, "unrolled hash must cover the whole key");
 
-    const uint32_t* d = (const uint32_t*)k;
+    uint64_t s = get_key_seed() ^ hash_p0;
 
-    a += d[0];   // IPv6 lo[0]
-    b += d[1];   // IPv6 lo[1]
-    c += d[2];   // IPv6 lo[2]
+    s = hash_mum(hash_read64(k) ^ hash_p1, hash_read64(k + 8) ^ s);
+    s = hash_mum(hash_read64(k + 16) ^ hash_p1, hash_read64(k + 24) ^ s);
+    s = hash_mum(hash_read64(k + 32) ^ hash_p1, hash_read64(k + 40) ^ s);
 
-    mix(a, b, c);
-
-    a += d[3];   // IPv6 lo[3]
-    b += d[4];   // IPv6 hi[0]
-    c += d[5];   // IPv6 hi[1]
-
-    mix(a, b, c);
-
-    a += d[6];   // IPv6 hi[2]
-    b += d[7];   // IPv6 hi[3]
-    c += d[8];   // mpls label
-
-    mix(a, b, c);
-
-    a += d[9];   // port lo & port hi
-    b += d[10];  // group lo & group hi
-    c += d[11];  // addressSpaceId, vlan
-
-    mix(a, b, c);
-
-    a += d[12];  // ip_proto, pkt_type, version, 8 bits of zeroed pad
-
-    finalize(a, b, c);
-
-    return c;
+    return hash_fold(hash_mum(hash_p1 ^ sizeof(FlowKey),
+        hash_mum(hash_read32(k + 48) ^ hash_p1, s)));
 }
 
 bool FlowHashKeyOps::key_compare(const void* k1, const void* k2, size_t len)
@@ -24,6 +24,9 @@
 // the subclasses do the actual work of tracking, reassembly, etc.
 
 #include <cassert>
+#include <vector>
+
+#include "framework/counts.h"
 #include "stream/stream.h"
 
 namespace snort
@@ -87,6 +90,48 @@ public:
     snort::Flow* flow;  // FIXIT-L use reference?
 };
 
+// Free list of one Session subclass for a packet thread.  The flow cache
+// keeps a flow's session when the flow is reused for the same protocol and
+// deletes it when the protocol changes; subclasses route operator new and
+// delete here so that churn doesn't go to the heap.
+class SessionPool
+{
+public:
+    SessionPool(unsigned cap) : max(cap) { }
+
+    ~SessionPool()
+    {
+        for ( auto* p : nodes )
+            ::operator delete(p);
+    }
+
+    void* get(size_t n, PegCount& reused)
+    {
+        if ( nodes.empty() )
+            return ::operator new(n);
+
+        void* p = nodes.back();
+        nodes.pop_back();
+        reused++;
+        return p;
+    }
+
+    void put(void* p)
+    {
+        if ( nodes.size() < max )
+            nodes.emplace_back(p);
+        else
+            ::operator delete(p);
+    }
+
+    size_t size() const
+    { return nodes.size(); }
+
+private:
+    std::vector<void*> nodes;
+    unsigned max;
+};
+
 /* These should be tracked by all Session subclasses. Add to top of peg list.
  * Having these predefined stats improves consistency and provides convenience.
  */
@@ -62,6 +62,8 @@ void PacketTracer::dump_to_daq(Packet*) { }
 void PacketTracer::reset(bool) { }
 void PacketTracer::pause() { }
 void PacketTracer::unpause() { }
+void PacketTracer::thread_init() { }
+void PacketTracer::thread_term() { }
 void Active::set_drop_reason(char const*) { }
 Packet::Packet(bool) { }
 Packet::~Packet() = default;
@@ -75,6 +77,7 @@ void Flow::term() { }
 void Flow::flush(bool) { }
 void Flow::reset(bool) { }
 void Flow::free_flow_data() { }
+size_t Flow::get_flow_data_memory() const { return 0; }
 void set_network_policy(const SnortConfig*, unsigned) { }
 void DataBus::publish(const char*, const uint8_t*, unsigned, Flow*) { }
 void DataBus::publish(const char*, Packet*, Flow*) { }
@@ -95,8 +98,9 @@ bool HighAvailabilityManager::in_standby(Flow*) { return true; }
 SfIpRet SfIp::set(void const*, int) { return SFIP_SUCCESS; }
 namespace memory
 {
-void MemoryCap::update_allocations(size_t) { }
-void MemoryCap::update_deallocations(size_t) { }
+unsigned MemoryCap::register_tag(const char*) { return 0; }
+void MemoryCap::update_allocations(size_t, unsigned) { }
+void MemoryCap::update_deallocations(size_t, unsigned) { }
 bool MemoryCap::over_threshold() { return true; }
 }
 
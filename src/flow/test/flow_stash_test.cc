@@ -33,8 +33,8 @@ using namespace std;
 
 static DataBus* DB = nullptr;
 
-void memory::MemoryCap::update_allocations(size_t) { }
-void memory::MemoryCap::update_deallocations(size_t) { }
+void memory::MemoryCap::update_allocations(size_t, unsigned) { }
+void memory::MemoryCap::update_deallocations(size_t, unsigned) { }
 
 class TestStashObject : public StashGenericObject
 {
@@ -47,9 +47,10 @@ void Inspector::rem_ref() {}
 
 void Inspector::add_ref() {}
 
-void memory::MemoryCap::update_allocations(size_t) {}
+unsigned memory::MemoryCap::register_tag(const char*) { return 0; }
+void memory::MemoryCap::update_allocations(size_t, unsigned) {}
 
-void memory::MemoryCap::update_deallocations(size_t) {}
+void memory::MemoryCap::update_deallocations(size_t, unsigned) {}
 
 void memory::MemoryCap::free_space(size_t) { }
 
@@ -73,6 +73,27 @@ TEST(session_test, seesion_class_test)
     delete ssn;
 }
 
+TEST(session_test, session_pool)
+{
+    PegCount reused = 0;
+    SessionPool pool(1);
+
+    void* a = pool.get(sizeof(DummySession), reused);
+    void* b = pool.get(sizeof(DummySession), reused);
+    CHECK(0 == reused);
+
+    // over the cap goes back to the heap
+    pool.put(a);
+    pool.put(b);
+    CHECK(1 == pool.size());
+
+    CHECK(a == pool.get(sizeof(DummySession), reused));
+    CHECK(1 == reused);
+    CHECK(0 == pool.size());
+
+    pool.put(a);
+}
+
 int main(int argc, char** argv)
 {
     return CommandLineTestRunner::RunAllTests(argc, argv);
@@ -0,0 +1,223 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// concurrent_xhash.h
+
+#ifndef CONCURRENT_XHASH_H
+#define CONCURRENT_XHASH_H
+
+// XHash shared across packet threads.  Keys are spread over a power of 2
+// number of independent XHash stripes, each with its own mutex, so threads
+// only contend when they touch the same stripe.  LRU order, max nodes and
+// memcap are kept per stripe (the configured totals are divided evenly),
+// which approximates a single LRU without a global lock.  Totals are summed
+// from the stripes on demand.
+
+#include <limits>
+#include <mutex>
+
+#include "hash/hash_key_operations.h"
+#include "hash/xhash.h"
+
+namespace snort
+{
+template<typename Stripe = XHash>
+class ConcurrentXHash
+{
+public:
+    static constexpr unsigned default_stripes = 16;
+
+    // largest power of 2 up to default_stripes that still leaves each
+    // stripe at least min_per_stripe of max_nodes (0 == no limit)
+    static unsigned get_stripes(uint64_t max_nodes, uint64_t min_per_stripe)
+    {
+        unsigned n = default_stripes;
+
+        if ( !max_nodes or !min_per_stripe )
+            return n;
+
+        while ( n > 1 and max_nodes / n < min_per_stripe )
+            n >>= 1;
+
+        return n;
+    }
+
+    // rows and memcap are totals; args are passed on to each Stripe after
+    // its share of rows, keysize
+    template<typename... Args>
+    ConcurrentXHash(unsigned stripes, int rows, int keysize, Args&&... args)
+        : selector(rows > 0 ? rows : 1), keysize(keysize)
+    {
+        num_stripes = hash_nearest_power_of_2(stripes ? stripes : default_stripes);
+        int stripe_rows = rows / (int)num_stripes;
+
+        if ( stripe_rows < 1 )
+            stripe_rows = 1;
+
+        stripe = new Slot[num_stripes];
+
+        for ( unsigned i = 0; i < num_stripes; i++ )
+            stripe[i].table = new Stripe(stripe_rows, keysize, args...);
+    }
+
+    ~ConcurrentXHash()
+    {
+        for ( unsigned i = 0; i < num_stripes; i++ )
+            delete stripe[i].table;
+
+        delete[] stripe;
+    }
+
+    ConcurrentXHash(const ConcurrentXHash&) = delete;
+    ConcurrentXHash& operator=(const ConcurrentXHash&) = delete;
+
+    // exclusive access to the stripe owning key; anything obtained from
+    // the returned table is only valid while the lock is held
+    Stripe* lock(const void* key, std::unique_lock<std::mutex>& guard)
+    {
+        Slot& s = get_slot(key);
+        guard = std::unique_lock<std::mutex>(s.mutex);
+        return s.table;
+    }
+
+    int insert(const void* key, void* data)
+    {
+        Slot& s = get_slot(key);
+        std::lock_guard<std::mutex> guard(s.mutex);
+        return s.table->insert(key, data);
+    }
+
+    int release_node(const void* key)
+    {
+        Slot& s = get_slot(key);
+        std::lock_guard<std::mutex> guard(s.mutex);
+        return s.table->release_node(key);
+    }
+
+    // copy out the user data for key; returns false if not found
+    bool get_user_data(const void* key, void* data, size_t len)
+    {
+        Slot& s = get_slot(key);
+        std::lock_guard<std::mutex> guard(s.mutex);
+        void* p = s.table->get_user_data(key);
+
+        if ( !p )
+            return false;
+
+        memcpy(data, p, len);
+        return true;
+    }
+
+    void clear_hash()
+    {
+        for ( unsigned i = 0; i < num_stripes; i++ )
+        {
+            std::lock_guard<std::mutex> guard(stripe[i].mutex);
+            stripe[i].table->clear_hash();
+        }
+    }
+
+    // 0 == no limit; each stripe gets at least min_per_stripe so a small
+    // cap can't starve a stripe below what its users need to make progress
+    void set_max_nodes(uint64_t max, uint64_t min_per_stripe = 0)
+    {
+        uint64_t per = max ? (max - 1) / num_stripes + 1 : 0;
+
+        if ( per and per < min_per_stripe )
+            per = min_per_stripe;
+
+        if ( per > (uint64_t)std::numeric_limits<int>::max() )
+            per = std::numeric_limits<int>::max();
+
+        for ( unsigned i = 0; i < num_stripes; i++ )
+        {
+            std::lock_guard<std::mutex> guard(stripe[i].mutex);
+            stripe[i].table->set_max_nodes((int)per);
+        }
+    }
+
+    void set_memcap(unsigned long memcap)
+    {
+        for ( unsigned i = 0; i < num_stripes; i++ )
+        {
+            std::lock_guard<std::mutex> guard(stripe[i].mutex);
+            stripe[i].table->set_memcap(memcap / num_stripes);
+        }
+    }
+
+    unsigned get_num_nodes()
+    {
+        unsigned n = 0;
+
+        for ( unsigned i = 0; i < num_stripes; i++ )
+        {
+            std::lock_guard<std::mutex> guard(stripe[i].mutex);
+            n += stripe[i].table->get_num_nodes();
+        }
+        return n;
+    }
+
+    unsigned long get_mem_used()
+    {
+        unsigned long n = 0;
+
+        for ( unsigned i = 0; i < num_stripes; i++ )
+        {
+            std::lock_guard<std::mutex> guard(stripe[i].mutex);
+            n += stripe[i].table->get_mem_used();
+        }
+        return n;
+    }
+
+    unsigned get_num_stripes() const
+    { return num_stripes; }
+
+private:
+    // stripe selection gets its own seed, random per table unless
+    // static_hash is configured, so keys can't be aimed at one stripe
+    class StripeSelector : public HashKeyOperations
+    {
+    public:
+        StripeSelector(int rows) : HashKeyOperations(rows) { }
+
+        uint64_t hash(const void* key, size_t len) const
+        { return hash_bytes((const uint8_t*)key, len, get_key_seed()); }
+    };
+
+    // one cache line per stripe so that uncontended stripes don't share
+    struct alignas(64) Slot
+    {
+        std::mutex mutex;
+        Stripe* table = nullptr;
+    };
+
+    Slot& get_slot(const void* key)
+    {
+        // use the high half so stripe selection is independent of the
+        // row index each stripe derives from its own seeded hash
+        uint64_t h = selector.hash(key, keysize);
+        return stripe[(h >> 32) & (num_stripes - 1)];
+    }
+
+    StripeSelector selector;
+    Slot* stripe;
+    unsigned num_stripes;
+    unsigned keysize;
+};
+}
+#endif
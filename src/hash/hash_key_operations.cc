@@ -58,14 +58,7 @@ HashKeyOperations::HashKeyOperations(int rows)
 
 unsigned HashKeyOperations::do_hash(const unsigned char* key, int len)
 {
-    unsigned hash = seed;
-    while ( len )
-    {
-        hash *= scale;
-        hash += *key++;
-        len--;
-    }
-    return hash ^ hardener;
+    return hash_fold(hash_bytes(key, len, get_key_seed()));
 }
 
 bool HashKeyOperations::key_compare(const void* key1, const void* key2, size_t len)
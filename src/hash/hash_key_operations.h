@@ -20,6 +20,8 @@
 #ifndef HASH_KEY_OPERATIONS_H
 #define HASH_KEY_OPERATIONS_H
 
+#include <cstring>
+
 #include "main/snort_types.h"
 
 namespace
@@ -76,6 +78,88 @@ static inline uint64_t hash_mac(const uint8_t* a)
     return hash;
 }
 
+// word at a time hashing built on a folded 64x64->128 bit multiply
+// (wyhash style); the seed is randomized per table unless static_hash
+// is set so that bucket placement can't be predicted from the wire
+static constexpr uint64_t hash_p0 = 0xa0761d6478bd642full;
+static constexpr uint64_t hash_p1 = 0xe7037ed1a0b428dbull;
+
+static inline uint64_t hash_mum(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+    uint64_t ha = a >> 32, la = (uint32_t)a, hb = b >> 32, lb = (uint32_t)b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    return lo ^ hi;
+#endif
+}
+
+static inline uint64_t hash_read64(const uint8_t* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hash_read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline unsigned hash_fold(uint64_t h)
+{ return (unsigned)(h ^ (h >> 32)); }
+
+// fixed size keys: 16 bytes covers an SfIp / ip6 address
+static inline uint64_t hash_16(uint64_t a, uint64_t b, uint64_t seed)
+{ return hash_mum(hash_p1 ^ 16, hash_mum(a ^ hash_p1, b ^ seed ^ hash_p0)); }
+
+static inline uint64_t hash_bytes(const uint8_t* p, size_t len, uint64_t seed)
+{
+    uint64_t a, b;
+    seed ^= hash_p0;
+
+    if ( len <= 16 )
+    {
+        if ( len >= 4 )
+        {
+            size_t off = (len >> 3) << 2;
+            a = (hash_read32(p) << 32) | hash_read32(p + off);
+            b = (hash_read32(p + len - 4) << 32) | hash_read32(p + len - 4 - off);
+        }
+        else if ( len > 0 )
+        {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else
+    {
+        size_t i = len;
+
+        while ( i > 16 )
+        {
+            seed = hash_mum(hash_read64(p) ^ hash_p1, hash_read64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        // the last 16 bytes may overlap the final block
+        a = hash_read64(p + i - 16);
+        b = hash_read64(p + i - 8);
+    }
+    return hash_mum(hash_p1 ^ len, hash_mum(a ^ hash_p1, b ^ seed));
+}
+
 class HashKeyOperations
 {
 public:
@@ -86,6 +170,9 @@ public:
     virtual bool key_compare(const void* key1, const void* key2, size_t len);
 
 protected:
+    uint64_t get_key_seed() const
+    { return ((uint64_t)hardener << 32) ^ ((uint64_t)scale << 16) ^ seed; }
+
     unsigned seed;
     unsigned scale;
     unsigned hardener;
@@ -0,0 +1,244 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// concurrent_xhash_test.cc
+// unit and multithreaded stress tests for the striped xhash
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hash/concurrent_xhash.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "hash/hash_defs.h"
+#include "main/snort_config.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+// Stubs whose sole purpose is to make the test code link
+static SnortConfig my_config;
+THREAD_LOCAL SnortConfig* snort_conf = &my_config;
+
+SnortConfig::SnortConfig(const SnortConfig* const)
+{ snort_conf->run_flags = 0;}
+
+SnortConfig::~SnortConfig() = default;
+
+const SnortConfig* SnortConfig::get_conf()
+{ return snort_conf; }
+
+struct TestKey
+{
+    unsigned thread;
+    unsigned index;
+};
+
+TEST_GROUP(concurrent_xhash)
+{ };
+
+TEST(concurrent_xhash, insert_find_release)
+{
+    ConcurrentXHash<> cx(4, 64, sizeof(TestKey), sizeof(unsigned), 0);
+    CHECK(cx.get_num_stripes() == 4);
+
+    for ( unsigned i = 0; i < 100; i++ )
+    {
+        TestKey k = { 0, i };
+        unsigned v = i * 3;
+        CHECK(cx.insert(&k, &v) == HASH_OK);
+    }
+    CHECK(cx.get_num_nodes() == 100);
+
+    TestKey k = { 0, 42 };
+    unsigned v = 0;
+    CHECK(cx.get_user_data(&k, &v, sizeof(v)));
+    CHECK(v == 126);
+
+    {
+        std::unique_lock<std::mutex> lock;
+        XHash* t = cx.lock(&k, lock);
+        CHECK(t->find_node(&k) != nullptr);
+    }
+
+    CHECK(cx.release_node(&k) == HASH_OK);
+    CHECK(!cx.get_user_data(&k, &v, sizeof(v)));
+    CHECK(cx.get_num_nodes() == 99);
+
+    cx.clear_hash();
+    CHECK(cx.get_num_nodes() == 0);
+}
+
+TEST(concurrent_xhash, max_nodes_split)
+{
+    ConcurrentXHash<> cx(2, 64, sizeof(TestKey), sizeof(unsigned), 0);
+    cx.set_max_nodes(10);
+
+    // each stripe recycles its own lru once past its share
+    for ( unsigned i = 0; i < 1000; i++ )
+    {
+        TestKey k = { 0, i };
+        unsigned v = i;
+        cx.insert(&k, &v);
+    }
+    CHECK(cx.get_num_nodes() <= 10);
+}
+
+TEST(concurrent_xhash, stripes_for_small_caps)
+{
+    using CX = ConcurrentXHash<>;
+
+    CHECK(CX::get_stripes(0, 9) == CX::default_stripes);
+    CHECK(CX::get_stripes(1000, 0) == CX::default_stripes);
+    CHECK(CX::get_stripes(16 * 9, 9) == CX::default_stripes);
+    CHECK(CX::get_stripes(16 * 9 - 1, 9) == 8);
+    CHECK(CX::get_stripes(20, 9) == 2);
+    CHECK(CX::get_stripes(9, 9) == 1);
+    CHECK(CX::get_stripes(5, 9) == 1);
+}
+
+TEST(concurrent_xhash, max_nodes_min_per_stripe)
+{
+    ConcurrentXHash<> cx(4, 64, sizeof(TestKey), sizeof(unsigned), 0);
+
+    // a cap of 4 over 4 stripes would leave 1 per stripe; the minimum
+    // keeps 3 live in each
+    cx.set_max_nodes(4, 3);
+
+    for ( unsigned i = 0; i < 1000; i++ )
+    {
+        TestKey k = { 0, i };
+        unsigned v = i;
+        cx.insert(&k, &v);
+    }
+    CHECK(cx.get_num_nodes() == 12);
+}
+
+TEST(concurrent_xhash, max_nodes_64_bit)
+{
+    using CX = ConcurrentXHash<>;
+    const uint64_t big = (1ull << 32) + 4;
+
+    CHECK(CX::get_stripes(big, 9) == CX::default_stripes);
+
+    // would be a cap of 4 if truncated to 32 bits
+    CX cx(4, 64, sizeof(TestKey), sizeof(unsigned), 0);
+    cx.set_max_nodes(big);
+
+    for ( unsigned i = 0; i < 100; i++ )
+    {
+        TestKey k = { 0, i };
+        unsigned v = i;
+        cx.insert(&k, &v);
+    }
+    CHECK(cx.get_num_nodes() == 100);
+}
+
+// for each key, the first key that went to the same stripe
+static std::vector<unsigned> get_stripe_map(ConcurrentXHash<>& cx, unsigned num_keys)
+{
+    std::vector<XHash*> tables;
+    std::vector<unsigned> map;
+
+    for ( unsigned i = 0; i < num_keys; i++ )
+    {
+        TestKey k = { 0, i };
+        std::unique_lock<std::mutex> lock;
+        tables.emplace_back(cx.lock(&k, lock));
+
+        unsigned j = 0;
+        while ( tables[j] != tables[i] )
+            j++;
+
+        map.emplace_back(j);
+    }
+    return map;
+}
+
+TEST(concurrent_xhash, stripe_seed)
+{
+    const unsigned num_keys = 256;
+
+    {
+        ConcurrentXHash<> a(16, 64, sizeof(TestKey), sizeof(unsigned), 0);
+        ConcurrentXHash<> b(16, 64, sizeof(TestKey), sizeof(unsigned), 0);
+        CHECK(get_stripe_map(a, num_keys) != get_stripe_map(b, num_keys));
+    }
+
+    my_config.run_flags |= RUN_FLAG__STATIC_HASH;
+    {
+        ConcurrentXHash<> a(16, 64, sizeof(TestKey), sizeof(unsigned), 0);
+        ConcurrentXHash<> b(16, 64, sizeof(TestKey), sizeof(unsigned), 0);
+        CHECK(get_stripe_map(a, num_keys) == get_stripe_map(b, num_keys));
+    }
+    my_config.run_flags &= ~RUN_FLAG__STATIC_HASH;
+}
+
+TEST(concurrent_xhash, threads_stress)
+{
+    const unsigned num_threads = 8;
+    const unsigned per_thread = 2000;
+
+    ConcurrentXHash<> cx(16, 1024, sizeof(TestKey), sizeof(unsigned), 0);
+    std::atomic<unsigned> misses{0};
+    std::vector<std::thread> threads;
+
+    for ( unsigned t = 0; t < num_threads; t++ )
+    {
+        threads.emplace_back([&cx, &misses, t]()
+        {
+            for ( unsigned i = 0; i < per_thread; i++ )
+            {
+                TestKey k = { t, i };
+                unsigned v = t * per_thread + i;
+                cx.insert(&k, &v);
+            }
+            for ( unsigned i = 0; i < per_thread; i++ )
+            {
+                TestKey k = { t, i };
+                unsigned v = 0;
+
+                if ( !cx.get_user_data(&k, &v, sizeof(v)) or v != t * per_thread + i )
+                    misses++;
+            }
+            // release the odd half
+            for ( unsigned i = 1; i < per_thread; i += 2 )
+            {
+                TestKey k = { t, i };
+                cx.release_node(&k);
+            }
+        });
+    }
+
+    for ( auto& th : threads )
+        th.join();
+
+    CHECK(misses == 0);
+    CHECK(cx.get_num_nodes() == num_threads * per_thread / 2);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
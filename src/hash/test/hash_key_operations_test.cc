@@ -0,0 +1,147 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// hash_key_operations_test.cc
+// unit tests for the key hash family
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "hash/hash_key_operations.h"
+
+#include <set>
+
+#include "main/snort_config.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+// Stubs whose sole purpose is to make the test code link
+static SnortConfig my_config;
+THREAD_LOCAL SnortConfig* snort_conf = &my_config;
+
+SnortConfig::SnortConfig(const SnortConfig* const)
+{ snort_conf->run_flags = 0;}
+
+SnortConfig::~SnortConfig() = default;
+
+const SnortConfig* SnortConfig::get_conf()
+{ return snort_conf; }
+
+TEST_GROUP(hash_key_operations)
+{
+    void teardown() override
+    { snort_conf->run_flags = 0; }
+};
+
+TEST(hash_key_operations, same_key_same_hash)
+{
+    HashKeyOperations hko(1024);
+    uint8_t key[64];
+
+    for ( unsigned i = 0; i < sizeof(key); i++ )
+        key[i] = (uint8_t)(i * 7 + 3);
+
+    for ( int len = 0; len <= (int)sizeof(key); len++ )
+        CHECK(hko.do_hash(key, len) == hko.do_hash(key, len));
+}
+
+TEST(hash_key_operations, static_hash_is_repeatable)
+{
+    snort_conf->run_flags |= RUN_FLAG__STATIC_HASH;
+
+    HashKeyOperations one(1024);
+    HashKeyOperations two(4096);
+    const uint8_t key[] = "static hash";
+
+    CHECK(one.do_hash(key, sizeof(key)) == two.do_hash(key, sizeof(key)));
+}
+
+TEST(hash_key_operations, every_length_differs)
+{
+    HashKeyOperations hko(1024);
+    uint8_t key[64] = { };
+    std::set<unsigned> seen;
+
+    // zero filled keys of different lengths must not collide
+    for ( int len = 0; len <= (int)sizeof(key); len++ )
+        CHECK(seen.insert(hko.do_hash(key, len)).second);
+}
+
+TEST(hash_key_operations, every_bit_matters)
+{
+    HashKeyOperations hko(1024);
+
+    for ( int len = 1; len <= 40; len++ )
+    {
+        uint8_t key[40] = { };
+        unsigned base = hko.do_hash(key, len);
+
+        for ( int bit = 0; bit < len * 8; bit++ )
+        {
+            key[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+            CHECK(hko.do_hash(key, len) != base);
+            key[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+        }
+    }
+}
+
+TEST(hash_key_operations, sequential_keys_spread)
+{
+    // flow tuples from a single client mostly differ in a few port bits;
+    // masked into a power of 2 table they should still spread evenly
+    HashKeyOperations hko(1024);
+    const unsigned rows = 1024;
+    const unsigned keys = rows * 8;
+    unsigned buckets[rows] = { };
+
+    for ( unsigned i = 0; i < keys; i++ )
+    {
+        uint32_t key[13] = { 0x0a000001, 0, 0, 0, 0x0a000002, 0, 0, 0, 0 };
+        key[9] = (80u << 16) | (uint16_t)(1024 + i);
+        key[12] = 6;
+        buckets[hko.do_hash((const unsigned char*)key, sizeof(key)) & (rows - 1)]++;
+    }
+
+    unsigned max = 0;
+
+    for ( unsigned b : buckets )
+        if ( b > max )
+            max = b;
+
+    // a uniform hash puts ~8 per bucket; allow generous slack
+    CHECK(max < 32);
+}
+
+TEST(hash_key_operations, fixed_16_matches_width)
+{
+    const uint64_t a = 0x0102030405060708ull;
+    const uint64_t b = 0x1112131415161718ull;
+
+    CHECK(hash_16(a, b, 0) == hash_16(a, b, 0));
+    CHECK(hash_16(a, b, 0) != hash_16(b, a, 0));
+    CHECK(hash_16(a, b, 0) != hash_16(a, b, 1));
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -0,0 +1,729 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// bpf_jit.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "bpf_jit.h"
+
+#include <pcap.h>
+#include <sys/mman.h>
+
+#include <cstring>
+
+#ifdef UNIT_TEST
+#include <random>
+
+#include "catch/snort_bench.h"
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+// older libpcap headers lack these although the interpreter may support them
+#ifndef BPF_MOD
+#define BPF_MOD 0x90
+#endif
+#ifndef BPF_XOR
+#define BPF_XOR 0xa0
+#endif
+
+//--------------------------------------------------------------------------
+// x86-64 code generation
+//
+// The generated function is a leaf taking (pkt, caplen, wirelen) per the
+// SysV ABI and uses only scratch registers:
+//
+//   rdi = packet    rsi = caplen (zero extended)    r10d = wirelen
+//   eax = A         ecx = X                         r8, r9 = temporaries
+//
+// Scratch memory M[] lives in the red zone below rsp.  Every failed bounds
+// check or division by zero branches to a shared exit returning 0, which is
+// what the interpreter does.  Classic BPF only jumps forward so each jump is
+// emitted as rel32 and patched once the target offsets are known.
+//--------------------------------------------------------------------------
+
+#if defined(__x86_64__)
+
+namespace
+{
+class Emitter
+{
+public:
+    Emitter(std::vector<uint8_t>& c) : code(c) { }
+
+    void byte(uint8_t b)
+    { code.emplace_back(b); }
+
+    void bytes(std::initializer_list<uint8_t> bl)
+    { code.insert(code.end(), bl); }
+
+    void imm32(uint32_t v)
+    {
+        for ( unsigned i = 0; i < 4; ++i )
+            byte((uint8_t)(v >> (8 * i)));
+    }
+
+    // target is an instruction index, or fail_target for the shared exit
+    void jump(uint8_t cc, unsigned target)
+    {
+        if ( cc )
+            bytes({ 0x0f, cc });
+        else
+            byte(0xe9);
+
+        fixups.emplace_back(code.size(), target);
+        imm32(0);
+    }
+
+    void jump(unsigned target)
+    { jump(0, target); }
+
+    size_t size() const
+    { return code.size(); }
+
+    void patch(const std::vector<size_t>& offsets, size_t fail)
+    {
+        for ( const auto& f : fixups )
+        {
+            size_t to = (f.second == fail_target) ? fail : offsets[f.second];
+            int32_t rel = (int32_t)(to - (f.first + 4));
+            memcpy(&code[f.first], &rel, sizeof(rel));
+        }
+    }
+
+    static const unsigned fail_target = ~0u;
+
+private:
+    std::vector<uint8_t>& code;
+    std::vector<std::pair<size_t, unsigned>> fixups;
+};
+}
+
+// condition codes for the second byte of jcc rel32
+#define JCC_JB  0x82
+#define JCC_JAE 0x83
+#define JCC_JE  0x84
+#define JCC_JNE 0x85
+#define JCC_JBE 0x86
+#define JCC_JA  0x87
+
+static uint8_t mem_disp(uint32_t k)
+{ return (uint8_t)(-64 + 4 * (int)k); }
+
+// check that size bytes at the absolute offset k are in the packet
+static void emit_abs_check(Emitter& e, uint32_t k, unsigned size)
+{
+    if ( (uint64_t)k + size > 0x7fffffff )
+    {
+        e.jump(Emitter::fail_target);
+        return;
+    }
+    e.bytes({ 0x81, 0xfe });                  // cmp esi, k + size
+    e.imm32(k + size);
+    e.jump(JCC_JB, Emitter::fail_target);
+}
+
+// r8 = X + k and check that size bytes there are in the packet
+static void emit_ind_check(Emitter& e, uint32_t k, unsigned size)
+{
+    e.bytes({ 0x41, 0x89, 0xc8 });            // mov r8d, ecx
+    e.bytes({ 0x41, 0xb9 });                  // mov r9d, k
+    e.imm32(k);
+    e.bytes({ 0x4d, 0x01, 0xc8 });            // add r8, r9
+    e.bytes({ 0x4d, 0x8d, 0x48, (uint8_t)size }); // lea r9, [r8 + size]
+    e.bytes({ 0x49, 0x39, 0xf1 });            // cmp r9, rsi
+    e.jump(JCC_JA, Emitter::fail_target);
+}
+
+static void emit_cond_jump(
+    Emitter& e, unsigned pc, const struct bpf_insn& in, uint8_t cc_true, uint8_t cc_false)
+{
+    unsigned jt = pc + 1 + in.jt;
+    unsigned jf = pc + 1 + in.jf;
+
+    if ( in.jt == in.jf )
+    {
+        if ( in.jt )
+            e.jump(jt);
+    }
+    else if ( !in.jt )
+        e.jump(cc_false, jf);
+
+    else
+    {
+        e.jump(cc_true, jt);
+
+        if ( in.jf )
+            e.jump(jf);
+    }
+}
+
+bool BpfJit::generate(std::vector<uint8_t>& code) const
+{
+    Emitter e(code);
+    std::vector<size_t> offsets(prog.size());
+    bool uses_mem = false;
+
+    for ( const auto& in : prog )
+    {
+        unsigned cls = BPF_CLASS(in.code);
+
+        if ( cls == BPF_ST or cls == BPF_STX or
+            ((cls == BPF_LD or cls == BPF_LDX) and BPF_MODE(in.code) == BPF_MEM) )
+            uses_mem = true;
+    }
+
+    e.bytes({ 0x41, 0x89, 0xd2 });            // mov r10d, edx
+    e.bytes({ 0x89, 0xf6 });                  // mov esi, esi
+    e.bytes({ 0x31, 0xc0 });                  // xor eax, eax
+    e.bytes({ 0x31, 0xc9 });                  // xor ecx, ecx
+
+    if ( uses_mem )
+    {
+        e.bytes({ 0x45, 0x31, 0xc0 });        // xor r8d, r8d
+        for ( int d = -64; d < 0; d += 8 )
+            e.bytes({ 0x4c, 0x89, 0x44, 0x24, (uint8_t)d });  // mov [rsp + d], r8
+    }
+
+    for ( unsigned pc = 0; pc < prog.size(); ++pc )
+    {
+        const struct bpf_insn& in = prog[pc];
+        uint32_t k = in.k;
+        offsets[pc] = e.size();
+
+        switch ( in.code )
+        {
+        case BPF_LD|BPF_W|BPF_ABS:
+            emit_abs_check(e, k, 4);
+            e.bytes({ 0x8b, 0x87 }); e.imm32(k);          // mov eax, [rdi + k]
+            e.bytes({ 0x0f, 0xc8 });                      // bswap eax
+            break;
+
+        case BPF_LD|BPF_H|BPF_ABS:
+            emit_abs_check(e, k, 2);
+            e.bytes({ 0x0f, 0xb7, 0x87 }); e.imm32(k);    // movzx eax, word [rdi + k]
+            e.bytes({ 0x66, 0xc1, 0xc0, 0x08 });          // rol ax, 8
+            break;
+
+        case BPF_LD|BPF_B|BPF_ABS:
+            emit_abs_check(e, k, 1);
+            e.bytes({ 0x0f, 0xb6, 0x87 }); e.imm32(k);    // movzx eax, byte [rdi + k]
+            break;
+
+        case BPF_LD|BPF_W|BPF_IND:
+            emit_ind_check(e, k, 4);
+            e.bytes({ 0x42, 0x8b, 0x04, 0x07 });          // mov eax, [rdi + r8]
+            e.bytes({ 0x0f, 0xc8 });                      // bswap eax
+            break;
+
+        case BPF_LD|BPF_H|BPF_IND:
+            emit_ind_check(e, k, 2);
+            e.bytes({ 0x42, 0x0f, 0xb7, 0x04, 0x07 });    // movzx eax, word [rdi + r8]
+            e.bytes({ 0x66, 0xc1, 0xc0, 0x08 });          // rol ax, 8
+            break;
+
+        case BPF_LD|BPF_B|BPF_IND:
+            emit_ind_check(e, k, 1);
+            e.bytes({ 0x42, 0x0f, 0xb6, 0x04, 0x07 });    // movzx eax, byte [rdi + r8]
+            break;
+
+        case BPF_LDX|BPF_MSH|BPF_B:
+            emit_abs_check(e, k, 1);
+            e.bytes({ 0x0f, 0xb6, 0x8f }); e.imm32(k);    // movzx ecx, byte [rdi + k]
+            e.bytes({ 0x83, 0xe1, 0x0f });                // and ecx, 0xf
+            e.bytes({ 0xc1, 0xe1, 0x02 });                // shl ecx, 2
+            break;
+
+        case BPF_LD|BPF_W|BPF_LEN:
+            e.bytes({ 0x44, 0x89, 0xd0 });                // mov eax, r10d
+            break;
+
+        case BPF_LDX|BPF_W|BPF_LEN:
+            e.bytes({ 0x44, 0x89, 0xd1 });                // mov ecx, r10d
+            break;
+
+        case BPF_LD|BPF_IMM:
+            e.byte(0xb8); e.imm32(k);                     // mov eax, k
+            break;
+
+        case BPF_LDX|BPF_IMM:
+            e.byte(0xb9); e.imm32(k);                     // mov ecx, k
+            break;
+
+        case BPF_LD|BPF_MEM:
+            if ( k >= BPF_MEMWORDS )
+                return false;
+            e.bytes({ 0x8b, 0x44, 0x24, mem_disp(k) });   // mov eax, M[k]
+            break;
+
+        case BPF_LDX|BPF_MEM:
+            if ( k >= BPF_MEMWORDS )
+                return false;
+            e.bytes({ 0x8b, 0x4c, 0x24, mem_disp(k) });   // mov ecx, M[k]
+            break;
+
+        case BPF_ST:
+            if ( k >= BPF_MEMWORDS )
+                return false;
+            e.bytes({ 0x89, 0x44, 0x24, mem_disp(k) });   // mov M[k], eax
+            break;
+
+        case BPF_STX:
+            if ( k >= BPF_MEMWORDS )
+                return false;
+            e.bytes({ 0x89, 0x4c, 0x24, mem_disp(k) });   // mov M[k], ecx
+            break;
+
+        case BPF_JMP|BPF_JA:
+            if ( (uint64_t)pc + 1 + k >= prog.size() )
+                return false;
+            e.jump(pc + 1 + k);
+            break;
+
+        case BPF_JMP|BPF_JGT|BPF_K:
+        case BPF_JMP|BPF_JGE|BPF_K:
+        case BPF_JMP|BPF_JEQ|BPF_K:
+        case BPF_JMP|BPF_JSET|BPF_K:
+        case BPF_JMP|BPF_JGT|BPF_X:
+        case BPF_JMP|BPF_JGE|BPF_X:
+        case BPF_JMP|BPF_JEQ|BPF_X:
+        case BPF_JMP|BPF_JSET|BPF_X:
+        {
+            if ( pc + 1 + in.jt >= prog.size() or pc + 1 + in.jf >= prog.size() )
+                return false;
+
+            bool x = BPF_SRC(in.code) == BPF_X;
+
+            if ( BPF_OP(in.code) == BPF_JSET )
+            {
+                if ( x )
+                    e.bytes({ 0x85, 0xc8 });              // test eax, ecx
+                else
+                {
+                    e.byte(0xa9); e.imm32(k);             // test eax, k
+                }
+            }
+            else if ( x )
+                e.bytes({ 0x39, 0xc8 });                  // cmp eax, ecx
+            else
+            {
+                e.byte(0x3d); e.imm32(k);                 // cmp eax, k
+            }
+
+            switch ( BPF_OP(in.code) )
+            {
+            case BPF_JGT:  emit_cond_jump(e, pc, in, JCC_JA, JCC_JBE); break;
+            case BPF_JGE:  emit_cond_jump(e, pc, in, JCC_JAE, JCC_JB); break;
+            case BPF_JEQ:  emit_cond_jump(e, pc, in, JCC_JE, JCC_JNE); break;
+            case BPF_JSET: emit_cond_jump(e, pc, in, JCC_JNE, JCC_JE); break;
+            }
+            break;
+        }
+
+        case BPF_ALU|BPF_ADD|BPF_K: e.byte(0x05); e.imm32(k); break;   // add eax, k
+        case BPF_ALU|BPF_SUB|BPF_K: e.byte(0x2d); e.imm32(k); break;   // sub eax, k
+        case BPF_ALU|BPF_AND|BPF_K: e.byte(0x25); e.imm32(k); break;   // and eax, k
+        case BPF_ALU|BPF_OR|BPF_K:  e.byte(0x0d); e.imm32(k); break;   // or eax, k
+        case BPF_ALU|BPF_XOR|BPF_K: e.byte(0x35); e.imm32(k); break;   // xor eax, k
+
+        case BPF_ALU|BPF_MUL|BPF_K:
+            e.bytes({ 0x69, 0xc0 }); e.imm32(k);          // imul eax, eax, k
+            break;
+
+        case BPF_ALU|BPF_DIV|BPF_K:
+        case BPF_ALU|BPF_MOD|BPF_K:
+            if ( !k )
+                return false;
+            e.bytes({ 0x41, 0xb8 }); e.imm32(k);          // mov r8d, k
+            e.bytes({ 0x31, 0xd2 });                      // xor edx, edx
+            e.bytes({ 0x41, 0xf7, 0xf0 });                // div r8d
+            if ( BPF_OP(in.code) == BPF_MOD )
+                e.bytes({ 0x89, 0xd0 });                  // mov eax, edx
+            break;
+
+        case BPF_ALU|BPF_LSH|BPF_K:
+        case BPF_ALU|BPF_RSH|BPF_K:
+            if ( k >= 32 )
+                return false;
+            e.bytes({ 0xc1, (uint8_t)(BPF_OP(in.code) == BPF_LSH ? 0xe0 : 0xe8), (uint8_t)k });
+            break;
+
+        case BPF_ALU|BPF_ADD|BPF_X: e.bytes({ 0x01, 0xc8 }); break;     // add eax, ecx
+        case BPF_ALU|BPF_SUB|BPF_X: e.bytes({ 0x29, 0xc8 }); break;     // sub eax, ecx
+        case BPF_ALU|BPF_AND|BPF_X: e.bytes({ 0x21, 0xc8 }); break;     // and eax, ecx
+        case BPF_ALU|BPF_OR|BPF_X:  e.bytes({ 0x09, 0xc8 }); break;     // or eax, ecx
+        case BPF_ALU|BPF_XOR|BPF_X: e.bytes({ 0x31, 0xc8 }); break;     // xor eax, ecx
+        case BPF_ALU|BPF_MUL|BPF_X: e.bytes({ 0x0f, 0xaf, 0xc1 }); break;  // imul eax, ecx
+
+        case BPF_ALU|BPF_DIV|BPF_X:
+        case BPF_ALU|BPF_MOD|BPF_X:
+            e.bytes({ 0x85, 0xc9 });                      // test ecx, ecx
+            e.jump(JCC_JE, Emitter::fail_target);
+            e.bytes({ 0x31, 0xd2 });                      // xor edx, edx
+            e.bytes({ 0xf7, 0xf1 });                      // div ecx
+            if ( BPF_OP(in.code) == BPF_MOD )
+                e.bytes({ 0x89, 0xd0 });                  // mov eax, edx
+            break;
+
+        case BPF_ALU|BPF_LSH|BPF_X:
+        case BPF_ALU|BPF_RSH|BPF_X:
+            // the interpreter yields 0 for shifts of 32 or more
+            e.bytes({ 0xd3, (uint8_t)(BPF_OP(in.code) == BPF_LSH ? 0xe0 : 0xe8) });  // shl/shr eax, cl
+            e.bytes({ 0x83, 0xf9, 0x20 });                // cmp ecx, 32
+            e.bytes({ 0x72, 0x02 });                      // jb +2
+            e.bytes({ 0x31, 0xc0 });                      // xor eax, eax
+            break;
+
+        case BPF_ALU|BPF_NEG:
+            e.bytes({ 0xf7, 0xd8 });                      // neg eax
+            break;
+
+        case BPF_RET|BPF_K:
+            e.byte(0xb8); e.imm32(k);                     // mov eax, k
+            e.byte(0xc3);                                 // ret
+            break;
+
+        case BPF_RET|BPF_A:
+            e.byte(0xc3);                                 // ret
+            break;
+
+        case BPF_MISC|BPF_TAX:
+            e.bytes({ 0x89, 0xc1 });                      // mov ecx, eax
+            break;
+
+        case BPF_MISC|BPF_TXA:
+            e.bytes({ 0x89, 0xc8 });                      // mov eax, ecx
+            break;
+
+        default:
+            return false;
+        }
+    }
+
+    // a validated program always ends in a return; this is the failure exit
+    size_t fail = e.size();
+    e.bytes({ 0x31, 0xc0 });                              // xor eax, eax
+    e.byte(0xc3);                                         // ret
+
+    e.patch(offsets, fail);
+    return true;
+}
+
+#else
+
+bool BpfJit::generate(std::vector<uint8_t>&) const
+{ return false; }
+
+#endif
+
+//--------------------------------------------------------------------------
+// public methods
+//--------------------------------------------------------------------------
+
+BpfJit::BpfJit() = default;
+
+BpfJit::~BpfJit()
+{ clear(); }
+
+void BpfJit::clear()
+{
+    if ( code )
+        munmap(code, code_size);
+
+    code = nullptr;
+    code_size = 0;
+    native = nullptr;
+    prog.clear();
+}
+
+bool BpfJit::compile(const struct bpf_insn* insns, unsigned len)
+{
+    clear();
+    prog.assign(insns, insns + len);
+
+    std::vector<uint8_t> buf;
+
+    if ( !len or !generate(buf) )
+        return false;
+
+    void* p = mmap(nullptr, buf.size(), PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+
+    if ( p == MAP_FAILED )
+        return false;
+
+    memcpy(p, buf.data(), buf.size());
+
+    if ( mprotect(p, buf.size(), PROT_READ|PROT_EXEC) )
+    {
+        munmap(p, buf.size());
+        return false;
+    }
+
+    code = p;
+    code_size = buf.size();
+    native = (NativeFilter)code;
+    return true;
+}
+
+unsigned BpfJit::filter(const uint8_t* pkt, unsigned caplen, unsigned wirelen) const
+{
+    if ( native )
+        return native(pkt, caplen, wirelen);
+
+    return bpf_filter(prog.data(), pkt, wirelen, caplen);
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static std::vector<uint8_t> make_packet(std::mt19937& gen, unsigned len)
+{
+    std::vector<uint8_t> pkt(len);
+
+    for ( auto& b : pkt )
+        b = (uint8_t)gen();
+
+    // mostly IPv4 ethernet frames so the typical filters take their long paths
+    if ( len >= 34 and (gen() & 3) )
+    {
+        pkt[12] = 0x08;
+        pkt[13] = 0x00;
+        pkt[14] = 0x45;
+        pkt[23] = (gen() & 1) ? 6 : 17;
+
+        if ( gen() & 7 )
+            pkt[20] = pkt[21] = 0;
+
+        if ( gen() & 1 )
+            pkt[26] = 10;
+
+        if ( len >= 38 and (gen() & 1) )
+        {
+            unsigned port = 34 + 2 * (gen() & 1);
+            pkt[port] = 0;
+            pkt[port + 1] = 80;
+        }
+    }
+    return pkt;
+}
+
+// programs shaped like tcpdump -d output for a few typical expressions along
+// with one that touches every instruction the compiler handles
+
+// ip
+static const struct bpf_insn ip_prog[] =
+{
+    BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 12),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x0800, 0, 1),
+    BPF_STMT(BPF_RET|BPF_K, 65535),
+    BPF_STMT(BPF_RET|BPF_K, 0),
+};
+
+// tcp port 80
+static const struct bpf_insn tcp_port_prog[] =
+{
+    BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 12),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x86dd, 0, 6),
+    BPF_STMT(BPF_LD|BPF_B|BPF_ABS, 20),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 6, 0, 15),
+    BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 54),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 80, 12, 0),
+    BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 56),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 80, 10, 11),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x0800, 0, 10),
+    BPF_STMT(BPF_LD|BPF_B|BPF_ABS, 23),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 6, 0, 8),
+    BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 20),
+    BPF_JUMP(BPF_JMP|BPF_JSET|BPF_K, 0x1fff, 6, 0),
+    BPF_STMT(BPF_LDX|BPF_B|BPF_MSH, 14),
+    BPF_STMT(BPF_LD|BPF_H|BPF_IND, 14),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 80, 2, 0),
+    BPF_STMT(BPF_LD|BPF_H|BPF_IND, 16),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 80, 0, 1),
+    BPF_STMT(BPF_RET|BPF_K, 65535),
+    BPF_STMT(BPF_RET|BPF_K, 0),
+};
+
+// net 10.0.0.0/8 and greater 64
+static const struct bpf_insn net_len_prog[] =
+{
+    BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 12),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x0800, 0, 9),
+    BPF_STMT(BPF_LD|BPF_W|BPF_ABS, 26),
+    BPF_STMT(BPF_ALU|BPF_AND|BPF_K, 0xff000000),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x0a000000, 3, 0),
+    BPF_STMT(BPF_LD|BPF_W|BPF_ABS, 30),
+    BPF_STMT(BPF_ALU|BPF_AND|BPF_K, 0xff000000),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x0a000000, 0, 3),
+    BPF_STMT(BPF_LD|BPF_W|BPF_LEN, 0),
+    BPF_JUMP(BPF_JMP|BPF_JGE|BPF_K, 64, 0, 1),
+    BPF_STMT(BPF_RET|BPF_K, 65535),
+    BPF_STMT(BPF_RET|BPF_K, 0),
+};
+
+// arithmetic, scratch memory, and register transfers
+static const struct bpf_insn alu_prog[] =
+{
+    BPF_STMT(BPF_LD|BPF_B|BPF_ABS, 0),
+    BPF_STMT(BPF_ST, 3),
+    BPF_STMT(BPF_LDX|BPF_B|BPF_MSH, 1),
+    BPF_STMT(BPF_ALU|BPF_ADD|BPF_X, 0),
+    BPF_STMT(BPF_ALU|BPF_MUL|BPF_K, 2654435761u),
+    BPF_STMT(BPF_ALU|BPF_RSH|BPF_K, 7),
+    BPF_STMT(BPF_ALU|BPF_OR|BPF_K, 0x10),
+    BPF_STMT(BPF_ALU|BPF_SUB|BPF_K, 3),
+    BPF_STMT(BPF_STX, 15),
+    BPF_STMT(BPF_LDX|BPF_MEM, 3),
+    BPF_STMT(BPF_ALU|BPF_DIV|BPF_X, 0),
+    BPF_STMT(BPF_ALU|BPF_MOD|BPF_K, 40),
+    BPF_STMT(BPF_MISC|BPF_TAX, 0),
+    BPF_STMT(BPF_LD|BPF_W|BPF_IND, 2),
+    BPF_STMT(BPF_ALU|BPF_LSH|BPF_X, 0),
+    BPF_STMT(BPF_ALU|BPF_NEG, 0),
+    BPF_STMT(BPF_ALU|BPF_SUB|BPF_X, 0),
+    BPF_STMT(BPF_ALU|BPF_AND|BPF_X, 0),
+    BPF_STMT(BPF_ALU|BPF_MUL|BPF_X, 0),
+    BPF_STMT(BPF_LDX|BPF_MEM, 15),
+    BPF_STMT(BPF_ALU|BPF_MOD|BPF_X, 0),
+    BPF_STMT(BPF_ALU|BPF_XOR|BPF_X, 0),
+    BPF_STMT(BPF_ALU|BPF_OR|BPF_X, 0),
+    BPF_STMT(BPF_ALU|BPF_XOR|BPF_K, 0x5a5a),
+    BPF_JUMP(BPF_JMP|BPF_JGT|BPF_X, 0, 1, 0),
+    BPF_STMT(BPF_MISC|BPF_TXA, 0),
+    BPF_JUMP(BPF_JMP|BPF_JSET|BPF_X, 0, 0, 2),
+    BPF_STMT(BPF_LDX|BPF_IMM, 40),
+    BPF_STMT(BPF_ALU|BPF_RSH|BPF_X, 0),
+    BPF_STMT(BPF_LD|BPF_B|BPF_IND, 0),
+    BPF_JUMP(BPF_JMP|BPF_JGE|BPF_X, 0, 0, 1),
+    BPF_STMT(BPF_LD|BPF_IMM, 7),
+    BPF_STMT(BPF_ALU|BPF_DIV|BPF_K, 3),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_X, 0, 1, 0),
+    BPF_JUMP(BPF_JMP|BPF_JA, 1, 0, 0),
+    BPF_STMT(BPF_ALU|BPF_LSH|BPF_K, 4),
+    BPF_STMT(BPF_LD|BPF_MEM, 15),
+    BPF_STMT(BPF_LDX|BPF_W|BPF_LEN, 0),
+    BPF_STMT(BPF_ALU|BPF_ADD|BPF_X, 0),
+    BPF_STMT(BPF_RET|BPF_A, 0),
+};
+
+struct TestProgram
+{
+    const struct bpf_insn* insns;
+    unsigned len;
+    const char* name;
+};
+
+#define TEST_PROG(p) { p, sizeof(p) / sizeof(p[0]), #p }
+
+static const TestProgram test_progs[] =
+{
+    TEST_PROG(ip_prog),
+    TEST_PROG(tcp_port_prog),
+    TEST_PROG(net_len_prog),
+    TEST_PROG(alu_prog),
+};
+
+TEST_CASE("bpf jit matches interpreter", "[bpf_jit]")
+{
+    std::mt19937 gen(5489);
+
+    for ( const auto& tp : test_progs )
+    {
+        INFO(tp.name);
+        REQUIRE(bpf_validate(tp.insns, tp.len));
+
+        BpfJit jit;
+#if defined(__x86_64__)
+        REQUIRE(jit.compile(tp.insns, tp.len));
+        CHECK(jit.is_native());
+#else
+        jit.compile(tp.insns, tp.len);
+#endif
+        for ( unsigned i = 0; i < 5000; ++i )
+        {
+            std::vector<uint8_t> pkt = make_packet(gen, gen() % 96);
+            unsigned wirelen = pkt.size() + (gen() & 0x3f);
+
+            CHECK(jit.filter(pkt.data(), pkt.size(), wirelen) ==
+                bpf_filter(tp.insns, pkt.data(), wirelen, pkt.size()));
+        }
+    }
+}
+
+TEST_CASE("bpf jit fallback", "[bpf_jit]")
+{
+    // an unknown opcode is not compiled; filter() would use the interpreter
+    static const struct bpf_insn prog[] =
+    {
+        BPF_STMT(BPF_LD|BPF_B|BPF_ABS, 0),
+        BPF_STMT(BPF_MISC|0x40, 0),
+        BPF_STMT(BPF_RET|BPF_A, 0),
+    };
+
+    BpfJit jit;
+    CHECK(!jit.compile(prog, 3));
+    CHECK(!jit.is_native());
+
+    jit.compile(ip_prog, sizeof(ip_prog) / sizeof(ip_prog[0]));
+    jit.clear();
+    CHECK(!jit.is_native());
+}
+
+TEST_CASE("bpf jit benchmark", "[.bench][bpf_jit]")
+{
+    std::mt19937 gen(1);
+    std::vector<std::vector<uint8_t>> pkts;
+
+    for ( unsigned i = 0; i < 1024; ++i )
+        pkts.emplace_back(make_packet(gen, 60 + gen() % 1400));
+
+    for ( const auto& tp : test_progs )
+    {
+        BpfJit jit;
+        jit.compile(tp.insns, tp.len);
+
+        unsigned jit_hits = 0, int_hits = 0;
+
+        Benchmark native((std::string("bpf_jit.native.") + tp.name).c_str(), pkts.size(), "pkts");
+        native.run([&]()
+        {
+            jit_hits = 0;
+            for ( const auto& p : pkts )
+                jit_hits += jit.filter(p.data(), p.size(), p.size()) != 0;
+        });
+
+        Benchmark interp((std::string("bpf_jit.interp.") + tp.name).c_str(), pkts.size(), "pkts");
+        interp.run([&]()
+        {
+            int_hits = 0;
+            for ( const auto& p : pkts )
+                int_hits += bpf_filter(tp.insns, p.data(), p.size(), p.size()) != 0;
+        });
+
+        CHECK(jit_hits == int_hits);
+    }
+}
+
+#endif
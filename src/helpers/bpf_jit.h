@@ -0,0 +1,70 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// bpf_jit.h
+
+#ifndef BPF_JIT_H
+#define BPF_JIT_H
+
+// Compiles a validated classic BPF program to native code on x86-64.  Other
+// platforms, and programs using instructions the compiler does not handle,
+// fall back to the libpcap interpreter with the same results.
+
+#include <cstdint>
+#include <vector>
+
+#include "main/snort_types.h"
+
+struct bpf_insn;
+
+namespace snort
+{
+
+class SO_PUBLIC BpfJit
+{
+public:
+    BpfJit();
+    ~BpfJit();
+
+    BpfJit(const BpfJit&) = delete;
+    BpfJit& operator=(const BpfJit&) = delete;
+
+    // returns true if native code was generated; the program is copied and
+    // filter() is usable either way
+    bool compile(const struct bpf_insn*, unsigned len);
+    void clear();
+
+    bool is_native() const
+    { return native != nullptr; }
+
+    // caplen bounds packet loads, wirelen is the value of len
+    unsigned filter(const uint8_t* pkt, unsigned caplen, unsigned wirelen) const;
+
+private:
+    typedef unsigned (*NativeFilter)(const uint8_t*, unsigned, unsigned);
+
+    bool generate(std::vector<uint8_t>&) const;
+
+    std::vector<struct bpf_insn> prog;
+    NativeFilter native = nullptr;
+    void* code = nullptr;
+    size_t code_size = 0;
+};
+
+}
+#endif
@@ -24,6 +24,13 @@
 
 #include "host_cache.h"
 
+#ifdef UNIT_TEST
+#include <unordered_set>
+
+#include "catch/snort_bench.h"
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
 // Default host cache size in bytes.
@@ -31,3 +38,68 @@ using namespace snort;
 #define LRU_CACHE_INITIAL_SIZE 16384 * 512
 
 HostCacheIp host_cache(LRU_CACHE_INITIAL_SIZE);
+
+#ifdef UNIT_TEST
+// the hash HashIp replaced: xor of the halves of the address
+struct XorHashIp
+{
+    size_t operator()(const SfIp& ip) const
+    {
+        const uint64_t* ip64 = (const uint64_t*) ip.get_ip6_ptr();
+        return std::hash<uint64_t>() (ip64[0]) ^ std::hash<uint64_t>() (ip64[1]);
+    }
+};
+
+// hashing alone and lookups in a table of 64K hosts, half ip4 and half ip6
+// from a /64, for each hash
+template<typename Hash>
+static void bench_hash(const char* name, const std::vector<SfIp>& ips)
+{
+    Hash hash;
+    size_t sum = 0;
+
+    Benchmark hb((std::string("host_cache.") + name + "_hash").c_str(), ips.size(), "keys");
+    hb.run([&]()
+    {
+        for ( const auto& ip : ips )
+            sum += hash(ip);
+    });
+    CHECK(sum != 0);
+
+    std::unordered_set<SfIp, Hash, IpEqualTo> hosts(ips.begin(), ips.end());
+    size_t found = 0;
+
+    Benchmark lb((std::string("host_cache.") + name + "_lookup").c_str(), ips.size(), "keys");
+    lb.add_field("buckets", hosts.bucket_count());
+    lb.run([&]()
+    {
+        found = 0;
+
+        for ( const auto& ip : ips )
+            found += hosts.count(ip);
+    });
+    CHECK(found == ips.size());
+}
+
+TEST_CASE("host cache hash", "[.bench][host_cache]")
+{
+    const unsigned num_hosts = 65536;
+    std::vector<SfIp> ips(num_hosts);
+
+    for ( unsigned i = 0; i < num_hosts; ++i )
+    {
+        uint32_t a[4] = { htonl(0x20010db8), 0, htonl(i >> 8), htonl(i) };
+
+        if ( i % 2 )
+            ips[i].set(a, AF_INET6);
+        else
+        {
+            uint32_t a4 = htonl(0x0a000000 | i);
+            ips[i].set(&a4, AF_INET);
+        }
+    }
+
+    bench_hash<XorHashIp>("xor", ips);
+    bench_hash<HashIp>("seeded", ips);
+}
+#endif
@@ -25,7 +25,9 @@
 // be shared among threads.
 
 #include <cassert>
+#include <random>
 
+#include "hash/hash_key_operations.h"
 #include "hash/lru_cache_shared.h"
 #include "host_cache_interface.h"
 #include "host_cache_allocator.h"
@@ -35,19 +37,34 @@
 #include "sfip/sf_ip.h"
 #include "utils/stats.h"
 
-// Used to create hash of key for indexing into cache.
+// Used to create hash of key for indexing into cache.  The seed is random
+// per process so addresses can't be picked to collide in every snort.
 //
 // Note that both HashIp and IpEqualTo below ignore the IP family.
 // This means that 1.2.3.4 and ::ffff:0102:0304 will be treated
 // as equal (same host).
 struct HashIp
 {
+    HashIp() : seed(get_seed()) { }
+
     size_t operator()(const snort::SfIp& ip) const
     {
-        const uint64_t* ip64 = (const uint64_t*) ip.get_ip6_ptr();
-        return std::hash<uint64_t>() (ip64[0]) ^
-               std::hash<uint64_t>() (ip64[1]);
+        const uint8_t* ip8 = (const uint8_t*) ip.get_ip6_ptr();
+        return snort::hash_16(snort::hash_read64(ip8), snort::hash_read64(ip8 + 8), seed);
     }
+
+private:
+    static uint64_t get_seed()
+    {
+        static const uint64_t process_seed = []()
+        {
+            std::random_device rd;
+            return ((uint64_t)rd() << 32) ^ rd();
+        }();
+        return process_seed;
+    }
+
+    uint64_t seed;
 };
 
 struct IpEqualTo
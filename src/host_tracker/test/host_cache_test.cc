@@ -50,19 +50,18 @@ TEST_GROUP(host_cache)
 //  Test HashIp
 TEST(host_cache, hash_test)
 {
-    size_t actual_hash_val;
-
     HashIp hash_hk;
-    SfIp ip;
+    HashIp other_hk;
+    SfIp ip, ip4, mapped;
 
     ip.pton(AF_INET6, "aff:1200::b00:5600:0:0");
-    actual_hash_val = hash_hk(ip);
+    ip4.pton(AF_INET, "10.1.2.3");
+    mapped.pton(AF_INET6, "::ffff:a01:203");
 
-#if defined(WORDS_BIGENDIAN)
-    CHECK(actual_hash_val == (size_t)143908479889833984);
-#else
-    CHECK(actual_hash_val == (size_t)4521729);
-#endif
+    // the seed is per process so every cache places a host the same way
+    CHECK(hash_hk(ip) == other_hk(ip));
+    CHECK(hash_hk(ip4) == hash_hk(mapped));
+    CHECK(hash_hk(ip) != hash_hk(ip4));
 }
 
 int main(int argc, char** argv)
@@ -27,6 +27,7 @@
 #include <daq.h>
 
 #include <thread>
+#include <vector>
 
 #include "detection/context_switcher.h"
 #include "detection/detect.h"
@@ -81,21 +82,23 @@ static MainHook_f main_hook = snort_ignore;
 
 THREAD_LOCAL ProfileStats daqPerfStats;
 static THREAD_LOCAL Analyzer* local_analyzer = nullptr;
+static const unsigned s_mem_tag = memory::MemoryCap::register_tag("daq");
 
 //-------------------------------------------------------------------------
 
+// All messages are retried after the same interval so they come due in the
+// order they were queued.  A ring serviced from the head is therefore all the
+// timer structure needed; it grows by doubling and never allocates per entry.
 class RetryQueue
 {
     struct Entry
     {
-        Entry(const struct timeval& next_try, DAQ_Msg_h msg) : next_try(next_try), msg(msg) { }
-
         struct timeval next_try;
         DAQ_Msg_h msg;
     };
 
 public:
-    RetryQueue(unsigned interval_ms)
+    RetryQueue(unsigned interval_ms) : ring(initial_size)
     {
         assert(interval_ms > 0);
         interval = { static_cast<time_t>(interval_ms / 1000), static_cast<suseconds_t>((interval_ms % 1000) * 1000) };
@@ -108,34 +111,71 @@ public:
 
     void put(DAQ_Msg_h msg)
     {
-        struct timeval now, next_try;
+        if ( count == ring.size() )
+            grow();
+
+        struct timeval now;
         packet_gettimeofday(&now);
-        timeradd(&now, &interval, &next_try);
-        queue.emplace_back(next_try, msg);
+
+        Entry& entry = ring[(head + count) & (ring.size() - 1)];
+        timeradd(&now, &interval, &entry.next_try);
+        entry.msg = msg;
+
+        if ( ++count > daq_stats.retries_max_queued )
+            daq_stats.retries_max_queued = count;
     }
 
-    DAQ_Msg_h get(const struct timeval* now = nullptr)
+    // if now is given, only a message that is due is returned and
+    // late is set to the usecs it was overdue
+    DAQ_Msg_h get(const struct timeval* now = nullptr, uint64_t* late = nullptr)
     {
-        if (!empty())
+        if ( empty() )
+            return nullptr;
+
+        const Entry& entry = ring[head];
+
+        if ( now )
         {
-            const Entry& entry = queue.front();
-            if (!now || !timercmp(now, &entry.next_try, <))
+            if ( timercmp(now, &entry.next_try, <) )
+                return nullptr;
+
+            if ( late )
             {
-                DAQ_Msg_h msg = entry.msg;
-                queue.pop_front();
-                return msg;
+                struct timeval delta;
+                timersub(now, &entry.next_try, &delta);
+                *late = delta.tv_sec * 1000000ULL + delta.tv_usec;
             }
         }
-        return nullptr;
+
+        DAQ_Msg_h msg = entry.msg;
+        head = (head + 1) & (ring.size() - 1);
+        --count;
+        return msg;
     }
 
     bool empty() const
     {
-        return queue.empty();
+        return count == 0;
+    }
+
+private:
+    void grow()
+    {
+        vector<Entry> tmp(ring.size() * 2);
+
+        for ( unsigned i = 0; i < count; ++i )
+            tmp[i] = ring[(head + i) & (ring.size() - 1)];
+
+        ring.swap(tmp);
+        head = 0;
     }
 
 private:
-    deque<Entry> queue;
+    static constexpr unsigned initial_size = 64;  // must be a power of 2
+
+    vector<Entry> ring;
+    unsigned head = 0;
+    unsigned count = 0;
     struct timeval interval;
 };
 
@@ -250,10 +290,13 @@ static DAQ_Verdict distill_verdict(Packet* p)
             verdict = DAQ_VERDICT_BLOCK;
         // FIXIT-M X Should we be blocking the wire packet even if the injection fails?
     }
-    else if ( p->packet_flags & PKT_MODIFIED )
+    else if ( p->packet_flags & (PKT_MODIFIED | PKT_HDR_MODIFIED) )
     {
-        // this packet was normalized and/or has replacements
-        PacketManager::encode_update(p);
+        // this packet was normalized and/or has replacements; header only
+        // edits already have their checksums adjusted
+        if ( p->packet_flags & PKT_MODIFIED )
+            PacketManager::encode_update(p);
+
         verdict = DAQ_VERDICT_REPLACE;
     }
     else if ( act->session_was_trusted() )
@@ -291,7 +334,7 @@ void Analyzer::add_to_retry_queue(DAQ_Msg_h daq_msg)
 {
     // Temporarily increase memcap until message is finalized in case
     // DAQ makes a copy of the data buffer.
-    memory::MemoryCap::update_allocations(daq_msg_get_data_len(daq_msg));
+    memory::MemoryCap::update_allocations(daq_msg_get_data_len(daq_msg), s_mem_tag);
     retry_queue->put(daq_msg);
 }
 
@@ -361,10 +404,7 @@ void Analyzer::post_process_daq_pkt_msg(Packet* p)
         oops_handler->set_current_message(nullptr);
         p->pkth = nullptr;  // No longer avail after finalize_message.
 
-        {
-            Profile profile(daqPerfStats);
-            p->daq_instance->finalize_message(p->daq_msg, verdict);
-        }
+        p->daq_instance->defer_verdict(p->daq_msg, verdict);
     }
 }
 
@@ -427,10 +467,7 @@ void Analyzer::process_daq_msg(DAQ_Msg_h msg, bool retry)
             break;
     }
     oops_handler->set_current_message(nullptr);
-    {
-        Profile profile(daqPerfStats);
-        daq_instance->finalize_message(msg, verdict);
-    }
+    daq_instance->defer_verdict(msg, verdict);
 }
 
 void Analyzer::process_retry_queue()
@@ -440,13 +477,19 @@ void Analyzer::process_retry_queue()
         struct timeval now;
         packet_gettimeofday(&now);
         DAQ_Msg_h msg;
-        while ((msg = retry_queue->get(&now)) != nullptr)
+        uint64_t late;
+
+        while ((msg = retry_queue->get(&now, &late)) != nullptr)
         {
+            if ( late > daq_stats.retries_max_latency )
+                daq_stats.retries_max_latency = late;
+
+            // The verdict is only deferred here so the memcap is decreased by
+            // credit_retries() once the batch has been submitted to the DAQ.
+            // Take the length first since a full batch may finalize msg.
+            retry_credits.emplace_back(daq_msg_get_data_len(msg));
             process_daq_msg(msg, true);
             daq_stats.retries_processed++;
-
-            // Decrease memcap now that msg has been finalized.
-            memory::MemoryCap::update_deallocations(daq_msg_get_data_len(msg));
         }
     }
 }
@@ -477,9 +520,30 @@ void Analyzer::post_process_packet(Packet* p)
     switcher->stop();
 }
 
+void Analyzer::flush_verdicts()
+{
+    Profile profile(daqPerfStats);
+    daq_instance->finalize_verdicts();
+    credit_retries();
+}
+
+void Analyzer::credit_retries()
+{
+    // Credited one message at a time to match the fudged allocations.
+    for ( auto len : retry_credits )
+        memory::MemoryCap::update_deallocations(len, s_mem_tag);
+
+    retry_credits.clear();
+}
+
 void Analyzer::finalize_daq_message(DAQ_Msg_h msg, DAQ_Verdict verdict)
 {
     Profile profile(daqPerfStats);
+
+    // held packets are released while the batch is in progress; submit the
+    // verdicts already deferred ahead of them so wire order is kept
+    daq_instance->finalize_verdicts();
+    credit_retries();
     daq_instance->finalize_message(msg, verdict);
 }
 
@@ -556,6 +620,9 @@ void Analyzer::idle()
 
     handle_uncompleted_commands();
 
+    HostAttributesManager::flush_updates();
+    flush_verdicts();
+
     idling = false;
 }
 
@@ -614,10 +681,18 @@ void Analyzer::init_unprivileged()
     SFRF_Alloc(sc->rate_filter_config->memcap);
 }
 
-void Analyzer::reinit(const SnortConfig* sc)
+// thread local setup for plugins and inspectors first configured in sc.  none
+// of it is reachable until sc is the current config so it can be done early.
+void Analyzer::reinit_plugins(const SnortConfig* sc)
 {
     InspectorManager::thread_reinit(sc);
     ActionManager::thread_reinit(sc);
+}
+
+// thread state used with whatever config is current; must change with it
+void Analyzer::reinit(const SnortConfig* sc)
+{
+    Active::thread_init(sc);
     TraceApi::thread_reinit(sc->trace_config);
 }
 
@@ -640,10 +715,15 @@ void Analyzer::term()
     {
         daq_stats.retries_discarded++;
         Profile profile(daqPerfStats);
+        uint32_t len = daq_msg_get_data_len(msg);
         daq_instance->finalize_message(msg, DAQ_VERDICT_BLOCK);
+        memory::MemoryCap::update_deallocations(len, s_mem_tag);
     }
 
     DetectionEngine::idle();
+    flush_verdicts();
+    HostAttributesManager::thread_term();
+
     InspectorManager::thread_stop(sc);
     ModuleManager::accumulate();
     InspectorManager::thread_term();
@@ -842,10 +922,9 @@ DAQ_RecvStatus Analyzer::process_messages()
         // Dispose of any messages to be skipped first.先处理要跳过的所有消息。
         if (skip_cnt > 0)
         {
-            Profile profile(daqPerfStats);
             daq_stats.skipped++;
             skip_cnt--;
-            daq_instance->finalize_message(msg, DAQ_VERDICT_PASS);
+            daq_instance->defer_verdict(msg, DAQ_VERDICT_PASS);
             continue;
         }
         // FIXIT-M reimplement fail-open capability?
@@ -857,6 +936,8 @@ DAQ_RecvStatus Analyzer::process_messages()
         handle_uncompleted_commands();
     }
 
+    flush_verdicts();
+
     if (exit_after_cnt && (exit_after_cnt -= num_recv) == 0)
         stop();
     if (pause_after_cnt && (pause_after_cnt -= num_recv) == 0)
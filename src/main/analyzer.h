@@ -31,6 +31,7 @@
 #include <mutex>
 #include <queue>
 #include <string>
+#include <vector>
 
 #include "thread.h"
 
@@ -105,6 +106,7 @@ public:
     void pause();
     void resume(uint64_t msg_cnt);
     void reload_daq();
+    void reinit_plugins(const snort::SnortConfig*);
     void reinit(const snort::SnortConfig*);
     void stop_removed(const snort::SnortConfig*);
     void rotate();
@@ -120,6 +122,8 @@ private:
     void handle_uncompleted_commands();
     DAQ_RecvStatus process_messages();
     void process_daq_msg(DAQ_Msg_h, bool retry);
+    void flush_verdicts();
+    void credit_retries();
     void process_daq_pkt_msg(DAQ_Msg_h, bool retry);
     void post_process_daq_pkt_msg(snort::Packet*);
     void process_retry_queue();
@@ -148,6 +152,8 @@ private:
     std::string source;
     snort::SFDAQInstance* daq_instance;
     RetryQueue* retry_queue = nullptr;
+    // data lengths of retried messages whose verdicts are still deferred
+    std::vector<uint32_t> retry_credits;
     OopsHandler* oops_handler = nullptr;
     ContextSwitcher* switcher = nullptr;
     std::mutex pending_work_queue_mutex;
@@ -29,8 +29,10 @@
 #include "framework/module.h"
 #include "log/messages.h"
 #include "managers/module_manager.h"
+#include "packet_io/sfdaq_module.h"
 #include "protocols/packet_manager.h"
 #include "target_based/host_attributes.h"
+#include "time/clock_defs.h"
 #include "utils/stats.h"
 
 #include "analyzer.h"
@@ -113,63 +115,93 @@ ACSwap::ACSwap(Swapper* ps, ControlConn *ctrlcon) : ps(ps), ctrlcon(ctrlcon)
     Swapper::set_reload_in_progress(true);
 }
 
-bool ACSwap::execute(Analyzer& analyzer, void** ac_state)
+// Per thread progress through a swap.  Each step runs as a separate pass of the
+// command so packets are processed between the thread local setup for the new
+// config, the config pointer swap, and each reload resource tuning step.
+struct SwapState
 {
-    if (ps)
-    {
-        ps->apply(analyzer);
+    std::list<ReloadResourceTuner*> reload_tuners;
+    bool swapped = false;
+};
 
-        const SnortConfig* sc = ps->get_new_conf();
-        if ( sc )
-        {
-            std::list<ReloadResourceTuner*>* reload_tuners;
+static void update_reload_stats(const hr_time& start)
+{
+    uint64_t usecs = TO_USECS(SnortClock::now() - start);
+
+    if ( usecs < 100 )
+        daq_stats.reload_steps_lt_100us++;
+    else if ( usecs < 1000 )
+        daq_stats.reload_steps_lt_1ms++;
+    else if ( usecs < 10000 )
+        daq_stats.reload_steps_lt_10ms++;
+    else
+        daq_stats.reload_steps_ge_10ms++;
+
+    if ( usecs > daq_stats.reload_max_usecs )
+        daq_stats.reload_max_usecs = usecs;
+}
 
-            if ( !*ac_state )
-            {
-                reload_tuners = new std::list<ReloadResourceTuner*>(sc->get_reload_resource_tuners());
-                std::list<ReloadResourceTuner*>::iterator rtt = reload_tuners->begin();
-                while ( rtt != reload_tuners->end() )
-                {
-                    if ( (*rtt)->tinit() )
-                        ++rtt;
-                    else
-                        rtt = reload_tuners->erase(rtt);
-                }
-                *ac_state = reload_tuners;
-            }
-            else
-                reload_tuners = (std::list<ReloadResourceTuner*>*)*ac_state;
+static bool swap_step(Swapper* ps, Analyzer& analyzer, void** ac_state)
+{
+    SwapState* ss = (SwapState*)*ac_state;
 
-            if ( !reload_tuners->empty() )
-            {
-                auto rrt = reload_tuners->front();
-                if ( analyzer.is_idling() )
-                {
-                    if ( rrt->tune_idle_context() )
-                        reload_tuners->pop_front();
-                }
-                else
-                {
-                    if ( rrt->tune_packet_context() )
-                        reload_tuners->pop_front();
-                }
-            }
+    if ( !ss )
+    {
+        ps->prepare(analyzer);
+        *ac_state = new SwapState;
+        return false;
+    }
 
-            // check for empty again and free list instance if we are done
-            if ( reload_tuners->empty() )
+    if ( !ss->swapped )
+    {
+        ps->apply(analyzer);
+        ss->swapped = true;
+        daq_stats.reload_swaps++;
+
+        if ( const SnortConfig* sc = ps->get_new_conf() )
+        {
+            for ( auto* rrt : sc->get_reload_resource_tuners() )
             {
-                delete reload_tuners;
-                ps->finish(analyzer);
-                return true;
+                if ( rrt->tinit() )
+                    ss->reload_tuners.emplace_back(rrt);
             }
-
-            return false;
         }
     }
+    else if ( !ss->reload_tuners.empty() )
+    {
+        auto rrt = ss->reload_tuners.front();
+        if ( analyzer.is_idling() )
+        {
+            if ( rrt->tune_idle_context() )
+                ss->reload_tuners.pop_front();
+        }
+        else
+        {
+            if ( rrt->tune_packet_context() )
+                ss->reload_tuners.pop_front();
+        }
+    }
+
+    if ( !ss->reload_tuners.empty() )
+        return false;
 
+    delete ss;
+    ps->finish(analyzer);
     return true;
 }
 
+bool ACSwap::execute(Analyzer& analyzer, void** ac_state)
+{
+    if ( !ps )
+        return true;
+
+    hr_time start = SnortClock::now();
+    bool done = swap_step(ps, analyzer, ac_state);
+    update_reload_stats(start);
+
+    return done;
+}
+
 ACSwap::~ACSwap()
 {
     if (ps)
@@ -179,7 +211,6 @@ ACSwap::~ACSwap()
             sc->clear_reload_resource_tuner_list();
     }
     delete ps;
-    HostAttributesManager::swap_cleanup();
 
     Swapper::set_reload_in_progress(false);
     LogMessage("== reload complete\n");
@@ -202,7 +233,6 @@ bool ACHostAttributesSwap::execute(Analyzer&, void**)
 
 ACHostAttributesSwap::~ACHostAttributesSwap()
 {
-    HostAttributesManager::swap_cleanup();
     Swapper::set_reload_in_progress(false);
     LogMessage("== reload host attributes complete\n");
     if (ctrlcon && !ctrlcon->is_local())
@@ -841,6 +841,7 @@ static PegInfo active_pegs[]
     { CountType::SUM, "holds_denied", "total number of packet hold requests denied" },
     { CountType::SUM, "holds_canceled", "total number of packet hold requests canceled" },
     { CountType::SUM, "holds_allowed", "total number of packet hold requests allowed" },
+    { CountType::SUM, "patched_injects", "total crafted resets patched instead of re-encoded" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -856,6 +857,9 @@ public:
     PegCount* get_counts() const override
     { return (PegCount*) &active_counts; }
 
+    ProfileStats* get_profile() const override
+    { return &active_perf_stats; }
+
     Usage get_usage() const override
     { return GLOBAL; }
 };
@@ -2004,7 +2008,8 @@ bool HostsModule::end(const char* fqn, int idx, SnortConfig* sc)
     if ( idx && !strcmp(fqn, "hosts.services") )
     {
         bool updated = false;
-        host->update_service(service.port, service.ipproto, service.snort_protocol_id, updated);
+        host->update_service(service.port, service.ipproto, service.snort_protocol_id, updated,
+            sc->get_max_services_per_host());
         service.reset();
     }
     else if ( idx && !strcmp(fqn, "hosts") )
@@ -32,6 +32,7 @@
 #include "detection/detection_engine.h"
 #include "detection/fp_config.h"
 #include "detection/fp_create.h"
+#include "detection/regex_offload.h"
 #include "dump_config/json_config_output.h"
 #include "dump_config/text_config_output.h"
 #include "file_api/file_service.h"
@@ -456,7 +457,7 @@ void SnortConfig::merge(const SnortConfig* cmd_line_conf)
 
     // Initialize the slotted state memory for threads
     assert(!state);
-    num_slots = offload_threads + ThreadConfig::get_instance_max();
+    num_slots = ThreadRegexOffload::get_num_slots(ThreadConfig::get_instance_max(), offload_threads);
     state = new std::vector<void*>[num_slots];
 }
 
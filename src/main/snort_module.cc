@@ -1155,9 +1155,6 @@ bool SnortModule::set(const char*, Value& v, SnortConfig* sc)
 
 bool SnortModule::end(const char*, int, SnortConfig* sc)
 {
-    if ( sc->offload_threads and ThreadConfig::get_instance_max() != 1 )
-        ParseError("You can not enable experimental offload with more than one packet thread.");
-
     if ( no_warn_flowbits )
     {
         sc->warning_flags &= ~(1 << WARN_FLOWBITS);
@@ -59,13 +59,23 @@ Swapper::~Swapper()
         delete old_conf;
 }
 
+// plugin and inspector setup for the new config is done while the old config is
+// still active, since packets processed before apply() can't reach it
+void Swapper::prepare(Analyzer& analyzer)
+{
+    if ( new_conf and SnortConfig::get_conf() )
+        analyzer.reinit_plugins(new_conf);
+}
+
+// thread state that follows the config (active responses, trace) changes in
+// the same step as the config so no packet sees a mix of old and new
 void Swapper::apply(Analyzer& analyzer)
 {
     if ( new_conf )
     {
         const bool reload = (SnortConfig::get_conf() != nullptr);
         SnortConfig::set_conf(new_conf);
-        // FIXIT-M Determine whether we really want to do this before or after the set_conf
+
         if ( reload )
             analyzer.reinit(new_conf);
     }
@@ -39,6 +39,7 @@ public:
     Swapper();
     ~Swapper();
 
+    void prepare(Analyzer&);
     void apply(Analyzer&);
     void finish(Analyzer&);
     snort::SnortConfig* get_new_conf() { return new_conf; }
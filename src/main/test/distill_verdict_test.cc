@@ -34,13 +34,14 @@
 #include <CppUTest/TestHarness.h>
 #include <CppUTestExt/MockSupport.h>
 
-namespace snort
-{
-int SFDAQInstance::finalize_message(DAQ_Msg_h, DAQ_Verdict verdict)
+int daq_instance_msg_finalize(DAQ_Instance_h, DAQ_Msg_h, DAQ_Verdict verdict)
 {
-    mock().actualCall("finalize_message").onObject(this).withParameter("verdict", verdict);
-    return -1;
+    mock().actualCall("daq_instance_msg_finalize").withParameter("verdict", verdict);
+    return DAQ_SUCCESS;
 }
+
+namespace snort
+{
 void DeferredTrust::finalize(Active&) { }
 void DeferredTrust::set_deferred_trust(unsigned, bool on)
 {
@@ -51,8 +52,9 @@ void Flow::trust() { }
 SFDAQInstance* SFDAQ::get_local_instance() { return nullptr; }
 }
 
-void memory::MemoryCap::update_allocations(size_t) { }
-void memory::MemoryCap::update_deallocations(size_t) { }
+unsigned memory::MemoryCap::register_tag(const char*) { return 0; }
+void memory::MemoryCap::update_allocations(size_t, unsigned) { }
+void memory::MemoryCap::update_deallocations(size_t, unsigned) { }
 
 using namespace snort;
 
@@ -64,6 +66,7 @@ TEST_GROUP(distill_verdict_tests)
     Packet pkt;
     Flow flow{};
     Active act;
+    SFDAQConfig daq_config;
     SFDAQInstance* di;
     Analyzer* analyzer;
     ActiveAction* active_action;
@@ -73,7 +76,8 @@ TEST_GROUP(distill_verdict_tests)
         pkt.active = &act;
         active_action = nullptr;
         pkt.action = &active_action;
-        di = new SFDAQInstance(nullptr, 0, nullptr);
+        daq_config.set_batch_size(4);
+        di = new SFDAQInstance(nullptr, 0, &daq_config);
         pkt.daq_instance = di;
         analyzer = new Analyzer(di, 0, nullptr);
     }
@@ -90,8 +94,9 @@ TEST(distill_verdict_tests, normal_pass)
     // Normal pass verdict
     pkt.packet_flags = PKT_FROM_CLIENT;
     act.reset();
-    mock().expectNCalls(1, "finalize_message").onObject(di).withParameter("verdict", DAQ_VERDICT_PASS);
+    mock().expectNCalls(1, "daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_PASS);
     analyzer->post_process_packet(&pkt);
+    di->finalize_verdicts();
     mock().checkExpectations();
 }
 
@@ -106,8 +111,9 @@ TEST(distill_verdict_tests, trust_session_whitelist_on_blocked)
     act.reset();
     act.drop_packet(&pkt, true);
     act.trust_session(&pkt);
-    mock().expectNCalls(1, "finalize_message").onObject(di).withParameter("verdict", DAQ_VERDICT_BLOCK);
+    mock().expectNCalls(1, "daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_BLOCK);
     analyzer->post_process_packet(&pkt);
+    di->finalize_verdicts();
     mock().checkExpectations();
 }
 
@@ -121,8 +127,9 @@ TEST(distill_verdict_tests, trust_session_whitelist)
     flow.flow_state = Flow::FlowState::INSPECT;
     act.reset();
     act.trust_session(&pkt);
-    mock().expectNCalls(1, "finalize_message").onObject(di).withParameter("verdict", DAQ_VERDICT_WHITELIST);
+    mock().expectNCalls(1, "daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_WHITELIST);
     analyzer->post_process_packet(&pkt);
+    di->finalize_verdicts();
     mock().checkExpectations();
 }
 
@@ -135,8 +142,9 @@ TEST(distill_verdict_tests, flow_state_whitelist)
     flow.ssn_state.ignore_direction = SSN_DIR_NONE;
     flow.flow_state = Flow::FlowState::ALLOW;
     act.reset();
-    mock().expectNCalls(1, "finalize_message").onObject(di).withParameter("verdict", DAQ_VERDICT_WHITELIST);
+    mock().expectNCalls(1, "daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_WHITELIST);
     analyzer->post_process_packet(&pkt);
+    di->finalize_verdicts();
     mock().checkExpectations();
     CHECK_TEXT(!flow.flags.disable_inspect, "Disable inspection should not have been called");
 }
@@ -150,8 +158,9 @@ TEST(distill_verdict_tests, ignore_both_whitelist)
     flow.ssn_state.ignore_direction = SSN_DIR_BOTH;
     flow.flow_state = Flow::FlowState::INSPECT;
     act.reset();
-    mock().expectNCalls(1, "finalize_message").onObject(di).withParameter("verdict", DAQ_VERDICT_WHITELIST);
+    mock().expectNCalls(1, "daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_WHITELIST);
     analyzer->post_process_packet(&pkt);
+    di->finalize_verdicts();
     mock().checkExpectations();
     CHECK_TEXT(!flow.flags.disable_inspect, "Disable inspection should not have been called");
 }
@@ -166,9 +175,57 @@ TEST(distill_verdict_tests, deferred_trust_prevent_whitelist)
     flow.flow_state = Flow::FlowState::ALLOW;
     flow.set_deferred_trust(53, true);
     act.reset();
-    mock().expectNCalls(1, "finalize_message").onObject(di).withParameter("verdict", DAQ_VERDICT_PASS);
+    mock().expectNCalls(1, "daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_PASS);
+    analyzer->post_process_packet(&pkt);
+    di->finalize_verdicts();
+    mock().checkExpectations();
+}
+
+TEST(distill_verdict_tests, held_packet_keeps_order)
+{
+    // A held packet released mid batch must not pass verdicts deferred ahead of it
+    pkt.flow = nullptr;
+    pkt.packet_flags = PKT_FROM_CLIENT;
+    mock().strictOrder();
+    mock().expectOneCall("daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_PASS);
+    mock().expectOneCall("daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_BLOCK);
+    mock().expectOneCall("daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_PASS);
+    act.reset();
     analyzer->post_process_packet(&pkt);
+    analyzer->finalize_daq_message(nullptr, DAQ_VERDICT_BLOCK);
+    act.reset();
+    analyzer->post_process_packet(&pkt);
+    di->finalize_verdicts();
+    mock().checkExpectations();
+}
+
+TEST(distill_verdict_tests, full_batch_submits_in_order)
+{
+    // Deferring past the batch size submits the full batch before the next verdict is held
+    pkt.flow = nullptr;
+    pkt.packet_flags = PKT_FROM_CLIENT;
+    daq_stats.verdict_batches = 0;
+    daq_stats.verdict_max_batch = 0;
+    mock().strictOrder();
+    mock().expectOneCall("daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_PASS);
+    mock().expectOneCall("daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_BLOCK);
+    mock().expectOneCall("daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_PASS);
+    mock().expectOneCall("daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_BLOCK);
+    mock().expectOneCall("daq_instance_msg_finalize").withParameter("verdict", DAQ_VERDICT_PASS);
+    for (unsigned i = 0; i < 5; i++)
+        di->defer_verdict(nullptr, (i % 2) ? DAQ_VERDICT_BLOCK : DAQ_VERDICT_PASS);
+    CHECK_EQUAL(1u, daq_stats.verdict_batches);
+    CHECK_EQUAL(4u, daq_stats.verdict_max_batch);
+    CHECK_EQUAL(4u, di->get_pool_available());
+    di->finalize_verdicts();
     mock().checkExpectations();
+    CHECK_EQUAL(2u, daq_stats.verdict_batches);
+    CHECK_EQUAL(4u, daq_stats.verdict_max_batch);
+    CHECK_EQUAL(5u, di->get_pool_available());
+
+    // Nothing deferred means nothing to submit
+    di->finalize_verdicts();
+    CHECK_EQUAL(2u, daq_stats.verdict_batches);
 }
 
 //-------------------------------------------------------------------------
@@ -17,6 +17,8 @@
 //--------------------------------------------------------------------------
 // stubs.h author Ron Dempster <rdempste@cisco.com>
 
+#include <daq.h>
+
 #include "detection/context_switcher.h"
 #include "detection/detection_engine.h"
 #include "detection/detection_util.h"
@@ -38,6 +40,7 @@
 #include "managers/inspector_manager.h"
 #include "managers/ips_manager.h"
 #include "managers/module_manager.h"
+#include "managers/plugin_manager.h"
 #include "main.h"
 #include "main/analyzer.h"
 #include "main/oops_handler.h"
@@ -48,10 +51,13 @@
 #include "network_inspectors/packet_tracer/packet_tracer.h"
 #include "packet_io/active.h"
 #include "packet_io/sfdaq.h"
+#include "packet_io/sfdaq_config.h"
 #include "packet_io/sfdaq_instance.h"
 #include "packet_io/sfdaq_module.h"
 #include "profiler/profiler.h"
 #include "profiler/profiler_defs.h"
+#include "protocols/ipv4.h"
+#include "protocols/layer.h"
 #include "protocols/packet.h"
 #include "protocols/packet_manager.h"
 #include "side_channel/side_channel.h"
@@ -67,6 +73,7 @@ THREAD_LOCAL DAQStats daq_stats;
 void Profiler::start() { }
 void Profiler::stop(uint64_t) { }
 void Profiler::consolidate_stats() { }
+void Swapper::prepare(Analyzer&) { }
 void Swapper::apply(Analyzer&) { }
 Swapper::~Swapper() = default;
 void OopsHandler::tinit() { }
@@ -103,6 +110,7 @@ void IpsManager::clear_options(const snort::SnortConfig*) { }
 void ActionManager::thread_init(const snort::SnortConfig*) { }
 void ActionManager::thread_term() { }
 void ActionManager::thread_reinit(const snort::SnortConfig*) { }
+const snort::BaseApi* PluginManager::get_api(PlugType, const char*) { return nullptr; }
 int SFRF_Alloc(unsigned int) { return -1; }
 void packet_time_update(const struct timeval*) { }
 void main_poke(unsigned) { }
@@ -115,6 +123,40 @@ eth_t* eth_open(const char*) { return nullptr; }
 eth_t* eth_close(eth_t*) { return nullptr; }
 ssize_t eth_send(eth_t*, const void*, size_t) { return -1; }
 void HostAttributesManager::initialize() { }
+void HostAttributesManager::flush_updates() { }
+void HostAttributesManager::thread_term() { }
+SFDAQConfig::SFDAQConfig() : batch_size(BATCH_SIZE_UNSET), mru_size(SNAPLEN_UNSET),
+    timeout(TIMEOUT_DEFAULT) { }
+SFDAQConfig::~SFDAQConfig() = default;
+void SFDAQConfig::set_batch_size(uint32_t n) { batch_size = n; }
+
+// libdaq, less daq_instance_msg_finalize() which the tests mock
+int daq_config_set_input(DAQ_Config_h, const char*) { return DAQ_ERROR; }
+unsigned daq_config_get_total_instances(DAQ_Config_h) { return 0; }
+int daq_config_set_instance_id(DAQ_Config_h, unsigned) { return DAQ_ERROR; }
+int daq_instance_instantiate(DAQ_Config_h, DAQ_Instance_h*, char*, size_t) { return DAQ_ERROR; }
+int daq_instance_destroy(DAQ_Instance_h) { return DAQ_ERROR; }
+int daq_instance_set_filter(DAQ_Instance_h, const char*) { return DAQ_ERROR; }
+int daq_instance_start(DAQ_Instance_h) { return DAQ_ERROR; }
+int daq_instance_stop(DAQ_Instance_h) { return DAQ_ERROR; }
+int daq_instance_interrupt(DAQ_Instance_h) { return DAQ_ERROR; }
+int daq_instance_ioctl(DAQ_Instance_h, DAQ_IoctlCmd, void*, size_t) { return DAQ_ERROR_NOTSUP; }
+const char* daq_instance_get_error(DAQ_Instance_h) { return nullptr; }
+int daq_instance_get_stats(DAQ_Instance_h, DAQ_Stats_t*) { return DAQ_ERROR; }
+int daq_instance_get_datalink_type(DAQ_Instance_h) { return 0; }
+uint32_t daq_instance_get_capabilities(DAQ_Instance_h) { return 0; }
+DAQ_State daq_instance_check_status(DAQ_Instance_h) { return DAQ_STATE_UNKNOWN; }
+int daq_instance_config_load(DAQ_Instance_h, void**) { return DAQ_ERROR; }
+int daq_instance_config_swap(DAQ_Instance_h, void*, void**) { return DAQ_ERROR; }
+int daq_instance_config_free(DAQ_Instance_h, void*) { return DAQ_ERROR; }
+unsigned daq_instance_msg_receive(DAQ_Instance_h, unsigned, DAQ_Msg_h*, DAQ_RecvStatus* rstat)
+{
+    *rstat = DAQ_RSTAT_ERROR;
+    return 0;
+}
+int daq_instance_get_msg_pool_info(DAQ_Instance_h, DAQ_MsgPoolInfo_t*) { return DAQ_ERROR; }
+int daq_instance_inject_relative(DAQ_Instance_h, DAQ_Msg_h, const uint8_t*, uint32_t, int)
+{ return DAQ_ERROR; }
 
 namespace snort
 {
@@ -137,23 +179,12 @@ Packet::~Packet()  = default;
 IpsPolicy* get_ips_policy() { return nullptr; }
 void DataBus::publish(const char*, Packet*, Flow*) { }
 void DataBus::publish(const char*, DataEvent&, Flow*) { }
-SFDAQInstance::SFDAQInstance(const char*, unsigned, const SFDAQConfig*) { }
-SFDAQInstance::~SFDAQInstance() = default;
-void SFDAQInstance::reload() { }
-bool SFDAQInstance::start() { return false; }
-bool SFDAQInstance::stop() { return false; }
-const char* SFDAQInstance::get_error() { return nullptr; }
-bool SFDAQInstance::interrupt() { return false; }
-int SFDAQInstance::inject(DAQ_Msg_h, int, const uint8_t*, uint32_t) { return -1; }
-DAQ_RecvStatus SFDAQInstance::receive_messages(unsigned) { return DAQ_RSTAT_ERROR; }
-int SFDAQInstance::ioctl(DAQ_IoctlCmd, void*, size_t) { return -4; }
 void SFDAQ::set_local_instance(SFDAQInstance*) { }
 const char* SFDAQ::verdict_to_string(DAQ_Verdict) { return nullptr; }
 bool SFDAQ::forwarding_packet(const DAQ_PktHdr_t*) { return false; }
 int SFDAQ::inject(DAQ_Msg_h, int, const uint8_t*, uint32_t) { return -1; }
 bool SFDAQ::can_inject() { return false; }
 bool SFDAQ::can_inject_raw() { return false; }
-int SFDAQInstance::set_packet_verdict_reason(DAQ_Msg_h, uint8_t) { return 0; }
 DetectionEngine::DetectionEngine() = default;
 DetectionEngine::~DetectionEngine() = default;
 void DetectionEngine::onload() { }
@@ -168,6 +199,15 @@ void DetectionEngine::clear_replacement() { }
 void DetectionEngine::disable_all(Packet*) { }
 unsigned get_instance_id() { return 0; }
 const SnortConfig* SnortConfig::get_conf() { return nullptr; }
+uint32_t SnortConfig::logging_flags = 0;
+const gre::GREHdr* layer::get_gre_layer(const Packet*) { return nullptr; }
+const vlan::VlanTagHdr* layer::get_vlan_layer(const Packet*) { return nullptr; }
+const udp::UDPHdr* layer::get_outer_udp_lyr(const Packet* const) { return nullptr; }
+int layer::get_inner_ip_lyr_index(const Packet* const) { return -1; }
+bool layer::set_outer_ip_api(const Packet* const, ip::IpApi&, int8_t&) { return false; }
+void ip::IpApi::set(const IP4Hdr*) { }
+void ip::IpApi::set(const IP6Hdr*) { }
+uint16_t ip::IpId_Next() { return 0; }
 void PacketTracer::thread_init() { }
 void PacketTracer::thread_term() { }
 void PacketTracer::log(const char*, ...) { }
@@ -0,0 +1,106 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// swapper_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "main/analyzer.h"
+#include "main/snort_config.h"
+#include "main/swapper.h"
+#include "managers/inspector_manager.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+// the configs are only compared, never dereferenced
+static uint64_t old_buf[8], new_buf[8];
+static SnortConfig* const old_conf = reinterpret_cast<SnortConfig*>(old_buf);
+static SnortConfig* const new_conf = reinterpret_cast<SnortConfig*>(new_buf);
+
+static const SnortConfig* s_conf = nullptr;
+static const SnortConfig* s_plugins_conf = nullptr;
+static const SnortConfig* s_thread_conf = nullptr;
+
+const SnortConfig* SnortConfig::get_conf() { return s_conf; }
+void SnortConfig::set_conf(const SnortConfig* sc) { s_conf = sc; }
+SnortConfig::~SnortConfig() = default;
+
+void Analyzer::reinit_plugins(const SnortConfig* sc) { s_plugins_conf = sc; }
+void Analyzer::reinit(const SnortConfig* sc) { s_thread_conf = sc; }
+void Analyzer::stop_removed(const SnortConfig*) { }
+void InspectorManager::clear_removed_inspectors(SnortConfig*) { }
+
+// a packet sees the current config and the thread state last set up for one;
+// they must never disagree
+static void process_packet()
+{
+    CHECK(SnortConfig::get_conf() == s_thread_conf);
+}
+
+TEST_GROUP(swapper_tests)
+{
+    alignas(Analyzer) uint8_t analyzer_buf[sizeof(Analyzer)];
+    Analyzer& analyzer = *reinterpret_cast<Analyzer*>(analyzer_buf);
+
+    void setup() override
+    {
+        s_conf = s_thread_conf = old_conf;
+        s_plugins_conf = nullptr;
+    }
+};
+
+TEST(swapper_tests, packet_between_steps)
+{
+    Swapper* ps = new Swapper(new_conf);
+
+    ps->prepare(analyzer);
+    CHECK(s_plugins_conf == new_conf);
+    CHECK(s_conf == old_conf);
+    process_packet();
+
+    ps->apply(analyzer);
+    CHECK(s_conf == new_conf);
+    process_packet();
+
+    ps->finish(analyzer);
+    process_packet();
+    delete ps;
+}
+
+TEST(swapper_tests, startup)
+{
+    s_conf = s_thread_conf = nullptr;
+    Swapper* ps = new Swapper(new_conf);
+
+    // nothing to reinit when there is no config yet; analyzer init does it
+    ps->prepare(analyzer);
+    ps->apply(analyzer);
+    CHECK(s_conf == new_conf);
+    CHECK(s_plugins_conf == nullptr);
+    CHECK(s_thread_conf == nullptr);
+    delete ps;
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
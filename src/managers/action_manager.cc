@@ -288,7 +288,6 @@ void ActionManager::thread_reinit(const SnortConfig* sc)
             tlac.initialized = true;
         }
     }
-    Active::thread_init(sc);
 }
 
 void ActionManager::thread_term()
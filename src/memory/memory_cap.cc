@@ -22,7 +22,10 @@
 #include "config.h"
 #endif
 
+#include <atomic>
 #include <cassert>
+#include <cstring>
+#include <mutex>
 
 #include "memory_cap.h"
 
@@ -74,6 +77,17 @@ struct Tracker
 
 static Tracker s_tracker;
 
+// -----------------------------------------------------------------------------
+// tags
+// -----------------------------------------------------------------------------
+
+// these are constant initialized so tags may be registered during static init
+static const char* s_tag_names[MemoryCap::max_tags] = { "other" };
+static std::atomic<unsigned> s_tag_count { 1 };
+static std::mutex s_tag_mutex;
+
+static THREAD_LOCAL size_t s_tag_usage[MemoryCap::max_tags];
+
 // -----------------------------------------------------------------------------
 // helpers
 // -----------------------------------------------------------------------------
@@ -124,6 +138,35 @@ size_t MemoryCap::preemptive_threshold = 0;
 // public interface
 // -----------------------------------------------------------------------------
 
+unsigned MemoryCap::register_tag(const char* name)
+{
+    assert(name);
+    std::lock_guard<std::mutex> lock(s_tag_mutex);
+    unsigned n = s_tag_count.load(std::memory_order_relaxed);
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        if ( !strcmp(s_tag_names[i], name) )
+            return i;
+    }
+
+    if ( n == max_tags )
+        return 0;
+
+    s_tag_names[n] = name;
+    s_tag_count.store(n + 1, std::memory_order_release);
+    return n;
+}
+
+unsigned MemoryCap::get_tag_count()
+{ return s_tag_count.load(std::memory_order_acquire); }
+
+const char* MemoryCap::get_tag_name(unsigned tag)
+{ return tag < get_tag_count() ? s_tag_names[tag] : nullptr; }
+
+size_t MemoryCap::get_tag_usage(unsigned tag)
+{ return tag < max_tags ? s_tag_usage[tag] : 0; }
+
 void MemoryCap::free_space(size_t n)
 {
     if ( !is_packet_thread() )
@@ -147,29 +190,37 @@ static size_t fudge_it(size_t n)
     return ((n >> 7) + 1) << 7;
 }
 
-void MemoryCap::update_allocations(size_t n)
+void MemoryCap::update_allocations(size_t n, unsigned tag)
 {
     if (n == 0)
         return;
 
+    assert(tag < max_tags);
+
     size_t k = n;
     n = fudge_it(n);
     free_space(n);
     mem_stats.total_fudge += (n - k);
     s_tracker.allocate(n);
+    s_tag_usage[tag] += n;
     auto in_use = s_tracker.used();
     if ( in_use > mem_stats.max_in_use )
         mem_stats.max_in_use = in_use;
     mp_active_context.update_allocs(n);
 }
 
-void MemoryCap::update_deallocations(size_t n)
+void MemoryCap::update_deallocations(size_t n, unsigned tag)
 {
     if (n == 0)
       return;
 
+    assert(tag < max_tags);
     n = fudge_it(n);
     s_tracker.deallocate(n);
+
+    // allocations may be made on one thread and released on another
+    // (eg after ha) so tag usage is clamped instead of asserted
+    s_tag_usage[tag] = (s_tag_usage[tag] > n) ? s_tag_usage[tag] - n : 0;
     mp_active_context.update_deallocs(n);
 }
 
@@ -303,4 +354,24 @@ TEST_CASE( "memory cap free space", "[memory]" )
     }
 }
 
+TEST_CASE( "memory cap tags", "[memory]" )
+{
+    using memory::MemoryCap;
+
+    SECTION( "tag 0 is the catch all" )
+    {
+        CHECK( !strcmp(MemoryCap::get_tag_name(0), "other") );
+        CHECK( MemoryCap::register_tag("other") == 0 );
+    }
+
+    SECTION( "registration is idempotent" )
+    {
+        unsigned tag = MemoryCap::register_tag("t_memory_cap");
+        CHECK( tag > 0 );
+        CHECK( MemoryCap::register_tag("t_memory_cap") == tag );
+        CHECK( !strcmp(MemoryCap::get_tag_name(tag), "t_memory_cap") );
+        CHECK( MemoryCap::get_tag_name(MemoryCap::get_tag_count()) == nullptr );
+    }
+}
+
 #endif
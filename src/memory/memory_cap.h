@@ -31,11 +31,24 @@ namespace memory
 class SO_PUBLIC MemoryCap
 {
 public:
+    // tags attribute usage to the subsystem doing the accounting.  tag 0 is
+    // the catch all and is returned when the tag table is full.  names must
+    // persist for the life of the process (eg string literals).  registration
+    // is idempotent so a module may register its tag from any thread.
+    static constexpr unsigned max_tags = 32;
+
+    static unsigned register_tag(const char*);
+    static unsigned get_tag_count();
+    static const char* get_tag_name(unsigned);
+
+    // usage by tag for the calling thread
+    static size_t get_tag_usage(unsigned);
+
     static void free_space(size_t);
     // The following functions perform internal rounding. Allocations and deallocations must be
-    // performed in identical increments or leakage may occur.
-    static void update_allocations(size_t);
-    static void update_deallocations(size_t);
+    // performed in identical increments (and with the same tag) or leakage may occur.
+    static void update_allocations(size_t, unsigned tag = 0);
+    static void update_deallocations(size_t, unsigned tag = 0);
 
     static bool over_threshold();
 
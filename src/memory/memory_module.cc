@@ -24,8 +24,20 @@
 
 #include "memory_module.h"
 
+#include <lua.hpp>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "control/control.h"
+#include "log/messages.h"
+#include "main/analyzer_command.h"
 #include "main/snort_config.h"
+#include "main/thread.h"
+#include "sfip/sf_ip.h"
+#include "stream/stream.h"
 
+#include "memory_cap.h"
 #include "memory_config.h"
 
 using namespace snort;
@@ -50,6 +62,95 @@ static const Parameter s_params[] =
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
+//-------------------------------------------------------------------------
+// commands
+//-------------------------------------------------------------------------
+
+class MemoryDump : public AnalyzerCommand
+{
+public:
+    MemoryDump(ControlConn* conn, unsigned n) : ctrlcon(conn), top(n) { }
+    ~MemoryDump() override;
+
+    bool execute(Analyzer&, void**) override;
+    const char* stringify() override { return "MEMORY_DUMP"; }
+
+private:
+    ControlConn* ctrlcon;
+    unsigned top;
+
+    std::mutex lock;
+    std::vector<std::string> reports;
+};
+
+bool MemoryDump::execute(Analyzer&, void**)
+{
+    std::string s = "thread " + std::to_string(get_instance_id()) + ":\n";
+
+    for ( unsigned i = 0; i < memory::MemoryCap::get_tag_count(); ++i )
+    {
+        if ( size_t n = memory::MemoryCap::get_tag_usage(i) )
+        {
+            s += "    ";
+            s += memory::MemoryCap::get_tag_name(i);
+            s += ": " + std::to_string(n) + "\n";
+        }
+    }
+
+    std::vector<std::pair<size_t, Flow*>> flows;
+    Stream::get_top_memory_flows(flows, top);
+
+    for ( const auto& f : flows )
+    {
+        SfIpString cip, sip;
+        f.second->client_ip.ntop(cip);
+        f.second->server_ip.ntop(sip);
+
+        s += "    flow " + std::string(cip) + ":" + std::to_string(f.second->client_port) +
+            " -> " + std::string(sip) + ":" + std::to_string(f.second->server_port) +
+            " proto " + std::to_string((unsigned)f.second->ip_proto) +
+            ": " + std::to_string(f.first) + "\n";
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    reports.emplace_back(std::move(s));
+    return true;
+}
+
+MemoryDump::~MemoryDump()
+{
+    for ( const auto& s : reports )
+        LogRespond(ctrlcon, "%s", s.c_str());
+}
+
+static int dump(lua_State* L)
+{
+    unsigned top = luaL_optint(L, 1, 10);
+    ControlConn* ctrlcon = ControlConn::query_from_lua(L);
+    main_broadcast_command(new MemoryDump(ctrlcon, top), ctrlcon);
+    return 0;
+}
+
+static const Parameter s_dump_params[] =
+{
+    { "top", Parameter::PT_INT, "0:max32", "10",
+      "number of flows to list per thread, largest first" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
+static const Command s_cmds[] =
+{
+    { "dump", dump, s_dump_params,
+      "dump per thread memory usage by tag and the flows using the most memory" },
+
+    { nullptr, nullptr, nullptr, nullptr }
+};
+
+//-------------------------------------------------------------------------
+// module
+//-------------------------------------------------------------------------
+
 THREAD_LOCAL MemoryCounts mem_stats;
 static MemoryCounts zero_stats = { };
 
@@ -99,6 +200,9 @@ bool MemoryModule::end(const char*, int, SnortConfig*)
 bool MemoryModule::is_active()
 { return configured; }
 
+const Command* MemoryModule::get_commands() const
+{ return s_cmds; }
+
 const PegInfo* MemoryModule::get_pegs() const
 { return mem_pegs; }
 
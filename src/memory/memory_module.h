@@ -48,6 +48,8 @@ public:
     bool set(const char*, snort::Value&, snort::SnortConfig*) override;
     bool end(const char*, int, snort::SnortConfig*) override;
 
+    const snort::Command* get_commands() const override;
+
     Usage get_usage() const override
     { return GLOBAL; }
 
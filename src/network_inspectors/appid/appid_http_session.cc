@@ -39,10 +39,12 @@
 
 using namespace snort;
 
+static const unsigned s_mem_tag = memory::MemoryCap::register_tag("appid");
+
 AppIdHttpSession::AppIdHttpSession(AppIdSession& asd, uint32_t http2_stream_id)
     : asd(asd), http2_stream_id(http2_stream_id)
 {
-    memory::MemoryCap::update_allocations(sizeof(AppIdHttpSession));
+    memory::MemoryCap::update_allocations(sizeof(AppIdHttpSession), s_mem_tag);
 }
 
 AppIdHttpSession::~AppIdHttpSession()
@@ -51,7 +53,7 @@ AppIdHttpSession::~AppIdHttpSession()
         delete meta_data[i];
     if (tun_dest)
         delete tun_dest;
-    memory::MemoryCap::update_deallocations(sizeof(AppIdHttpSession));
+    memory::MemoryCap::update_deallocations(sizeof(AppIdHttpSession), s_mem_tag);
 }
 
 void AppIdHttpSession::free_chp_matches(ChpMatchDescriptor& cmd, unsigned num_matches)
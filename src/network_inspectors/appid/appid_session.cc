@@ -30,6 +30,7 @@
 #include "flow/flow_stash.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
+#include "memory/memory_cap.h"
 #include "managers/inspector_manager.h"
 #include "profiler/profiler.h"
 #include "protocols/packet.h"
@@ -56,6 +57,8 @@ unsigned AppIdSession::inspector_id = 0;
 std::mutex AppIdSession::inferred_svcs_lock;
 uint16_t AppIdSession::inferred_svcs_ver = 0;
 
+static const unsigned s_mem_tag = memory::MemoryCap::register_tag("appid");
+
 const uint8_t* service_strstr(const uint8_t* haystack, unsigned haystack_len,
     const uint8_t* needle, unsigned needle_len)
 {
@@ -132,6 +135,7 @@ AppIdSession::AppIdSession(IpProtocol proto, const SfIp* ip, uint16_t port,
         odp_ctxt_version(odp_ctxt.get_version()),
         tp_appid_ctxt(pkt_thread_tp_appid_ctxt)
 {
+    set_memory_tag(s_mem_tag);
     appid_stats.total_sessions++;
 }
 
@@ -45,46 +45,20 @@ static THREAD_LOCAL AppIdStatistics* appid_stats_manager = nullptr;
 
 void AppIdStatistics::end_stats_period()
 {
-    SF_LIST* bucketList = log_buckets;
-    log_buckets = curr_buckets;
-    curr_buckets = bucketList;
+    log_buckets.swap(curr_buckets);
 }
 
 StatsBucket* AppIdStatistics::get_stats_bucket(time_t start_time)
 {
-    StatsBucket* bucket = nullptr;
+    auto it = curr_buckets.lower_bound(start_time);
 
-    if ( !curr_buckets )
-        curr_buckets = sflist_new();
-
-    SF_LNODE* l_node = nullptr;
-    StatsBucket* l_bucket = nullptr;
-
-    for ( l_bucket = (StatsBucket*)sflist_first(curr_buckets, &l_node); l_node && l_bucket;
-        l_bucket = (StatsBucket*)sflist_next(&l_node) )
-    {
-        if (start_time == l_bucket->start_time)
-        {
-            bucket = l_bucket;
-            break;
-        }
-        else if (start_time < l_bucket->start_time)
-        {
-            bucket = new StatsBucket;
-            bucket->start_time = start_time;
-            sflist_add_before(curr_buckets, l_node, bucket);
-            break;
-        }
-    }
-
-    if ( !l_node )
+    if ( it == curr_buckets.end() or it->first != start_time )
     {
-        bucket = new StatsBucket;
-        bucket->start_time = start_time;
-        sflist_add_tail(curr_buckets, bucket);
+        it = curr_buckets.emplace_hint(it, start_time, StatsBucket());
+        it->second.start_time = start_time;
     }
 
-    return bucket;
+    return &it->second;
 }
 
 void AppIdStatistics::open_stats_log_file()
@@ -94,19 +68,19 @@ void AppIdStatistics::open_stats_log_file()
 
 void AppIdStatistics::dump_statistics()
 {
-    if ( !log_buckets )
+    if ( log_buckets.empty() )
         return;
 
     if ( !log )
         open_stats_log_file();
 
-    struct StatsBucket* bucket = nullptr;
-
-    while ((bucket = (struct StatsBucket*)sflist_remove_head(log_buckets)) != nullptr)
+    for ( auto& entry : log_buckets )
     {
-        if ( bucket->app_record_cnt )
+        StatsBucket& bucket = entry.second;
+
+        if ( bucket.app_record_cnt )
         {
-            for (auto it : bucket->apps_tree)
+            for (auto& it : bucket.apps_tree)
             {
                 struct AppIdStatRecord& record = it.second;
 
@@ -115,8 +89,8 @@ void AppIdStatistics::dump_statistics()
                     packet_time(), record.app_name.c_str(), record.initiator_bytes, record.responder_bytes);
             }
         }
-        delete bucket;
     }
+    log_buckets.clear();
 }
 
 AppIdStatistics::AppIdStatistics(const AppIdConfig& config)
@@ -141,18 +115,6 @@ AppIdStatistics::~AppIdStatistics()
 
     if ( log )
         TextLog_Term(log);
-
-    if ( log_buckets )
-        snort_free(log_buckets);
-
-    if ( curr_buckets )
-    {
-        while (auto bucket = (StatsBucket*)sflist_remove_head(curr_buckets))
-        {
-            delete bucket;
-        }
-        snort_free(curr_buckets);
-    }
 }
 
 AppIdStatistics* AppIdStatistics::initialize_manager(const AppIdConfig& config)
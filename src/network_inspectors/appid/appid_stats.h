@@ -26,7 +26,6 @@
 #include <ctime>
 #include <map>
 
-#include "utils/sflsq.h"
 #include "utils/util.h"
 
 #include "application_ids.h"
@@ -47,7 +46,7 @@ struct AppIdStatRecord
 
 struct StatsBucket
 {
-    uint32_t start_time = 0;
+    time_t start_time = 0;
     std::map<AppId, AppIdStatRecord> apps_tree;
     struct
     {
@@ -89,8 +88,9 @@ private:
     void dump_statistics();
 
     bool enabled = false;
-    SF_LIST* curr_buckets = nullptr;
-    SF_LIST* log_buckets = nullptr;
+    // buckets ordered by start time
+    std::map<time_t, StatsBucket> curr_buckets;
+    std::map<time_t, StatsBucket> log_buckets;
     struct TextLog* log = nullptr;
     time_t bucket_start = 0;
     time_t bucket_interval = 0;
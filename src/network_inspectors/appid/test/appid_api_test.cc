@@ -48,8 +48,8 @@ using namespace snort;
 
 static SnortProtocolId dummy_http2_protocol_id = 1;
 
-void memory::MemoryCap::update_allocations(size_t) { }
-void memory::MemoryCap::update_deallocations(size_t) { }
+void memory::MemoryCap::update_allocations(size_t, unsigned) { }
+void memory::MemoryCap::update_deallocations(size_t, unsigned) { }
 
 namespace snort
 {
@@ -37,8 +37,8 @@
 
 // Mocks
 
-void memory::MemoryCap::update_allocations(size_t) { }
-void memory::MemoryCap::update_deallocations(size_t) { }
+void memory::MemoryCap::update_allocations(size_t, unsigned) { }
+void memory::MemoryCap::update_deallocations(size_t, unsigned) { }
 
 namespace snort
 {
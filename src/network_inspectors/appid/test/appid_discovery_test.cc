@@ -41,8 +41,8 @@
 
 uint32_t ThirdPartyAppIdContext::next_version = 0;
 
-void memory::MemoryCap::update_allocations(size_t) { }
-void memory::MemoryCap::update_deallocations(size_t) { }
+void memory::MemoryCap::update_allocations(size_t, unsigned) { }
+void memory::MemoryCap::update_deallocations(size_t, unsigned) { }
 
 namespace snort
 {
@@ -49,8 +49,8 @@ void ApplicationDescriptor::set_id(const Packet&, AppIdSession&, AppidSessionDir
 
 using namespace snort;
 
-void memory::MemoryCap::update_allocations(size_t) { }
-void memory::MemoryCap::update_deallocations(size_t) { }
+void memory::MemoryCap::update_allocations(size_t, unsigned) { }
+void memory::MemoryCap::update_deallocations(size_t, unsigned) { }
 
 namespace snort
 {
@@ -165,8 +165,9 @@ void Profiler::consolidate_stats() { }
 void Profiler::reset_stats() { }
 void Profiler::show_stats() { }
 
-void memory::MemoryCap::update_allocations(size_t) { }
-void memory::MemoryCap::update_deallocations(size_t) { }
+unsigned memory::MemoryCap::register_tag(const char*) { return 0; }
+void memory::MemoryCap::update_allocations(size_t, unsigned) { }
+void memory::MemoryCap::update_deallocations(size_t, unsigned) { }
 
 OdpContext::OdpContext(const AppIdConfig&, snort::SnortConfig*) { }
 
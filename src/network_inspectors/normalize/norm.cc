@@ -23,6 +23,7 @@
 
 #include "norm.h"
 
+#include "codecs/ip/checksum.h"
 #include "detection/ips_context.h"
 #include "main/snort_config.h"
 #include "packet_io/sfdaq.h"
@@ -58,6 +59,8 @@ enum PegCounts
     PC_TCP_REQ_URG,
     PC_TCP_REQ_PAY,
     PC_TCP_REQ_URP,
+    PC_PACKETS,
+    PC_CKSUM_ADJUST,
     PC_MAX
 };
 
@@ -85,6 +88,9 @@ const PegInfo norm_names[] =
     { CountType::SUM, "tcp_req_pay",
         "cleared urgent pointer and urgent flag when there is no payload" },
     { CountType::SUM, "tcp_req_urp", "cleared the urgent flag if the urgent pointer is not set" },
+    { CountType::SUM, "packets", "packets with normalizations" },
+    { CountType::SUM, "cksum_adjusts",
+        "normalized packets with checksums adjusted in place instead of recomputed" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -122,10 +128,15 @@ int Norm_Packet(NormalizerConfig* c, Packet* p)
 
     if ( changes > 0 )
     {
-        p->packet_flags |= PKT_MODIFIED;
+        PacketManager::header_modified(p);
+        normStats[PC_PACKETS][NORM_MODE_ON]++;
+
+        if ( !(p->packet_flags & (PKT_RESIZED|PKT_MODIFIED)) )
+            normStats[PC_CKSUM_ADJUST][NORM_MODE_ON]++;
+
         return 1;
     }
-    if ( p->packet_flags & (PKT_RESIZED|PKT_MODIFIED) )
+    if ( p->packet_flags & (PKT_RESIZED|PKT_MODIFIED|PKT_HDR_MODIFIED) )
     {
         return 1;
     }
@@ -138,9 +149,12 @@ int Norm_Packet(NormalizerConfig* c, Packet* p)
 // avoided to ensure that we don't get tripped up by nested protocols.
 // TCP options count and length are a notable exception.
 //
-// also note that checksums are not calculated here.  they are only
-// calculated once after all normalizations are done (here, stream)
-// and any replacements are made.
+// also note that checksums are not calculated here.  each layer makes
+// all of its edits and then adjusts its own checksum once from a copy
+// of the original header.  the pseudoheader fields are never edited so
+// the transport checksums don't depend on the ip edits.  full checksums
+// are only calculated after all normalizations (here, stream) and any
+// replacements if the packet is resized, replaced, or tunneled.
 //-----------------------------------------------------------------------
 
 #if 0
@@ -182,6 +196,11 @@ static int Norm_IP4(
     uint16_t origbits = fragbits;
     const NormMode mode = get_norm_mode(p);
 
+    uint8_t orig[ip::IP4_MAX_HEADER_LEN];
+    uint16_t hlen = p->layers[layer].length;
+    memcpy(orig, h, hlen);
+    int prior = changes;
+
     if ( Norm_IsEnabled(c, NORM_IP4_TRIM) && (layer == 1) )
     {
         uint32_t len = p->layers[0].length + ntohs(h->ip_len);
@@ -271,6 +290,9 @@ static int Norm_IP4(
         }
         normStats[PC_IP4_OPTS][mode]++;
     }
+    if ( changes > prior )
+        h->ip_csum = checksum::adjust(h->ip_csum, orig, h, hlen);
+
     return changes;
 }
 
@@ -287,7 +309,10 @@ static int Norm_ICMP4(
     {
         if ( mode == NORM_MODE_ON )
         {
+            uint8_t orig[4];   // type, code, csum
+            memcpy(orig, h, sizeof(orig));
             h->code = icmp::IcmpCode::ECHO_CODE;
+            h->csum = checksum::adjust(h->csum, orig, h, sizeof(orig));
             changes++;
         }
         normStats[PC_ICMP4_ECHO][mode]++;
@@ -336,7 +361,10 @@ static int Norm_ICMP6(
 
         if ( mode == NORM_MODE_ON )
         {
+            uint8_t orig[4];   // type, code, csum
+            memcpy(orig, h, sizeof(orig));
             h->code = static_cast<icmp::IcmpCode>(0);
+            h->csum = checksum::adjust(h->csum, orig, h, sizeof(orig));
             changes++;
         }
         normStats[PC_ICMP6_ECHO][mode]++;
@@ -503,6 +531,11 @@ static int Norm_TCP(
     tcp::TCPHdr* h = reinterpret_cast<tcp::TCPHdr*>(const_cast<uint8_t*>(p->layers[layer].start));
     const NormMode mode = get_norm_mode(p);
 
+    uint8_t orig[tcp::TCP_MAX_HEADER_LEN];
+    uint16_t hlen = h->hlen();
+    memcpy(orig, h, hlen);
+    int prior = changes;
+
     if ( Norm_IsEnabled(c, NORM_TCP_RSV) )
     {
         if ( h->th_offx2 & TH_RSV )
@@ -609,6 +642,9 @@ static int Norm_TCP(
                 tcp_options_len, valid_opts_len, changes);
         }
     }
+    if ( changes > prior )
+        h->th_sum = checksum::adjust(h->th_sum, orig, h, hlen);
+
     return changes;
 }
 
@@ -0,0 +1,217 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// norm_test.cc - checksum handling of header normalizations
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+
+#include "codecs/ip/checksum.h"
+#include "main/policy.h"
+#include "packet_io/sfdaq.h"
+#include "protocols/ipv4.h"
+#include "protocols/packet.h"
+#include "protocols/tcp.h"
+
+#include "normalize/norm.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// mocks
+//--------------------------------------------------------------------------
+static std::array<ProtocolIndex, num_protocol_ids> proto_map()
+{
+    std::array<ProtocolIndex, num_protocol_ids> map { { 0 } };
+    map[to_utype(ProtocolId::ETHERTYPE_IPV4)] = 1;
+    map[to_utype(ProtocolId::TCP)] = 2;
+    return map;
+}
+
+std::array<ProtocolIndex, num_protocol_ids> CodecManager::s_proto_map = proto_map();
+
+DataBus::DataBus() = default;
+DataBus::~DataBus() = default;
+
+InspectionPolicy::InspectionPolicy(unsigned) { }
+InspectionPolicy::~InspectionPolicy() = default;
+
+static InspectionPolicy* s_inspection_policy = nullptr;
+
+namespace snort
+{
+InspectionPolicy* get_inspection_policy()
+{ return s_inspection_policy; }
+
+NetworkPolicy* get_network_policy()
+{ return nullptr; }
+
+bool SFDAQ::forwarding_packet(const DAQ_PktHdr_t*)
+{ return true; }
+
+Packet::Packet(bool)
+{
+    layers = new Layer[4];
+    num_layers = 0;
+    packet_flags = 0;
+    pkth = nullptr;
+    context = nullptr;
+    dsize = 0;
+}
+
+Packet::~Packet()
+{ delete[] layers; }
+
+// only the encapsulation check is skipped; see the packet manager tests
+void PacketManager::header_modified(Packet* p)
+{ p->packet_flags |= PKT_HDR_MODIFIED; }
+}
+
+//--------------------------------------------------------------------------
+// tests
+//--------------------------------------------------------------------------
+#define PAYLOAD_LEN 8
+
+TEST_GROUP(norm_checksum)
+{
+    InspectionPolicy* policy = nullptr;
+    NormalizerConfig nc;
+    DAQ_PktHdr_t pkth;
+    Packet* p = nullptr;
+
+    uint8_t raw[ip::IP4_HEADER_LEN + tcp::TCP_MIN_HEADER_LEN + PAYLOAD_LEN];
+    ip::IP4Hdr* iph = (ip::IP4Hdr*)raw;
+    tcp::TCPHdr* tcph = (tcp::TCPHdr*)(raw + ip::IP4_HEADER_LEN);
+
+    void setup() override
+    {
+        policy = new InspectionPolicy;
+        policy->policy_mode = POLICY_MODE__INLINE;
+        s_inspection_policy = policy;
+
+        memset(&nc, 0, sizeof(nc));
+        Norm_Enable(&nc, NORM_IP4_BASE);
+        Norm_Enable(&nc, NORM_IP4_TOS);
+        Norm_Enable(&nc, NORM_TCP_RSV);
+        Norm_Enable(&nc, NORM_TCP_ECN_PKT);
+        Norm_SetConfig(&nc);
+
+        memset(raw, 0, sizeof(raw));
+        iph->ip_verhl = 0x45;
+        iph->ip_tos = 0x10;
+        iph->ip_len = htons(sizeof(raw));
+        iph->ip_ttl = 64;
+        iph->ip_proto = IpProtocol::TCP;
+        iph->ip_src = htonl(0x0a000001);
+        iph->ip_dst = htonl(0x0a000002);
+
+        tcph->th_sport = htons(1234);
+        tcph->th_dport = htons(80);
+        tcph->th_seq = htonl(0x01020304);
+        tcph->th_offx2 = (tcp::TCP_MIN_HEADER_LEN / 4) << 4 | TH_RSV;
+        tcph->th_flags = TH_ACK | TH_ECE;
+        tcph->th_win = htons(8192);
+        memset(raw + ip::IP4_HEADER_LEN + tcp::TCP_MIN_HEADER_LEN, 'x', PAYLOAD_LEN);
+
+        iph->ip_csum = ip_cksum();
+        tcph->th_sum = tcp_cksum();
+
+        memset(&pkth, 0, sizeof(pkth));
+        p = new Packet(false);
+        p->pkth = &pkth;
+        p->dsize = PAYLOAD_LEN;
+        p->layers[0] = { raw, ProtocolId::ETHERTYPE_IPV4, ip::IP4_HEADER_LEN };
+        p->layers[1] = { raw + ip::IP4_HEADER_LEN, ProtocolId::TCP, tcp::TCP_MIN_HEADER_LEN };
+        p->num_layers = 2;
+    }
+
+    void teardown() override
+    {
+        delete p;
+        delete policy;
+        s_inspection_policy = nullptr;
+    }
+
+    uint16_t ip_cksum()
+    {
+        uint16_t save = iph->ip_csum;
+        iph->ip_csum = 0;
+        uint16_t sum = checksum::ip_cksum((uint16_t*)iph, ip::IP4_HEADER_LEN);
+        iph->ip_csum = save;
+        return sum;
+    }
+
+    uint16_t tcp_cksum()
+    {
+        checksum::Pseudoheader ph;
+        ph.hdr.sip = iph->ip_src;
+        ph.hdr.dip = iph->ip_dst;
+        ph.hdr.zero = 0;
+        ph.hdr.protocol = IpProtocol::TCP;
+        ph.hdr.len = htons(tcp::TCP_MIN_HEADER_LEN + PAYLOAD_LEN);
+
+        uint16_t save = tcph->th_sum;
+        tcph->th_sum = 0;
+        uint16_t sum = checksum::tcp_cksum(
+            (uint16_t*)tcph, tcp::TCP_MIN_HEADER_LEN + PAYLOAD_LEN, ph);
+        tcph->th_sum = save;
+        return sum;
+    }
+};
+
+TEST(norm_checksum, good_checksums_adjusted)
+{
+    CHECK(Norm_Packet(&nc, p) == 1);
+
+    CHECK(iph->ip_tos == 0);
+    CHECK(!(tcph->th_offx2 & TH_RSV));
+    CHECK(!(tcph->th_flags & TH_ECE));
+
+    // edits are done in place without a full update at verdict time
+    CHECK(p->packet_flags & PKT_HDR_MODIFIED);
+    CHECK(!(p->packet_flags & PKT_MODIFIED));
+
+    CHECK(iph->ip_csum == ip_cksum());
+    CHECK(tcph->th_sum == tcp_cksum());
+}
+
+TEST(norm_checksum, bad_checksums_not_repaired)
+{
+    // a full recompute used to fix these on the way out
+    iph->ip_csum ^= 0x1234;
+    tcph->th_sum ^= 0x0101;
+
+    CHECK(Norm_Packet(&nc, p) == 1);
+
+    CHECK(iph->ip_tos == 0);
+    CHECK(!(tcph->th_offx2 & TH_RSV));
+    CHECK(!(p->packet_flags & PKT_MODIFIED));
+
+    CHECK(iph->ip_csum != ip_cksum());
+    CHECK(tcph->th_sum != tcp_cksum());
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -27,6 +27,7 @@
 #include <pcap.h>
 
 #include "framework/inspector.h"
+#include "helpers/bpf_jit.h"
 #include "log/messages.h"
 #include "protocols/packet.h"
 
@@ -51,6 +52,7 @@ static CaptureConfig config;
 static THREAD_LOCAL pcap_t* pcap = nullptr;
 static THREAD_LOCAL pcap_dumper_t* dumper = nullptr;
 static THREAD_LOCAL struct bpf_program bpf;
+static THREAD_LOCAL BpfJit* jit = nullptr;
 
 // -----------------------------------------------------------------------------
 // static functions
@@ -72,6 +74,8 @@ static void _capture_term()
         pcap = nullptr;
     }
     pcap_freecode(&bpf);
+    delete jit;
+    jit = nullptr;
 }
 
 static bool bpf_compile_and_validate()
@@ -82,7 +86,13 @@ static bool bpf_compile_and_validate()
         config.filter.c_str(), 1, 0) >= 0 )
     {
         if (bpf_validate(bpf.bf_insns, bpf.bf_len))
+        {
+            if ( !jit )
+                jit = new BpfJit;
+
+            jit->compile(bpf.bf_insns, bpf.bf_len);
             return true;
+        }
         else
             WarningMessage("Unable to validate BPF filter\n");
     }
@@ -223,8 +233,7 @@ void PacketCapture::eval(Packet* p)
         if ( p->is_cooked() )
             return;
 
-        if ( !bpf.bf_insns || bpf_filter(bpf.bf_insns, p->pkt,
-                p->pktlen, p->pkth->pktlen) )
+        if ( !bpf.bf_insns || jit->filter(p->pkt, p->pktlen, p->pkth->pktlen) )
         {
             write_packet(p);
             cap_count_stats.matched++;
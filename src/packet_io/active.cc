@@ -25,11 +25,13 @@
 
 #include "active.h"
 
+#include "codecs/ip/checksum.h"
 #include "detection/detection_engine.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
 #include "managers/action_manager.h"
 #include "profiler/profiler.h"
+#include "protocols/layer.h"
 #include "protocols/tcp.h"
 #include "pub_sub/active_events.h"
 #include "stream/stream.h"
@@ -40,6 +42,12 @@
 #include "sfdaq_instance.h"
 #include "sfdaq_module.h"
 
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#include "framework/codec.h"
+#include "managers/plugin_manager.h"
+#endif
+
 using namespace snort;
 
 #define MAX_ATTEMPTS 20
@@ -70,6 +78,7 @@ THREAD_LOCAL uint8_t Active::s_attempts = 0;
 THREAD_LOCAL bool Active::s_suspend = false;
 THREAD_LOCAL Active::ActiveSuspendReason Active::s_suspend_reason = Active::ASP_NONE;
 THREAD_LOCAL Active::Counts snort::active_counts;
+THREAD_LOCAL ProfileStats snort::active_perf_stats;
 
 typedef int (* send_t) (
     DAQ_Msg_h msg, int rev, const uint8_t* buf, uint32_t len);
@@ -149,6 +158,45 @@ static uint64_t Strafe(int i, uint64_t flags, const Packet* p)
     return flags;
 }
 
+// the resets sent for the respond attempts differ only in the strafed
+// sequence number and ip id so the first one is encoded and the rest are
+// patched.  tunnels are encoded each time: udp and gre checksums cover the
+// inner headers and outer ip headers need their own fresh ids.
+
+static inline bool can_patch_reset(const Packet* p)
+{
+    if ( layer::get_outer_udp_lyr(p) or layer::get_gre_layer(p) )
+        return false;
+
+    // the outermost ip layer must be the inner one
+    ip::IpApi api;
+    int8_t lyr = 0;
+
+    layer::set_outer_ip_api(p, api, lyr);
+    return lyr - 1 == layer::get_inner_ip_lyr_index(p);
+}
+
+// the encoded reset ends with a bare tcp header, preceded by a bare ip4
+// header if the ip is ip4.  each attempt gets a new random ip id, as an
+// encode would give it.
+static void patch_reset(const Packet* p, uint8_t* rej, uint32_t len, uint32_t seq_adj)
+{
+    tcp::TCPHdr* tcph = reinterpret_cast<tcp::TCPHdr*>(rej + len - tcp::TCP_MIN_HEADER_LEN);
+    uint32_t seq = htonl(ntohl(tcph->th_seq) + seq_adj);
+
+    tcph->th_sum = checksum::adjust(tcph->th_sum, tcph->th_seq, seq);
+    tcph->th_seq = seq;
+
+    if ( !p->ptrs.ip_api.is_ip4() )
+        return;
+
+    ip::IP4Hdr* ip4h = reinterpret_cast<ip::IP4Hdr*>((uint8_t*)tcph - ip::IP4_HEADER_LEN);
+    uint16_t id = ip::IpId_Next();
+
+    ip4h->ip_csum = checksum::adjust(ip4h->ip_csum, ip4h->ip_id, id);
+    ip4h->ip_id = id;
+}
+
 //--------------------------------------------------------------------
 
 void Active::kill_session(Packet* p, EncodeFlags flags)
@@ -214,10 +262,18 @@ void Active::thread_term()
 
 void Active::send_reset(Packet* p, EncodeFlags ef)
 {
+    Profile profile(active_perf_stats);
+
     int i;
     EncodeFlags flags = (GetFlags() | ef) & ~ENC_FLAG_VAL;
     EncodeFlags value = ef & ENC_FLAG_VAL;
 
+    // the encoder's buffer isn't touched again until the next encode
+    uint8_t* rej = nullptr;
+    uint32_t len = 0;
+    uint32_t rej_adj = 0;
+    bool patch = can_patch_reset(p);
+
     for ( i = 0; i < s_attempts; i++ )
     {
         if ( (p->packet_flags & PKT_USE_DIRECT_INJECT) or
@@ -237,17 +293,26 @@ void Active::send_reset(Packet* p, EncodeFlags ef)
         }
         else
         {
-            uint32_t len;
-            const uint8_t* rej;
-
             value = Strafe(i, value, p);
+            uint32_t adj = (uint32_t)(value & ENC_FLAG_VAL);
 
-            rej = PacketManager::encode_response(TcpResponse::RST, flags|value, p, len);
-            if ( !rej )
+            if ( rej and patch )
             {
-                active_counts.failed_injects++;
-                return;
+                patch_reset(p, rej, len, adj - rej_adj);
+                active_counts.patched_injects++;
+            }
+            else
+            {
+                rej = const_cast<uint8_t*>(
+                    PacketManager::encode_response(TcpResponse::RST, flags|value, p, len));
+
+                if ( !rej )
+                {
+                    active_counts.failed_injects++;
+                    return;
+                }
             }
+            rej_adj = adj;
 
             int ret = s_send(p->daq_msg, !(ef & ENC_FLAG_FWD), rej, len);
             if ( ret )
@@ -260,6 +325,8 @@ void Active::send_reset(Packet* p, EncodeFlags ef)
 
 void Active::send_unreach(Packet* p, UnreachResponse type)
 {
+    Profile profile(active_perf_stats);
+
     uint32_t len;
     const uint8_t* rej;
     EncodeFlags flags = GetFlags();
@@ -284,6 +351,8 @@ void Active::send_unreach(Packet* p, UnreachResponse type)
 uint32_t Active::send_data(
     Packet* p, EncodeFlags flags, const uint8_t* buf, uint32_t blen)
 {
+    Profile profile(active_perf_stats);
+
     int ret;
     const uint8_t* seg;
     uint32_t plen;
@@ -458,6 +527,8 @@ uint32_t Active::send_data(
 void Active::inject_data(
     Packet* p, EncodeFlags flags, const uint8_t* buf, uint32_t blen)
 {
+    Profile profile(active_perf_stats);
+
     uint32_t plen;
     const uint8_t* seg;
 
@@ -860,3 +931,215 @@ void Active::send_reason_to_daq(Packet& p)
         p.daq_instance->set_packet_verdict_reason(p.daq_msg, reason);
 }
 
+
+//--------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+// a raw encoded reset: bare ip and tcp headers
+struct RejectBuf
+{
+    alignas(4) uint8_t buf[ip::IP6_HEADER_LEN + tcp::TCP_MIN_HEADER_LEN] = { };
+    uint32_t len;
+    ip::IP4Hdr* ip4h = nullptr;
+    ip::IP6Hdr* ip6h = nullptr;
+    tcp::TCPHdr* tcph;
+
+    RejectBuf(bool ip4)
+    {
+        if ( ip4 )
+        {
+            ip4h = (ip::IP4Hdr*)buf;
+            ip4h->ip_verhl = 0x45;
+            ip4h->ip_len = htons(ip::IP4_HEADER_LEN + tcp::TCP_MIN_HEADER_LEN);
+            ip4h->ip_id = htons(0x1234);
+            ip4h->ip_ttl = 64;
+            ip4h->ip_proto = IpProtocol::TCP;
+            ip4h->ip_src = htonl(0x0a000001);
+            ip4h->ip_dst = htonl(0x0a000002);
+            len = ip::IP4_HEADER_LEN + tcp::TCP_MIN_HEADER_LEN;
+        }
+        else
+        {
+            ip6h = (ip::IP6Hdr*)buf;
+            ip6h->ip6_vtf = htonl(0x60000000);
+            ip6h->ip6_payload_len = htons(tcp::TCP_MIN_HEADER_LEN);
+            ip6h->ip6_next = IpProtocol::TCP;
+            ip6h->ip6_hoplim = 64;
+            memset(&ip6h->ip6_src, 0x11, sizeof(ip6h->ip6_src));
+            memset(&ip6h->ip6_dst, 0x22, sizeof(ip6h->ip6_dst));
+            len = ip::IP6_HEADER_LEN + tcp::TCP_MIN_HEADER_LEN;
+        }
+        tcph = (tcp::TCPHdr*)(buf + len - tcp::TCP_MIN_HEADER_LEN);
+        tcph->th_sport = htons(80);
+        tcph->th_dport = htons(1234);
+        tcph->th_seq = htonl(0xfffffff0);  // strafing wraps
+        tcph->th_ack = htonl(0x01020304);
+        tcph->th_offx2 = (tcp::TCP_MIN_HEADER_LEN / 4) << 4;
+        tcph->th_flags = TH_RST | TH_ACK;
+
+        if ( ip4h )
+            ip4h->ip_csum = ip_sum();
+        tcph->th_sum = tcp_sum();
+    }
+
+    uint16_t ip_sum()
+    {
+        uint16_t save = ip4h->ip_csum;
+        ip4h->ip_csum = 0;
+        uint16_t sum = checksum::ip_cksum((uint16_t*)ip4h, ip::IP4_HEADER_LEN);
+        ip4h->ip_csum = save;
+        return sum;
+    }
+
+    uint16_t tcp_sum()
+    {
+        uint16_t save = tcph->th_sum;
+        uint16_t sum;
+        tcph->th_sum = 0;
+
+        if ( ip4h )
+        {
+            checksum::Pseudoheader ph;
+            ph.hdr.sip = ip4h->ip_src;
+            ph.hdr.dip = ip4h->ip_dst;
+            ph.hdr.zero = 0;
+            ph.hdr.protocol = IpProtocol::TCP;
+            ph.hdr.len = htons(tcp::TCP_MIN_HEADER_LEN);
+            sum = checksum::tcp_cksum((uint16_t*)tcph, tcp::TCP_MIN_HEADER_LEN, ph);
+        }
+        else
+        {
+            checksum::Pseudoheader6 ph;
+            memcpy(ph.hdr.sip, &ip6h->ip6_src, sizeof(ph.hdr.sip));
+            memcpy(ph.hdr.dip, &ip6h->ip6_dst, sizeof(ph.hdr.dip));
+            ph.hdr.zero = 0;
+            ph.hdr.protocol = IpProtocol::TCP;
+            ph.hdr.len = htons(tcp::TCP_MIN_HEADER_LEN);
+            sum = checksum::tcp_cksum((uint16_t*)tcph, tcp::TCP_MIN_HEADER_LEN, ph);
+        }
+        tcph->th_sum = save;
+        return sum;
+    }
+};
+
+// ip ids are drawn from the ipv4 codec's thread state
+static const CodecApi* ipv4_codec()
+{ return (const CodecApi*)PluginManager::get_api(PT_CODEC, "ipv4"); }
+
+TEST_CASE("patch_reset ip4", "[active]")
+{
+    const CodecApi* api = ipv4_codec();
+    REQUIRE(api);
+    api->tinit();
+
+    RejectBuf rej(true);
+    Packet p(false);
+    p.ptrs.ip_api.set(rej.ip4h);
+
+    uint32_t seq = ntohl(rej.tcph->th_seq);
+    uint16_t prev_id = ntohs(rej.ip4h->ip_id);
+    unsigned fresh = 0;
+
+    for ( uint32_t adj : { 1u, 8u, 0u, 0x7fffu, 0xffffffffu, 0x10u, 3u, 0x4000u,
+        2u, 64u, 5u, 0x1000u, 7u, 0x8000u, 9u, 0xffffu } )
+    {
+        patch_reset(&p, rej.buf, rej.len, adj);
+        seq += adj;
+
+        CHECK(ntohl(rej.tcph->th_seq) == seq);
+        CHECK(rej.tcph->th_sum == rej.tcp_sum());
+        CHECK(rej.ip4h->ip_csum == rej.ip_sum());
+
+        // random draws, so allow for the odd repeat but not a bumped id
+        uint16_t id = ntohs(rej.ip4h->ip_id);
+        if ( id != prev_id and id != (uint16_t)(prev_id + 1) )
+            ++fresh;
+        prev_id = id;
+    }
+    CHECK(fresh >= 12);
+    api->tterm();
+}
+
+TEST_CASE("patch_reset ip6", "[active]")
+{
+    RejectBuf rej(false);
+    Packet p(false);
+    p.ptrs.ip_api.set(rej.ip6h);
+
+    uint8_t hdrs[ip::IP6_HEADER_LEN];
+    memcpy(hdrs, rej.buf, sizeof(hdrs));
+    uint32_t seq = ntohl(rej.tcph->th_seq);
+
+    for ( uint32_t adj : { 1u, 0x7fffu, 0u, 0xffffffffu, 0x10u } )
+    {
+        patch_reset(&p, rej.buf, rej.len, adj);
+        seq += adj;
+
+        CHECK(ntohl(rej.tcph->th_seq) == seq);
+        CHECK(rej.tcph->th_sum == rej.tcp_sum());
+    }
+    CHECK(!memcmp(hdrs, rej.buf, sizeof(hdrs)));
+}
+
+static void set_layers(Packet& p, uint8_t* hdr, std::initializer_list<ProtocolId> ids)
+{
+    p.num_layers = 0;
+
+    for ( auto id : ids )
+        p.layers[p.num_layers++] = { hdr, id, 0 };
+}
+
+TEST_CASE("can_patch_reset", "[active]")
+{
+    // only the layer types matter here
+    uint8_t hdr[ip::IP6_HEADER_LEN] = { };
+    Packet p(false);
+
+    SECTION("ip4")
+    {
+        set_layers(p, hdr, { ProtocolId::ETHERNET_802_3, ProtocolId::ETHERTYPE_IPV4,
+            ProtocolId::TCP });
+        CHECK(can_patch_reset(&p));
+    }
+    SECTION("ip6")
+    {
+        set_layers(p, hdr, { ProtocolId::ETHERNET_802_3, ProtocolId::ETHERTYPE_IPV6,
+            ProtocolId::TCP });
+        CHECK(can_patch_reset(&p));
+    }
+    SECTION("vlan")
+    {
+        set_layers(p, hdr, { ProtocolId::ETHERNET_802_3, ProtocolId::ETHERTYPE_8021Q,
+            ProtocolId::ETHERTYPE_IPV4, ProtocolId::TCP });
+        CHECK(can_patch_reset(&p));
+    }
+    // the rest fall back to a full encode for each attempt
+    SECTION("ip in ip")
+    {
+        set_layers(p, hdr, { ProtocolId::ETHERNET_802_3, ProtocolId::ETHERTYPE_IPV4,
+            ProtocolId::IPIP, ProtocolId::TCP });
+        CHECK(!can_patch_reset(&p));
+    }
+    SECTION("6 in 4")
+    {
+        set_layers(p, hdr, { ProtocolId::ETHERNET_802_3, ProtocolId::ETHERTYPE_IPV4,
+            ProtocolId::IPV6, ProtocolId::TCP });
+        CHECK(!can_patch_reset(&p));
+    }
+    SECTION("udp tunnel")
+    {
+        set_layers(p, hdr, { ProtocolId::ETHERNET_802_3, ProtocolId::ETHERTYPE_IPV4,
+            ProtocolId::UDP, ProtocolId::VXLAN, ProtocolId::ETHERNET_802_3,
+            ProtocolId::ETHERTYPE_IPV4, ProtocolId::TCP });
+        CHECK(!can_patch_reset(&p));
+    }
+    SECTION("gre tunnel")
+    {
+        set_layers(p, hdr, { ProtocolId::ETHERNET_802_3, ProtocolId::ETHERTYPE_IPV4,
+            ProtocolId::GRE, ProtocolId::ETHERTYPE_IPV4, ProtocolId::TCP });
+        CHECK(!can_patch_reset(&p));
+    }
+}
+#endif
@@ -29,6 +29,7 @@
 namespace snort
 {
 struct Packet;
+struct ProfileStats;
 struct SnortConfig;
 class ActiveAction;
 
@@ -45,6 +46,7 @@ public:
         PegCount holds_denied;
         PegCount holds_canceled;
         PegCount holds_allowed;
+        PegCount patched_injects;
     };
 
     enum ActiveStatus : uint8_t
@@ -250,6 +252,7 @@ struct SO_PUBLIC ActiveSuspendContext
 };
 
 extern THREAD_LOCAL Active::Counts active_counts;
+extern THREAD_LOCAL ProfileStats active_perf_stats;
 }
 #endif
 
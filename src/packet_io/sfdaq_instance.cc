@@ -30,6 +30,7 @@
 #include "main/snort_config.h"
 #include "protocols/packet.h"
 #include "protocols/vlan.h"
+#include "time/clock_defs.h"
 
 #include "sfdaq_config.h"
 #include "sfdaq_module.h"
@@ -44,11 +45,15 @@ SFDAQInstance::SFDAQInstance(const char* input, unsigned id, const SFDAQConfig*
     instance_id = id + 1;
     batch_size = cfg->get_batch_size();
     daq_msgs = new DAQ_Msg_h[batch_size];
+    verdict_msgs = new DAQ_Msg_h[batch_size];
+    verdicts = new DAQ_Verdict[batch_size];
 }
 
 SFDAQInstance::~SFDAQInstance()
 {
     delete[] daq_msgs;
+    delete[] verdict_msgs;
+    delete[] verdicts;
     if (instance)
         daq_instance_destroy(instance);
 }
@@ -188,13 +193,26 @@ DAQ_RecvStatus SFDAQInstance::receive_messages(unsigned max_recv)
     assert(max_recv <= batch_size);
 
     if (max_recv > pool_available)
+    {
         max_recv = pool_available;
+        daq_stats.pool_exhausted++;
+    }
 
     DAQ_RecvStatus rstat;
     curr_batch_size = daq_instance_msg_receive(instance, max_recv, daq_msgs, &rstat);
     pool_available -= curr_batch_size;
     curr_batch_idx = 0;
 
+    // a thread that keeps up with its traffic mostly sees partial batches;
+    // the ratio of full batches to receives is a direct measure of backlog
+    daq_stats.receives++;
+
+    if ( curr_batch_size and curr_batch_size == max_recv )
+        daq_stats.full_batches++;
+
+    if ( pool_size - pool_available > daq_stats.pool_max_in_use )
+        daq_stats.pool_max_in_use = pool_size - pool_available;
+
     return rstat;
 }
 
@@ -206,6 +224,36 @@ int SFDAQInstance::finalize_message(DAQ_Msg_h msg, DAQ_Verdict verdict)
     return rval;
 }
 
+void SFDAQInstance::finalize_verdicts()
+{
+    if (!num_verdicts)
+        return;
+
+    // DAQ has no vectored finalize so the batch is still submitted one
+    // message at a time, but back to back with the timing taken once
+    hr_time start = SnortClock::now();
+    unsigned done = 0;
+
+    for (unsigned i = 0; i < num_verdicts; i++)
+    {
+        if (daq_instance_msg_finalize(instance, verdict_msgs[i], verdicts[i]) == DAQ_SUCCESS)
+            done++;
+    }
+
+    pool_available += done;
+    uint64_t usecs = TO_USECS(SnortClock::now() - start);
+
+    daq_stats.verdict_batches++;
+
+    if (num_verdicts > daq_stats.verdict_max_batch)
+        daq_stats.verdict_max_batch = num_verdicts;
+
+    if (usecs > daq_stats.verdict_max_usecs)
+        daq_stats.verdict_max_usecs = usecs;
+
+    num_verdicts = 0;
+}
+
 const char* SFDAQInstance::get_error()
 {
     return daq_instance_get_error(instance);
@@ -57,6 +57,18 @@ public:
         return nullptr;
     }
     int finalize_message(DAQ_Msg_h msg, DAQ_Verdict verdict);
+
+    // verdicts rendered while working through a receive batch are held
+    // here and submitted together by finalize_verdicts()
+    void defer_verdict(DAQ_Msg_h msg, DAQ_Verdict verdict)
+    {
+        if (num_verdicts == batch_size)
+            finalize_verdicts();
+        verdict_msgs[num_verdicts] = msg;
+        verdicts[num_verdicts++] = verdict;
+    }
+    void finalize_verdicts();
+
     const char* get_error();
 
     int get_base_protocol() const;
@@ -90,6 +102,9 @@ private:
     uint32_t instance_id;
     DAQ_Instance_h instance = nullptr;
     DAQ_Msg_h* daq_msgs;
+    DAQ_Msg_h* verdict_msgs;
+    DAQ_Verdict* verdicts;
+    unsigned num_verdicts = 0;
     unsigned curr_batch_size = 0;
     unsigned curr_batch_idx = 0;
     uint32_t batch_size;
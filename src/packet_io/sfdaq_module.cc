@@ -199,6 +199,22 @@ const PegInfo daq_names[] =
     { CountType::SUM, "retries_dropped", "messages dropped when overrunning the retry queue" },
     { CountType::SUM, "retries_processed", "messages processed from the retry queue" },
     { CountType::SUM, "retries_discarded", "messages discarded when purging the retry queue" },
+    { CountType::MAX, "retries_max_queued", "maximum number of messages in the retry queue" },
+    { CountType::MAX, "retries_max_latency",
+        "maximum usecs a message waited past its retry time" },
+    { CountType::SUM, "receives", "calls to receive a batch of messages from DAQ" },
+    { CountType::SUM, "full_batches", "receives that returned a full batch (thread is backlogged)" },
+    { CountType::SUM, "pool_exhausted", "receives limited by the available message pool" },
+    { CountType::MAX, "pool_max_in_use", "maximum number of messages held from the pool" },
+    { CountType::SUM, "verdict_batches", "batches of deferred verdicts submitted to DAQ" },
+    { CountType::MAX, "verdict_max_batch", "maximum number of verdicts submitted in one batch" },
+    { CountType::MAX, "verdict_max_usecs", "maximum usecs taken to submit a batch of verdicts" },
+    { CountType::SUM, "reload_swaps", "configuration swaps applied by packet threads" },
+    { CountType::SUM, "reload_steps_lt_100us", "reload steps that held packets for under 100 usecs" },
+    { CountType::SUM, "reload_steps_lt_1ms", "reload steps that held packets for 100 usecs to 1 msec" },
+    { CountType::SUM, "reload_steps_lt_10ms", "reload steps that held packets for 1 to 10 msecs" },
+    { CountType::SUM, "reload_steps_ge_10ms", "reload steps that held packets for 10 msecs or more" },
+    { CountType::MAX, "reload_max_usecs", "maximum usecs packets were held by one reload step" },
     { CountType::SUM, "sof_messages", "start of flow messages received from DAQ" },
     { CountType::SUM, "eof_messages", "end of flow messages received from DAQ" },
     { CountType::SUM, "other_messages", "messages received from DAQ with unrecognized message type" },
@@ -75,6 +75,21 @@ struct DAQStats
     PegCount retries_dropped;
     PegCount retries_processed;
     PegCount retries_discarded;
+    PegCount retries_max_queued;
+    PegCount retries_max_latency;
+    PegCount receives;
+    PegCount full_batches;
+    PegCount pool_exhausted;
+    PegCount pool_max_in_use;
+    PegCount verdict_batches;
+    PegCount verdict_max_batch;
+    PegCount verdict_max_usecs;
+    PegCount reload_swaps;
+    PegCount reload_steps_lt_100us;
+    PegCount reload_steps_lt_1ms;
+    PegCount reload_steps_lt_10ms;
+    PegCount reload_steps_ge_10ms;
+    PegCount reload_max_usecs;
     PegCount sof_messages;
     PegCount eof_messages;
     PegCount other_messages;
@@ -53,6 +53,7 @@
 #include "ports/rule_port_tables.h"
 #include "sfip/sf_ipvar.h"
 #include "target_based/snort_protocols.h"
+#include "utils/stats.h"
 #include "utils/util.h"
 #include "utils/util_cstring.h"
 
@@ -245,6 +246,36 @@ static void PortTablesFinish(RulePortTables* port_tables, FastPatternConfig* fp)
     RuleListSortUniq(port_tables->udp.nfp->rule_list);
 }
 
+static void PortTablesPrintCompile(RulePortTables* port_tables)
+{
+    const PortProto* protos[] =
+    { &port_tables->ip, &port_tables->icmp, &port_tables->tcp, &port_tables->udp };
+
+    unsigned groups = 0, spans = 0;
+    uint64_t usecs = 0, bytes = 0, list_bytes = 0;
+
+    for ( auto pp : protos )
+    {
+        for ( auto pt : { pp->src, pp->dst } )
+        {
+            if ( pt->pt_mpo_hash )
+                groups += pt->pt_mpo_hash->get_count();
+
+            spans += pt->compile_spans;
+            usecs += pt->compile_usecs;
+            bytes += pt->compile_bytes;
+            list_bytes += pt->compile_list_bytes;
+        }
+    }
+
+    LogLabel("port table compile");
+    LogCount("port groups", groups);
+    LogCount("port spans", spans);
+    LogCount("usecs", usecs);
+    LogCount("scratch bytes", bytes);
+    LogCount("port list bytes", list_bytes);
+}
+
 static void OtnInit(SnortConfig* sc)
 {
     if (sc == nullptr)
@@ -538,6 +569,9 @@ void ParseRulesFinish(SnortConfig* sc)
     /* Compile/Finish and Print the PortList Tables */
     PortTablesFinish(sc->port_tables, sc->fast_pattern_config);
     parse_rule_print();
+
+    if ( SnortConfig::log_verbose() )
+        PortTablesPrintCompile(sc->port_tables);
 }
 
 void ShowPolicyStats(const SnortConfig* sc)
@@ -0,0 +1,174 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// pp_bench.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "pp_bench.h"
+
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include <cstring>
+
+#include "lua/lua.h"
+#include "lua/lua_table.h"
+
+using namespace Piglet;
+
+// -----------------------------------------------------------------------------
+// hardware counters
+// -----------------------------------------------------------------------------
+
+#ifdef __linux__
+// count for this thread in user space only; fails without perf permissions
+static int open_counter(uint64_t config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void start_counter(int fd)
+{
+    if ( fd >= 0 )
+    {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+static uint64_t stop_counter(int fd)
+{
+    uint64_t n = 0;
+
+    if ( fd >= 0 )
+    {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+        if ( read(fd, &n, sizeof(n)) != sizeof(n) )
+            n = 0;
+    }
+    return n;
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// BenchRun
+// -----------------------------------------------------------------------------
+
+BenchRun::BenchRun(lua_State* s, int opts_index) : L(s)
+{
+    if ( lua_istable(L, opts_index) )
+    {
+        Lua::Table table(L, opts_index);
+        table.get_field("iterations", opts.iterations);
+        table.get_field("warmup", opts.warmup);
+        table.get_field("counters", opts.counters);
+    }
+
+    if ( !opts.iterations )
+        opts.iterations = 1;
+
+#ifdef __linux__
+    if ( opts.counters )
+    {
+        instr_fd = open_counter(PERF_COUNT_HW_INSTRUCTIONS);
+        cache_fd = open_counter(PERF_COUNT_HW_CACHE_MISSES);
+    }
+#endif
+}
+
+BenchRun::~BenchRun()
+{
+    if ( instr_fd >= 0 )
+        close(instr_fd);
+
+    if ( cache_fd >= 0 )
+        close(cache_fd);
+}
+
+void BenchRun::start()
+{
+#ifdef __linux__
+    start_counter(instr_fd);
+    start_counter(cache_fd);
+#endif
+    start_time = std::chrono::steady_clock::now();
+    start_cycles = cycles();
+}
+
+void BenchRun::stop()
+{
+    total_cycles = cycles() - start_cycles;
+    elapsed = std::chrono::steady_clock::now() - start_time;
+
+#ifdef __linux__
+    counts.instructions = stop_counter(instr_fd);
+    counts.cache_misses = stop_counter(cache_fd);
+#endif
+}
+
+int BenchRun::push_result(size_t bytes)
+{
+    double secs = std::chrono::duration<double>(elapsed).count();
+    double n = opts.iterations;
+
+    lua_newtable(L);
+    Lua::Table table(L, lua_gettop(L));
+
+    table.set_field("iterations", opts.iterations);
+
+    auto set_number = [this](const char* key, double v)
+    {
+        lua_pushnumber(L, v);
+        lua_setfield(L, -2, key);
+    };
+
+    set_number("seconds", secs);
+    set_number("ops_per_sec", secs > 0 ? n / secs : 0);
+    set_number("nsecs_per_op", 1e9 * secs / n);
+    set_number("cycles_per_op", total_cycles / n);
+
+    if ( bytes )
+        set_number("cycles_per_byte", total_cycles / (n * bytes));
+
+    if ( instr_fd >= 0 )
+        set_number("instructions_per_op", counts.instructions / n);
+
+    if ( cache_fd >= 0 )
+        set_number("cache_misses_per_op", counts.cache_misses / n);
+
+    return 1;
+}
+
@@ -0,0 +1,107 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// pp_bench.h
+
+#ifndef PP_BENCH_H
+#define PP_BENCH_H
+
+// Support for the bench() methods of the plugin interfaces.  The entry point
+// is called in a C++ loop so the Lua call overhead is paid once per run, not
+// once per call.  The optional last argument is a table:
+//
+//     { iterations = 100000, warmup = 1000, counters = false }
+//
+// and the result is a table with iterations, seconds, ops_per_sec,
+// nsecs_per_op, cycles_per_op, cycles_per_byte and, when counters is set and
+// the kernel allows it, instructions_per_op and cache_misses_per_op.
+
+#include <chrono>
+#include <cstdint>
+
+struct lua_State;
+
+namespace Piglet
+{
+struct BenchOpts
+{
+    unsigned iterations = 100000;
+    unsigned warmup = 1000;
+    bool counters = false;
+};
+
+struct BenchCounters
+{
+    uint64_t instructions = 0;
+    uint64_t cache_misses = 0;
+};
+
+class BenchRun
+{
+public:
+    BenchRun(lua_State*, int opts_index);
+    ~BenchRun();
+
+    BenchRun(const BenchRun&) = delete;
+    BenchRun& operator=(const BenchRun&) = delete;
+
+    // bytes is the size of the input handled by one call
+    template<typename Fun>
+    int run(size_t bytes, Fun fun)
+    {
+        for ( unsigned i = 0; i < opts.warmup; ++i )
+            fun();
+
+        start();
+
+        for ( unsigned i = 0; i < opts.iterations; ++i )
+            fun();
+
+        stop();
+        return push_result(bytes);
+    }
+
+private:
+    static uint64_t cycles()
+    {
+#if defined(__i386__) || defined(__x86_64__)
+        return __builtin_ia32_rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    void start();
+    void stop();
+    int push_result(size_t bytes);
+
+    lua_State* L;
+    BenchOpts opts;
+
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::duration elapsed { };
+    uint64_t start_cycles = 0;
+    uint64_t total_cycles = 0;
+
+    int instr_fd = -1;
+    int cache_fd = -1;
+    BenchCounters counts;
+};
+}
+
+#endif
+
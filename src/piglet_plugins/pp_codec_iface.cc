@@ -29,6 +29,7 @@
 #include "lua/lua_arg.h"
 #include "log/text_log.h"
 
+#include "pp_bench.h"
 #include "pp_buffer_iface.h"
 #include "pp_codec_data_iface.h"
 #include "pp_decode_data_iface.h"
@@ -59,6 +60,36 @@ struct TextLogWrapper
     }
 };
 
+// Create a fake DAQ packet message to pass through decoding since there is assumed to
+// be one.  The constness of the data should be safe since codecs shouldn't attempt to
+// modify message data.
+struct FakeDaqMsg
+{
+    DAQ_PktHdr_t daq_pkth = { };
+    DAQ_Msg_t daq_msg = { };
+
+    FakeDaqMsg(lua_State* L, int arg)
+    {
+        size_t len = 0;
+        const uint8_t* data;
+
+        if ( RawBufferIface.is(L, arg) )
+        {
+            data = get_data(RawBufferIface.get(L, arg));
+            len = get_data_length(RawBufferIface.get(L, arg));
+        }
+        else
+            data = reinterpret_cast<const uint8_t*>(luaL_checklstring(L, arg, &len));
+
+        daq_pkth.pktlen = len;
+        daq_msg.type = DAQ_MSG_TYPE_PACKET;
+        daq_msg.hdr = &daq_pkth;
+        daq_msg.hdr_len = sizeof(daq_pkth);
+        daq_msg.data = const_cast<uint8_t*>(data);
+        daq_msg.data_len = len;
+    }
+};
+
 static const luaL_Reg methods[] =
 {
     {
@@ -110,30 +141,8 @@ static const luaL_Reg methods[] =
 
             auto& self = CodecIface.get(L);
 
-            size_t len = 0;
-            const uint8_t* data;
-
-            if ( RawBufferIface.is(L, 2) )
-            {
-                data = get_data(RawBufferIface.get(L, 2));
-                len = get_data_length(RawBufferIface.get(L, 2));
-            }
-            else
-                data = reinterpret_cast<const uint8_t*>(luaL_checklstring(L, 2, &len));
-
-            // Create a fake DAQ packet message to pass through decoding since there is assumed to
-            // be one.  The constness of the data should be safe since codecs shouldn't attempt to
-            // modify message data.
-            DAQ_PktHdr_t daq_pkth = { };
-            daq_pkth.pktlen = len;
-            DAQ_Msg_t daq_msg = { };
-            daq_msg.type = DAQ_MSG_TYPE_PACKET;
-            daq_msg.hdr = &daq_pkth;
-            daq_msg.hdr_len = sizeof(daq_pkth);
-            daq_msg.data = const_cast<uint8_t*>(data);
-            daq_msg.data_len = len;
-
-            RawData rd(&daq_msg, daq_msg.data, daq_msg.data_len);
+            FakeDaqMsg msg(L, 2);
+            RawData rd(&msg.daq_msg, msg.daq_msg.data, msg.daq_msg.data_len);
             result = self.decode(rd, cd, dd);
 
             lua_pushboolean(L, result);
@@ -141,6 +150,28 @@ static const luaL_Reg methods[] =
             return 1;
         }
     },
+    {
+        "bench",
+        [](lua_State* L)
+        {
+            auto& cd = CodecDataIface.get(L, 3);
+            auto& dd = DecodeDataIface.get(L, 4);
+
+            auto& self = CodecIface.get(L);
+
+            FakeDaqMsg msg(L, 2);
+            RawData rd(&msg.daq_msg, msg.daq_msg.data, msg.daq_msg.data_len);
+
+            // decode updates its outputs so each call starts from the given state
+            Piglet::BenchRun bench(L, 5);
+            return bench.run(rd.len, [&]()
+            {
+                CodecData tmp_cd = cd;
+                DecodeData tmp_dd = dd;
+                self.decode(rd, tmp_cd, tmp_dd);
+            });
+        }
+    },
     {
         "log",
         [](lua_State* L)
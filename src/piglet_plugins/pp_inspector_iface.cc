@@ -27,6 +27,7 @@
 #include "lua/lua_arg.h"
 #include "main/snort_config.h"
 
+#include "pp_bench.h"
 #include "pp_packet_iface.h"
 #include "pp_raw_buffer_iface.h"
 #include "pp_stream_splitter_iface.h"
@@ -99,6 +100,17 @@ static const luaL_Reg methods[] =
             return 0;
         }
     },
+    {
+        "bench",
+        [](lua_State* L)
+        {
+            auto& p = PacketIface.get(L, 1);
+            auto& self = InspectorIface.get(L);
+
+            Piglet::BenchRun bench(L, 2);
+            return bench.run(p.dsize, [&]() { self.eval(&p); });
+        }
+    },
     {
         "clear",
         [](lua_State* L)
@@ -23,9 +23,11 @@
 
 #include "pp_ips_option_iface.h"
 
+#include "framework/cursor.h"
 #include "framework/ips_option.h"
 #include "lua/lua_stack.h"
 
+#include "pp_bench.h"
 #include "pp_packet_iface.h"
 #include "pp_cursor_iface.h"
 
@@ -75,6 +77,24 @@ static const luaL_Reg methods[] =
             return 1;
         }
     },
+    {
+        "bench",
+        [](lua_State* L)
+        {
+            auto& c = CursorIface.get(L, 1);
+            auto& p = PacketIface.get(L, 2);
+
+            auto& self = IpsOptionIface.get(L);
+
+            // eval moves the cursor so each call starts from a fresh copy
+            Piglet::BenchRun bench(L, 3);
+            return bench.run(c.size(), [&]()
+            {
+                Cursor tmp(c);
+                self.eval(tmp, &p);
+            });
+        }
+    },
     {
         "action",
         [](lua_State* L)
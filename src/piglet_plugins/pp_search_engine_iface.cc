@@ -24,11 +24,109 @@
 #include "pp_search_engine_iface.h"
 
 #include "framework/mpse.h"
+#include "lua/lua_arg.h"
+#include "main/snort_config.h"
+
+#include "pp_bench.h"
+#include "pp_raw_buffer_iface.h"
 
 using namespace snort;
 
+static const uint8_t* get_buffer(lua_State* L, int arg, size_t& len)
+{
+    if ( RawBufferIface.is(L, arg) )
+    {
+        auto& rb = RawBufferIface.get(L, arg);
+        len = get_data_length(rb);
+        return get_data(rb);
+    }
+
+    return reinterpret_cast<const uint8_t*>(luaL_checklstring(L, arg, &len));
+}
+
+static int count_match(void*, void*, int, void* context, void*)
+{
+    ++*static_cast<unsigned*>(context);
+    return 0;
+}
+
+static unsigned search(Mpse& self, const uint8_t* buf, size_t len)
+{
+    unsigned matches = 0;
+    int state = 0;
+
+    self.search(buf, len, count_match, &matches, &state);
+    return matches;
+}
+
 static const luaL_Reg methods[] =
 {
+    {
+        "add_pattern",
+        [](lua_State* L)
+        {
+            Lua::Args args(L);
+
+            size_t len = 0;
+            const char* pat = args[1].check_string(len);
+            bool no_case = args[2].opt_bool();
+
+            auto& self = SearchEngineIface.get(L);
+
+            Mpse::PatternDescriptor desc(no_case, false, true);
+            int result = self.add_pattern(
+                reinterpret_cast<const uint8_t*>(pat), len, desc, nullptr);
+
+            lua_pushinteger(L, result);
+            return 1;
+        }
+    },
+    {
+        "prep_patterns",
+        [](lua_State* L)
+        {
+            auto& self = SearchEngineIface.get(L);
+            int result = self.prep_patterns(SnortConfig::get_main_conf());
+            lua_pushinteger(L, result);
+            return 1;
+        }
+    },
+    {
+        "get_pattern_count",
+        [](lua_State* L)
+        {
+            int result = SearchEngineIface.get(L).get_pattern_count();
+            lua_pushinteger(L, result);
+            return 1;
+        }
+    },
+    {
+        "search",
+        [](lua_State* L)
+        {
+            size_t len = 0;
+            const uint8_t* buf = get_buffer(L, 1, len);
+
+            auto& self = SearchEngineIface.get(L);
+
+            unsigned matches = search(self, buf, len);
+            Lua::Stack<unsigned>::push(L, matches);
+            return 1;
+        }
+    },
+    {
+        "bench",
+        [](lua_State* L)
+        {
+            size_t len = 0;
+            const uint8_t* buf = get_buffer(L, 1, len);
+
+            auto& self = SearchEngineIface.get(L);
+
+            Piglet::BenchRun bench(L, 2);
+            return bench.run(len, [&]() { search(self, buf, len); });
+        }
+    },
     { nullptr, nullptr }
 };
 
@@ -23,18 +23,27 @@
 
 #include "port_table.h"
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "hash/ghash.h"
 #include "hash/hash_defs.h"
 #include "hash/hash_key_operations.h"
 #include "log/messages.h"
 #include "main/snort_debug.h"
+#include "time/clock_defs.h"
 #include "utils/util.h"
 #include "utils/util_cstring.h"
 
 #include "port_utils.h"
 
+#ifdef UNIT_TEST
+#include <set>
+
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
 #define PTBL_LRC_DEFAULT 10
@@ -377,74 +386,53 @@ static PortObject2* PortTableCompileMergePortObjectList2(
     return ponew;
 }
 
-static inline void add_port_object(Port port, PortObject* po, SF_LIST** parray)
-{
-    if ( !parray[port] )
-    {
-        parray[port] = sflist_new();
-        assert(parray[port]);
-    }
-
-    if ( parray[port]->tail && parray[port]->tail->ndata == po )
-        return;
-
-    sflist_add_tail(parray[port], po);
-}
-
-// Update port object lists
-static inline void update_port_lists(PortObject* po, SF_LIST** parray)
+// The set of input port objects covering a port only changes where one of
+// their port ranges starts or ends.  Instead of building a list per port,
+// sweep the range edges in port order keeping the covering set as a bitmap
+// over pt_polist positions; every port in a span between two edges shares
+// the same set and so the same merged group.
+struct PortEdge
 {
-    PortObjectItem* poi;
-    SF_LNODE* lpos;
-    for ( poi = (PortObjectItem*)sflist_first(po->item_list, &lpos);
-          poi;
-          poi = (PortObjectItem*)sflist_next(&lpos) )
-    {
-        assert(!poi->negate);
-
-        if( poi->any())
-            return;
-
-        else if( poi->one() )
-            add_port_object(poi->lport, po, parray);
-
-        else
-            for( int port = poi->lport; port <= poi->hport; port++ )
-                add_port_object(port, po, parray);
+    int port;       // first port the change applies to
+    unsigned po;    // position in pt_polist
+    int delta;      // +1 range start, -1 past range end
 
-        add_port_object(poi->lport, po, parray);
-    }
-}
+    bool operator<(const PortEdge& rhs) const
+    { return port < rhs.port; }
+};
 
-// Create optimized port lists per port
-static inline SF_LIST** create_port_lists(PortTable* p)
+static void get_port_edges(PortTable* p, std::vector<PortObject*>& objs,
+    std::vector<PortEdge>& edges)
 {
-    SF_LIST** parray = (SF_LIST**)snort_calloc(sizeof(SF_LIST*), SFPO_MAX_PORTS);
-    assert(parray);
-
     PortObject* po;
     SF_LNODE* lpos;
+
     for ( po = (PortObject*)sflist_first(p->pt_polist, &lpos);
           po;
           po = (PortObject*)sflist_next(&lpos) )
     {
-        update_port_lists(po, parray);
-    }
+        unsigned idx = objs.size();
+        objs.emplace_back(po);
 
-    return parray;
-}
+        PortObjectItem* poi;
+        SF_LNODE* ipos;
 
-static inline void delete_port_lists(SF_LIST** parray)
-{
-    for ( int port = 0; port < SFPO_MAX_PORTS; port++ )
-    {
-        SF_LIST* list = parray[port];
-        if (list)
-            sflist_free(list);
+        for ( poi = (PortObjectItem*)sflist_first(po->item_list, &ipos);
+              poi;
+              poi = (PortObjectItem*)sflist_next(&ipos) )
+        {
+            assert(!poi->negate);
+
+            if ( poi->any() )
+                break;
+
+            edges.push_back({ poi->lport, idx, 1 });
+            edges.push_back({ poi->hport + 1, idx, -1 });
+        }
     }
+    std::sort(edges.begin(), edges.end());
 }
 
-
 static void PortTableCompileMergePortObjects(PortTable* p)
 {
     std::unique_ptr<PortObject*[]> upA(new PortObject*[SFPO_MAX_LPORTS]);
@@ -461,42 +449,88 @@ static void PortTableCompileMergePortObjects(PortTable* p)
 
     p->pt_mpxo_hash = mhashx;
     SF_LIST* plx_list = sflist_new();
-    SF_LIST** optimized_pl = create_port_lists(p);
 
-    // For each port, merge rules from all port objects that touch the port
-    // into an optimal object, that may be shared with other ports.
-    int id = PO_INIT_ID;
+    std::vector<PortObject*> objs;
+    std::vector<PortEdge> edges;
+    get_port_edges(p, objs, edges);
+
+    // per object count of covering ranges (in case they overlap) and the
+    // resulting set of objects covering the current span
+    std::vector<unsigned> cover(objs.size(), 0);
+    std::vector<uint64_t> active((objs.size() + 63) / 64, 0);
+
+    p->compile_bytes = objs.capacity() * sizeof(PortObject*) +
+        edges.capacity() * sizeof(PortEdge) + cover.capacity() * sizeof(unsigned) +
+        active.capacity() * sizeof(uint64_t);
+
+    // what the per port lists of the previous compile would have taken,
+    // for comparison in the startup stats
+    p->compile_list_bytes = SFPO_MAX_PORTS * sizeof(SF_LIST*);
 
     for ( int i = 0; i < SFPO_MAX_PORTS; i++ )
+        p->pt_port_object[i] = nullptr;
+
+    // For each span, merge rules from all port objects that touch it
+    // into an optimal object, that may be shared with other spans.
+    int id = PO_INIT_ID;
+    size_t e = 0;
+
+    while ( e < edges.size() and edges[e].port < SFPO_MAX_PORTS )
     {
-        /* Build a list of port objects touching port 'i' */
+        int start = edges[e].port;
+
+        for ( ; e < edges.size() and edges[e].port == start; e++ )
+        {
+            unsigned po = edges[e].po;
+
+            if ( edges[e].delta > 0 )
+            {
+                if ( !cover[po]++ )
+                    active[po / 64] |= (1ull << (po % 64));
+            }
+            else if ( !--cover[po] )
+                active[po / 64] &= ~(1ull << (po % 64));
+        }
+
+        int end = (e < edges.size() and edges[e].port < SFPO_MAX_PORTS) ?
+            edges[e].port : SFPO_MAX_PORTS;
+
+        /* Build a list of port objects touching this span, in list order */
         int pol_cnt = 0;
-        PortObject* po;
-        SF_LNODE* lpos;
+        unsigned covering = 0;
 
-        for (po = (PortObject*)sflist_first(optimized_pl[i], &lpos);
-             po;
-             po = (PortObject*)sflist_next(&lpos) )
+        for ( size_t w = 0; w < active.size(); w++ )
         {
-            if (pol_cnt < SFPO_MAX_LPORTS )
-                pol[ pol_cnt++ ] = po;
+            covering += __builtin_popcountll(active[w]);
+
+            for ( uint64_t bits = active[w]; bits and pol_cnt < SFPO_MAX_LPORTS;
+                bits &= bits - 1 )
+            {
+                pol[pol_cnt++] = objs[w * 64 + __builtin_ctzll(bits)];
+            }
         }
-        p->pt_port_object[i] = nullptr;
 
         if ( !pol_cnt )
-            continue;            //port not contained in any PortObject
+            continue;            // span not contained in any PortObject
+
+        p->compile_list_bytes += (size_t)(end - start) *
+            (sizeof(SF_LIST) + covering * sizeof(SF_LNODE));
 
         /* merge the rules into an optimal port object */
-        p->pt_port_object[i] =
-            PortTableCompileMergePortObjectList2(
-                mhash, mhashx, plx_list, pol, pol_cnt, p->pt_lrc);
-        assert( p->pt_port_object[i] );
-        p->pt_port_object[i]->id = id++;  // set the port object id
+        PortObject2* po2 = PortTableCompileMergePortObjectList2(
+            mhash, mhashx, plx_list, pol, pol_cnt, p->pt_lrc);
+        assert(po2);
+
+        for ( int port = start; port < end; port++ )
+            p->pt_port_object[port] = po2;
+
+        // ids are still handed out per port so the last port using an
+        // object determines its id, as before
+        id += end - start;
+        po2->id = id - 1;
+        p->compile_spans++;
     }
 
-    delete_port_lists(optimized_pl);
-    snort_free(optimized_pl);
-
     /*
      * Normalize the Ports so they indicate only the ports that
      * reference the composite port object
@@ -753,8 +787,12 @@ int PortTableCompile(PortTable* p)
     if ( !p->pt_optimize )
         return 0;
 
+    hr_time start = SnortClock::now();
+
     PortTableCompileMergePortObjects(p);
 
+    p->compile_usecs = TO_USECS(SnortClock::now() - start);
+
 #ifdef DEBUG
     PortTableConsistencyCheck(p);
     PortTableConsistencyCheck2(p);
@@ -899,3 +937,182 @@ void PortTableSortUniqRules(PortTable* p)
     }
 }
 
+
+#ifdef UNIT_TEST
+// the per port compile replaced by the edge sweep, kept here as the
+// reference: one list of covering objects per port, each merged on its own
+static void ref_add_port_object(Port port, PortObject* po, SF_LIST** parray, size_t& bytes)
+{
+    if ( !parray[port] )
+    {
+        parray[port] = sflist_new();
+        bytes += sizeof(SF_LIST);
+    }
+
+    if ( parray[port]->tail && parray[port]->tail->ndata == po )
+        return;
+
+    sflist_add_tail(parray[port], po);
+    bytes += sizeof(SF_LNODE);
+}
+
+static size_t ref_compile(PortTable* p, PortObject2* port_object[], GHash*& mhash)
+{
+    size_t bytes = SFPO_MAX_PORTS * sizeof(SF_LIST*);
+    SF_LIST** parray = (SF_LIST**)snort_calloc(sizeof(SF_LIST*), SFPO_MAX_PORTS);
+    SF_LNODE* lpos;
+
+    for ( PortObject* po = (PortObject*)sflist_first(p->pt_polist, &lpos);
+          po;
+          po = (PortObject*)sflist_next(&lpos) )
+    {
+        SF_LNODE* ipos;
+
+        for ( PortObjectItem* poi = (PortObjectItem*)sflist_first(po->item_list, &ipos);
+              poi;
+              poi = (PortObjectItem*)sflist_next(&ipos) )
+        {
+            if ( poi->any() )
+                break;
+
+            for ( int port = poi->lport; port <= poi->hport; port++ )
+                ref_add_port_object(port, po, parray, bytes);
+        }
+    }
+
+    mhash = new GHash(PO_HASH_TBL_ROWS, sizeof(PortObject*), false, nullptr);
+    mhash->set_hashkey_ops(new PortObjectHashKeyOps(PO_HASH_TBL_ROWS));
+
+    GHash* mhashx = new GHash(PO_HASH_TBL_ROWS, sizeof(plx_t*), false, nullptr);
+    mhashx->set_hashkey_ops(new PlxHashKeyOps(PO_HASH_TBL_ROWS));
+
+    SF_LIST* plx_list = sflist_new();
+    PortObject* pol[SFPO_MAX_LPORTS];
+    int id = PO_INIT_ID;
+
+    for ( int i = 0; i < SFPO_MAX_PORTS; i++ )
+    {
+        int pol_cnt = 0;
+        port_object[i] = nullptr;
+
+        for ( PortObject* po = (PortObject*)sflist_first(parray[i], &lpos);
+              po and pol_cnt < SFPO_MAX_LPORTS;
+              po = (PortObject*)sflist_next(&lpos) )
+            pol[pol_cnt++] = po;
+
+        if ( parray[i] )
+            sflist_free(parray[i]);
+
+        if ( !pol_cnt )
+            continue;
+
+        port_object[i] = PortTableCompileMergePortObjectList2(
+            mhash, mhashx, plx_list, pol, pol_cnt, p->pt_lrc);
+        port_object[i]->id = id++;
+    }
+
+    snort_free(parray);
+    sflist_free_all(plx_list, plx_free);
+    delete mhashx;
+
+    return bytes;
+}
+
+static std::set<int> get_rules(PortObject2* po)
+{
+    std::set<int> rules;
+
+    for ( GHashNode* node = po->rule_hash->find_first();
+          node;
+          node = po->rule_hash->find_next() )
+        rules.insert(*(int*)node->data);
+
+    return rules;
+}
+
+static PortTable* make_table(unsigned& seed)
+{
+    auto next = [&seed](unsigned n)
+    {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % n;
+    };
+
+    PortTable* p = PortTableNew();
+    unsigned num = 1 + next(24);
+
+    for ( unsigned i = 0; i < num; i++ )
+    {
+        PortObject* po = PortObjectNew();
+
+        if ( !next(20) )
+            PortObjectAddPortAny(po);
+
+        else
+        {
+            for ( unsigned j = 1 + next(3); j; j-- )
+            {
+                // mostly low, overlapping ranges with the odd wide one
+                int lo = next(1000);
+                int hi = next(16) ? lo + (int)next(100) : lo + (int)next(4000);
+                PortObjectAddRange(po, lo, hi);
+            }
+        }
+
+        for ( unsigned j = 1 + next(25); j; j-- )
+            PortObjectAddRule(po, next(400));
+
+        RuleListSortUniq(po->rule_list);
+        PortTableAddObject(p, po);
+    }
+    return p;
+}
+
+TEST_CASE("port table compile matches per port lists", "[PortTable]")
+{
+    std::unique_ptr<PortObject2*[]> ref(new PortObject2*[SFPO_MAX_PORTS]);
+    unsigned seed = 0x5eed;
+
+    for ( int t = 0; t < 10; t++ )
+    {
+        PortTable* p = make_table(seed);
+        PortTableCompile(p);
+
+        GHash* mhash = nullptr;
+        size_t list_bytes = ref_compile(p, ref.get(), mhash);
+        unsigned diffs = 0;
+
+        for ( int i = 0; i < SFPO_MAX_PORTS; i++ )
+        {
+            PortObject2* a = p->pt_port_object[i];
+            PortObject2* b = ref[i];
+
+            if ( !a or !b )
+            {
+                diffs += (a != b);
+                continue;
+            }
+
+            // same rules and ids and ports share groups the same way
+            if ( (!i or a != p->pt_port_object[i - 1]) and get_rules(a) != get_rules(b) )
+                diffs++;
+
+            if ( a->id != b->id )
+                diffs++;
+
+            if ( i and (a == p->pt_port_object[i - 1]) != (b == ref[i - 1]) )
+                diffs++;
+        }
+        CHECK(diffs == 0);
+
+        CHECK(p->compile_list_bytes == list_bytes);
+        CHECK(p->compile_bytes < list_bytes);
+
+        for ( GHashNode* node = mhash->find_first(); node; node = mhash->find_next() )
+            PortObject2Free((PortObject2*)node->data);
+
+        delete mhash;
+        PortTableFree(p);
+    }
+}
+#endif
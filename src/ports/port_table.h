@@ -69,6 +69,10 @@ struct PortTable
     int large_single_merges; /* 1 large + some small objects */
     int large_multi_merges; /* >1 large object merged + some small objects */
     int non_opt_merges;
+    unsigned compile_spans;  /* port ranges compiled to a group */
+    uint64_t compile_usecs;
+    size_t compile_bytes;       /* scratch used by the edge sweep */
+    size_t compile_list_bytes;  /* same for the former per port lists */
 };
 
 PortTable* PortTableNew();
@@ -36,6 +36,7 @@ namespace ip
 {
 constexpr uint32_t IP4_BROADCAST = 0xffffffff;
 constexpr uint8_t IP4_HEADER_LEN = 20;
+constexpr uint8_t IP4_MAX_HEADER_LEN = 60;
 constexpr uint8_t IP4_THIS_NET  = 0x00;  // msb
 constexpr uint8_t IP4_MULTICAST = 0x0E;  // ms nibble
 constexpr uint8_t IP4_RESERVED = 0x0F;  // ms nibble
@@ -154,6 +155,10 @@ inline bool isPrivateIP(uint32_t addr)
     }
     return false;
 }
+
+// next random id for an encoded ip4 header, from the ipv4 codec's per
+// packet thread generator
+uint16_t IpId_Next();
 } // namespace ip
 } // namespace snort
 /* tcpdump shows us the way to cross platform compatibility */
@@ -41,6 +41,10 @@
 #include "icmp4.h"
 #include "icmp6.h"
 
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
 THREAD_LOCAL ProfileStats decodePerfStats;
@@ -881,6 +885,23 @@ void PacketManager::encode_update(Packet* p)
     }
 }
 
+void PacketManager::header_modified(Packet* p)
+{
+    int inner = layer::get_inner_ip_lyr_index(p);
+
+    for ( int i = 0; i < inner; ++i )
+    {
+        ProtocolId prot_id = p->layers[i].prot_id;
+
+        if ( prot_id == ProtocolId::UDP or prot_id == ProtocolId::GRE )
+        {
+            p->packet_flags |= PKT_MODIFIED;
+            return;
+        }
+    }
+    p->packet_flags |= PKT_HDR_MODIFIED;
+}
+
 //-------------------------------------------------------------------------
 // codec support and statistics
 //-------------------------------------------------------------------------
@@ -971,3 +992,66 @@ void PacketManager::log_protocols(TextLog* const text_log,
         }
     }
 }
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+static void set_layers(Packet& p, std::initializer_list<ProtocolId> ids)
+{
+    p.num_layers = 0;
+    p.packet_flags = 0;
+
+    for ( auto id : ids )
+        p.layers[p.num_layers++].prot_id = id;
+}
+
+TEST_CASE("header_modified", "[packet_manager]")
+{
+    Packet p(false);
+    const uint32_t modified = PKT_MODIFIED | PKT_HDR_MODIFIED;
+
+    SECTION("plain")
+    {
+        set_layers(p, { ProtocolId::ETHERNET_802_3, ProtocolId::ETHERTYPE_IPV4,
+            ProtocolId::TCP });
+
+        PacketManager::header_modified(&p);
+        CHECK((p.packet_flags & modified) == PKT_HDR_MODIFIED);
+    }
+    SECTION("inner udp")
+    {
+        set_layers(p, { ProtocolId::ETHERNET_802_3, ProtocolId::ETHERTYPE_IPV4,
+            ProtocolId::UDP });
+
+        PacketManager::header_modified(&p);
+        CHECK((p.packet_flags & modified) == PKT_HDR_MODIFIED);
+    }
+    SECTION("ip in ip")
+    {
+        set_layers(p, { ProtocolId::ETHERNET_802_3, ProtocolId::ETHERTYPE_IPV4,
+            ProtocolId::IPIP, ProtocolId::TCP });
+
+        PacketManager::header_modified(&p);
+        CHECK((p.packet_flags & modified) == PKT_HDR_MODIFIED);
+    }
+    SECTION("udp tunnel")
+    {
+        set_layers(p, { ProtocolId::ETHERNET_802_3, ProtocolId::ETHERTYPE_IPV4,
+            ProtocolId::UDP, ProtocolId::VXLAN, ProtocolId::ETHERNET_802_3,
+            ProtocolId::ETHERTYPE_IPV4, ProtocolId::TCP });
+
+        PacketManager::header_modified(&p);
+        CHECK((p.packet_flags & modified) == PKT_MODIFIED);
+    }
+    SECTION("gre tunnel")
+    {
+        set_layers(p, { ProtocolId::ETHERNET_802_3, ProtocolId::ETHERTYPE_IPV4,
+            ProtocolId::GRE, ProtocolId::ETHERTYPE_IPV4, ProtocolId::TCP });
+
+        PacketManager::header_modified(&p);
+        CHECK((p.packet_flags & modified) == PKT_MODIFIED);
+    }
+}
+#endif
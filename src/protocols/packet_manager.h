@@ -68,6 +68,11 @@ public:
     // after Snort has changed any data in this packet
     static void encode_update(Packet*);
 
+    // call after editing header fields in place and adjusting the checksum
+    // of the edited layer.  sets PKT_HDR_MODIFIED so encode_update() isn't
+    // needed, or PKT_MODIFIED if a udp or gre checksum encapsulates it.
+    static void header_modified(Packet*);
+
     //--------------------------------------------------------------------
     // FIXIT-L encode_format() should be replaced with a function that
     // does format and update in one step for packets cooked for internal
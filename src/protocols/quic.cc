@@ -0,0 +1,303 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// quic.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "quic.h"
+
+#ifdef UNIT_TEST
+#include <cstring>
+
+#include "catch/snort_catch.h"
+#endif
+
+namespace snort
+{
+namespace quic
+{
+// long header invariants: flags, version (4), dcid len (1), dcid,
+// scid len (1), scid
+static constexpr unsigned MIN_LONG_HEADER_LEN = 7;
+
+static constexpr uint32_t VERSION_1 = 0x00000001;
+static constexpr uint32_t VERSION_2 = 0x6b3343cf;
+
+// the long packet type for Initial was shuffled in v2
+static constexpr uint8_t V1_INITIAL = 0x00;
+static constexpr uint8_t V2_INITIAL = 0x01;
+
+Version get_version(uint32_t v)
+{
+    if ( v == 0 )
+        return Version::NEGOTIATION;
+
+    if ( v == VERSION_1 )
+        return Version::V1;
+
+    if ( v == VERSION_2 )
+        return Version::V2;
+
+    // IETF drafts are 0xff0000nn and mvfst drafts are 0xfaceb00n
+    if ( (v & 0xffffff00) == 0xff000000 or (v & 0xfffffff0) == 0xfaceb000 )
+        return Version::DRAFT;
+
+    // gQUIC is Q0nn and its TLS variant is T0nn, nn decimal
+    uint8_t c = v >> 24;
+
+    if ( (c == 'Q' or c == 'T') and ((v >> 16) & 0xff) == '0' )
+    {
+        uint8_t d1 = (v >> 8) & 0xff;
+        uint8_t d2 = v & 0xff;
+
+        if ( d1 >= '0' and d1 <= '9' and d2 >= '0' and d2 <= '9' )
+            return Version::GOOGLE;
+    }
+    return Version::UNKNOWN;
+}
+
+// Q046 and IETF drafts before 22 pack both connection id lengths into one
+// byte as nibbles, each 0 or the length - 3
+static bool has_packed_cid_lens(uint32_t v, Version family)
+{
+    if ( family == Version::GOOGLE )
+        return (v >> 24) == 'Q' and ((v >> 8) & 0xff) == '4';
+
+    if ( family == Version::DRAFT and (v & 0xffffff00) == 0xff000000 )
+        return (v & 0xff) < 22;
+
+    return false;
+}
+
+static bool parse_packed_cids(const uint8_t* data, unsigned len, LongHeader& h)
+{
+    uint8_t dcil = data[5] >> 4;
+    uint8_t scil = data[5] & 0x0f;
+
+    h.dcid_len = dcil ? dcil + 3 : 0;
+    h.scid_len = scil ? scil + 3 : 0;
+
+    unsigned off = 6;
+
+    if ( off + h.dcid_len + h.scid_len > len )
+        return false;
+
+    h.dcid = data + off;
+    h.scid = data + off + h.dcid_len;
+    return true;
+}
+
+bool parse_long_header(const uint8_t* data, unsigned len, LongHeader& h)
+{
+    if ( len < MIN_LONG_HEADER_LEN or !(data[0] & HEADER_FORM) )
+        return false;
+
+    h.version = (uint32_t)data[1] << 24 | (uint32_t)data[2] << 16 |
+        (uint32_t)data[3] << 8 | data[4];
+
+    h.family = get_version(h.version);
+
+    if ( h.family == Version::UNKNOWN )
+        return false;
+
+    // negotiation leaves the remaining flag bits unused
+    if ( h.family != Version::NEGOTIATION and !(data[0] & FIXED_BIT) )
+        return false;
+
+    h.type = (data[0] & TYPE_MASK) >> 4;
+
+    if ( has_packed_cid_lens(h.version, h.family) )
+        return parse_packed_cids(data, len, h);
+
+    unsigned off = 5;
+    h.dcid_len = data[off++];
+
+    if ( h.dcid_len > MAX_CID_LEN or off + h.dcid_len >= len )
+        return false;
+
+    h.dcid = data + off;
+    off += h.dcid_len;
+
+    h.scid_len = data[off++];
+
+    if ( h.scid_len > MAX_CID_LEN or off + h.scid_len > len )
+        return false;
+
+    h.scid = data + off;
+    return true;
+}
+
+bool is_client_initial(const uint8_t* data, unsigned len, LongHeader& h)
+{
+    if ( len < MIN_INITIAL_LEN or !parse_long_header(data, len, h) )
+        return false;
+
+    switch ( h.family )
+    {
+    case Version::V2:
+        return h.type == V2_INITIAL;
+
+    case Version::V1:
+    case Version::DRAFT:
+    case Version::GOOGLE:
+        return h.type == V1_INITIAL;
+
+    default:
+        break;
+    }
+    return false;
+}
+}
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+using namespace snort;
+using namespace snort::quic;
+
+// long header with an 8 byte dcid and empty scid, zero padded to len
+static unsigned make_initial(uint8_t* buf, unsigned len, uint32_t ver, uint8_t type)
+{
+    memset(buf, 0, len);
+    buf[0] = HEADER_FORM | FIXED_BIT | (type << 4) | 0x03;
+    buf[1] = ver >> 24;
+    buf[2] = ver >> 16;
+    buf[3] = ver >> 8;
+    buf[4] = ver;
+    buf[5] = 8;
+
+    for ( unsigned i = 0; i < 8; ++i )
+        buf[6 + i] = 0xa0 + i;
+
+    buf[14] = 0;
+    return len;
+}
+
+TEST_CASE("quic versions", "[quic]")
+{
+    CHECK(get_version(0) == Version::NEGOTIATION);
+    CHECK(get_version(0x00000001) == Version::V1);
+    CHECK(get_version(0x6b3343cf) == Version::V2);
+    CHECK(get_version(0xff00001d) == Version::DRAFT);
+    CHECK(get_version(0xfaceb002) == Version::DRAFT);
+    CHECK(get_version(0x51303436) == Version::GOOGLE);   // Q046
+    CHECK(get_version(0x51303530) == Version::GOOGLE);   // Q050
+    CHECK(get_version(0x54303531) == Version::GOOGLE);   // T051
+    CHECK(get_version(0x1a2a3a4a) == Version::UNKNOWN);  // greased
+}
+
+TEST_CASE("quic initial", "[quic]")
+{
+    uint8_t buf[MIN_INITIAL_LEN];
+    LongHeader h;
+
+    SECTION("v1")
+    {
+        make_initial(buf, sizeof(buf), 0x00000001, V1_INITIAL);
+        REQUIRE(is_client_initial(buf, sizeof(buf), h));
+        CHECK(h.family == Version::V1);
+        CHECK(h.dcid_len == 8);
+        CHECK(h.dcid == buf + 6);
+        CHECK(h.dcid[7] == 0xa7);
+        CHECK(h.scid_len == 0);
+    }
+    SECTION("v2")
+    {
+        make_initial(buf, sizeof(buf), 0x6b3343cf, V2_INITIAL);
+        CHECK(is_client_initial(buf, sizeof(buf), h));
+
+        make_initial(buf, sizeof(buf), 0x6b3343cf, V1_INITIAL);
+        CHECK(!is_client_initial(buf, sizeof(buf), h));
+        CHECK(parse_long_header(buf, sizeof(buf), h));
+    }
+    SECTION("q046")
+    {
+        // 8 byte dcid, empty scid packed as nibbles
+        make_initial(buf, sizeof(buf), 0x51303436, V1_INITIAL);
+        buf[5] = 0x50;
+        REQUIRE(is_client_initial(buf, sizeof(buf), h));
+        CHECK(h.family == Version::GOOGLE);
+        CHECK(h.dcid_len == 8);
+        CHECK(h.dcid == buf + 6);
+        CHECK(h.dcid[0] == 0xa0);
+        CHECK(h.scid_len == 0);
+
+        buf[5] = 0x55;
+        REQUIRE(parse_long_header(buf, sizeof(buf), h));
+        CHECK(h.scid_len == 8);
+        CHECK(h.scid == buf + 14);
+        CHECK(!parse_long_header(buf, 21, h));
+    }
+    SECTION("draft 21")
+    {
+        make_initial(buf, sizeof(buf), 0xff000015, V1_INITIAL);
+        buf[5] = 0x50;
+        REQUIRE(is_client_initial(buf, sizeof(buf), h));
+        CHECK(h.dcid_len == 8);
+    }
+    SECTION("q050")
+    {
+        make_initial(buf, sizeof(buf), 0x51303530, V1_INITIAL);
+        REQUIRE(is_client_initial(buf, sizeof(buf), h));
+        CHECK(h.dcid_len == 8);
+    }
+    SECTION("handshake")
+    {
+        make_initial(buf, sizeof(buf), 0x00000001, 0x02);
+        CHECK(!is_client_initial(buf, sizeof(buf), h));
+        CHECK(parse_long_header(buf, sizeof(buf), h));
+    }
+    SECTION("unpadded")
+    {
+        make_initial(buf, sizeof(buf), 0x00000001, V1_INITIAL);
+        CHECK(!is_client_initial(buf, sizeof(buf) - 1, h));
+    }
+    SECTION("short header")
+    {
+        make_initial(buf, sizeof(buf), 0x00000001, V1_INITIAL);
+        buf[0] &= ~HEADER_FORM;
+        CHECK(!parse_long_header(buf, sizeof(buf), h));
+    }
+    SECTION("fixed bit")
+    {
+        make_initial(buf, sizeof(buf), 0x00000001, V1_INITIAL);
+        buf[0] &= ~FIXED_BIT;
+        CHECK(!parse_long_header(buf, sizeof(buf), h));
+    }
+    SECTION("cid too long")
+    {
+        make_initial(buf, sizeof(buf), 0x00000001, V1_INITIAL);
+        buf[5] = MAX_CID_LEN + 1;
+        CHECK(!parse_long_header(buf, sizeof(buf), h));
+    }
+    SECTION("truncated")
+    {
+        make_initial(buf, sizeof(buf), 0x00000001, V1_INITIAL);
+        CHECK(parse_long_header(buf, 15, h));
+        CHECK(!parse_long_header(buf, 14, h));
+        CHECK(!parse_long_header(buf, 6, h));
+    }
+}
+
+#endif
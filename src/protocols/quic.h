@@ -0,0 +1,76 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// quic.h
+
+#ifndef PROTOCOLS_QUIC_H
+#define PROTOCOLS_QUIC_H
+
+// QUIC long header parsing based on the version independent invariants
+// (RFC 8999).  Long headers are only used during the handshake and carry
+// the version and both connection ids in the clear, so a flow can be
+// identified from its first datagram without touching the protected
+// payload.  Short headers carry no version and aren't parsed here.  gQUIC
+// Q046 and IETF drafts before 22 predate the invariants and pack both
+// connection id lengths into one byte; that form is parsed too.
+
+#include <cstdint>
+
+#include "main/snort_types.h"
+
+namespace snort
+{
+namespace quic
+{
+constexpr uint8_t HEADER_FORM = 0x80;       // set for long headers
+constexpr uint8_t FIXED_BIT = 0x40;         // set except in version negotiation
+constexpr uint8_t TYPE_MASK = 0x30;         // long packet type
+constexpr uint8_t MAX_CID_LEN = 20;         // v1 and v2 limit
+
+// clients pad datagrams carrying an Initial to at least this
+constexpr unsigned MIN_INITIAL_LEN = 1200;
+
+enum class Version : uint8_t
+{
+    UNKNOWN, NEGOTIATION, V1, V2, DRAFT, GOOGLE
+};
+
+struct LongHeader
+{
+    uint32_t version;
+    Version family;
+    uint8_t type;             // long packet type bits, version specific
+
+    const uint8_t* dcid;
+    const uint8_t* scid;
+    uint8_t dcid_len;
+    uint8_t scid_len;
+};
+
+SO_PUBLIC Version get_version(uint32_t);
+
+// true if data starts with a long header of a known version with valid
+// connection id lengths; h is filled in
+SO_PUBLIC bool parse_long_header(const uint8_t* data, unsigned len, LongHeader& h);
+
+// true if the datagram carries a client Initial: a parsed long header of
+// the initial type in a datagram padded to MIN_INITIAL_LEN
+SO_PUBLIC bool is_client_initial(const uint8_t* data, unsigned len, LongHeader& h);
+}
+}
+
+#endif
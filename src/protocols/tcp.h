@@ -66,6 +66,7 @@ namespace tcp
 #define GET_PKT_SEQ(p) (ntohl((p)->ptrs.tcph->th_seq))
 
 constexpr uint8_t TCP_MIN_HEADER_LEN = 20; // this is actually the minimal TCP header length
+constexpr uint8_t TCP_MAX_HEADER_LEN = 60;
 constexpr int OPT_TRUNC = -1;
 constexpr int OPT_BADLEN = -2;
 
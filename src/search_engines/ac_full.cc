@@ -25,6 +25,15 @@
 
 #include "acsmx2.h"
 
+#ifdef UNIT_TEST
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch/snort_bench.h"
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
 //-------------------------------------------------------------------------
@@ -139,3 +148,84 @@ static const MpseApi acf_api =
 
 const BaseApi* se_ac_full = &acf_api.base;
 
+
+#ifdef UNIT_TEST
+//-------------------------------------------------------------------------
+// benchmark
+//-------------------------------------------------------------------------
+
+static int bench_match(void*, void*, int, void* context, void*)
+{
+    ++*(unsigned*)context;
+    return 0;
+}
+
+// fixed pattern set and corpus so results are comparable between builds
+TEST_CASE("ac_full search", "[.bench][ac_full]")
+{
+    static const char alpha[] = "abcdefghijklmnopqrstuvwxyz0123456789/.-_=?& ";
+
+    std::mt19937 gen(1);
+    std::vector<std::string> pats;
+
+    for ( unsigned i = 0; i < 4000; ++i )
+    {
+        std::string p;
+        unsigned len = 4 + gen() % 13;
+
+        while ( p.size() < len )
+            p += alpha[gen() % (sizeof(alpha) - 1)];
+
+        pats.emplace_back(p);
+    }
+
+    // random text with a known pattern every 512 bytes or so
+    std::string corpus;
+
+    while ( corpus.size() < 1024 * 1024 )
+    {
+        if ( gen() % 512 )
+            corpus += alpha[gen() % (sizeof(alpha) - 1)];
+        else
+            corpus += pats[gen() % pats.size()];
+    }
+
+    for ( bool dfa : { true, false } )
+    {
+        ACSM_STRUCT2* acsm = acsmNew2(nullptr, ACF_FULL);
+
+        for ( unsigned i = 0; i < pats.size(); ++i )
+        {
+            acsmAddPattern2(acsm, (const uint8_t*)pats[i].c_str(), pats[i].size(), true, false,
+                (void*)(uintptr_t)(i + 1));
+        }
+
+        if ( dfa )
+            acsm->enable_dfa();
+
+        REQUIRE(acsmCompile2(nullptr, acsm) == 0);
+
+        unsigned matches = 0;
+
+        Benchmark bench(dfa ? "ac_full.dfa" : "ac_full.nfa", corpus.size(), "bytes");
+        bench.add_field("patterns", pats.size());
+
+        bench.run([&]()
+        {
+            int state = 0;
+            matches = 0;
+
+            if ( dfa )
+                acsm_search_dfa_full(acsm, (const uint8_t*)corpus.data(), corpus.size(),
+                    bench_match, &matches, &state);
+            else
+                acsm_search_nfa(acsm, (const uint8_t*)corpus.data(), corpus.size(),
+                    bench_match, &matches, &state);
+        });
+
+        CHECK(matches >= corpus.size() / 1024);
+        acsmFree2(acsm);
+    }
+}
+#endif
+
@@ -25,6 +25,7 @@
 
 #include "decompress/file_decomp.h"
 #include "main/snort_debug.h"
+#include "memory/memory_cap.h"
 #include "service_inspectors/http2_inspect/http2_flow_data.h"
 #include "utils/js_identifier_ctx.h"
 #include "utils/js_normalizer.h"
@@ -45,6 +46,7 @@ using namespace HttpCommon;
 using namespace HttpEnums;
 
 unsigned HttpFlowData::inspector_id = 0;
+static const unsigned s_mem_tag = memory::MemoryCap::register_tag("http_inspect");
 
 #ifdef REG_TEST
 uint64_t HttpFlowData::instance_count = 0;
@@ -52,6 +54,8 @@ uint64_t HttpFlowData::instance_count = 0;
 
 HttpFlowData::HttpFlowData(Flow* flow) : FlowData(inspector_id)
 {
+    set_memory_tag(s_mem_tag);
+
 #ifdef REG_TEST
     if (HttpTestManager::use_test_output(HttpTestManager::IN_HTTP))
     {
@@ -23,6 +23,7 @@
 #include "config.h"
 #endif
 
+#include "memory/memory_cap.h"
 #include "service_inspectors/http_inspect/http_common.h"
 #include "service_inspectors/http_inspect/http_enum.h"
 #include "service_inspectors/http_inspect/http_flow_data.h"
@@ -52,6 +53,8 @@ void FlowData::update_deallocations(size_t) {}
 FlowData* Flow::get_flow_data(uint32_t) const { return nullptr; }
 }
 
+unsigned memory::MemoryCap::register_tag(const char*) { return 0; }
+
 unsigned Http2FlowData::inspector_id = 0;
 uint32_t Http2FlowData::get_processing_stream_id() const { return 0; }
 
@@ -23,6 +23,8 @@
 
 #include "curses.h"
 
+#include "protocols/quic.h"
+
 using namespace std;
 
 enum DceRpcPduType
@@ -389,6 +391,14 @@ static bool ssl_v2_curse(const uint8_t* data, unsigned len, CurseTracker* tracke
     return false;
 }
 
+// QUIC clients open with an Initial padded to a full datagram; the long
+// header version and connection id lengths are enough to tell it apart from
+// other UDP payloads without decrypting anything
+static bool quic_curse(const uint8_t* data, unsigned len, CurseTracker*)
+{
+    snort::quic::LongHeader h;
+    return snort::quic::is_client_initial(data, len, h);
+}
 
 // map between service and curse details
 static vector<CurseDetails> curse_map
@@ -397,7 +407,8 @@ static vector<CurseDetails> curse_map
     { "dce_udp", "dcerpc",      dce_udp_curse, false },
     { "dce_tcp", "dcerpc",      dce_tcp_curse, true  },
     { "dce_smb", "netbios-ssn", dce_smb_curse, true  },
-    { "sslv2"  , "ssl",         ssl_v2_curse , true  }
+    { "sslv2"  , "ssl",         ssl_v2_curse , true  },
+    { "quic"   , "quic",        quic_curse   , false }
 };
 
 bool CurseBook::add_curse(const char* key)
@@ -540,4 +551,26 @@ TEST_CASE("sslv2 not found", "[SslV2Curse]")
     SECTION("byte 10"){ test(10);}
 }
 
+TEST_CASE("quic detect", "[QuicCurse]")
+{
+    uint8_t dgram[snort::quic::MIN_INITIAL_LEN] = { };
+
+    // v1 Initial, 8 byte dcid, empty scid
+    dgram[0] = 0xc3;
+    dgram[4] = 0x01;
+    dgram[5] = 0x08;
+
+    CHECK(quic_curse(dgram, sizeof(dgram), nullptr));
+    CHECK_FALSE(quic_curse(dgram, sizeof(dgram) - 1, nullptr));
+
+    // short header
+    dgram[0] = 0x43;
+    CHECK_FALSE(quic_curse(dgram, sizeof(dgram), nullptr));
+
+    // unknown version
+    dgram[0] = 0xc3;
+    dgram[4] = 0x07;
+    CHECK_FALSE(quic_curse(dgram, sizeof(dgram), nullptr));
+}
+
 #endif
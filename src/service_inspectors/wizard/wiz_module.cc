@@ -103,7 +103,7 @@ static const Parameter s_params[] =
     { "spells", Parameter::PT_LIST, wizard_spells_params, nullptr,
       "criteria for text service identification" },
 
-    { "curses", Parameter::PT_MULTI, "dce_smb | dce_udp | dce_tcp | sslv2", nullptr,
+    { "curses", Parameter::PT_MULTI, "dce_smb | dce_udp | dce_tcp | sslv2 | quic", nullptr,
       "enable service identification based on internal algorithm" },
 
     { "max_pattern", Parameter::PT_INT, "0:65535", "64",
@@ -31,7 +31,10 @@
 
 #include "sf_ipvar.h"
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
+
 #include "utils/util.h"
 
 #include "sf_cidr.h"
@@ -50,6 +53,8 @@ using namespace snort;
 static SfIpRet sfvar_list_compare(sfip_node_t*, sfip_node_t*);
 static inline void sfip_node_free(sfip_node_t*);
 static inline void sfip_node_freelist(sfip_node_t*);
+static void sfvar_compile(sfip_var_t*);
+static void sfvar_decompile(sfip_var_t*);
 
 static inline sfip_var_t* _alloc_var()
 {
@@ -77,6 +82,7 @@ void sfvar_free(sfip_var_t* var)
         // FIXIT-L SFIP_TABLE free unimplemented
     }
 
+    sfvar_decompile(var);
     snort_free(var);
 }
 
@@ -268,8 +274,7 @@ static inline bool list_contains_node(sfip_node_t*& head, sfip_node_t*& tail, ui
     return false;
 }
 
-/* Deep copy. Returns identical, new, linked list of sfipnodes. */
-sfip_var_t* sfvar_deep_copy(const sfip_var_t* var)
+static sfip_var_t* _sfvar_deep_copy(const sfip_var_t* var)
 {
     sfip_var_t* ret;
 
@@ -287,6 +292,17 @@ sfip_var_t* sfvar_deep_copy(const sfip_var_t* var)
     return ret;
 }
 
+/* Deep copy. Returns identical, new, linked list of sfipnodes. */
+sfip_var_t* sfvar_deep_copy(const sfip_var_t* var)
+{
+    sfip_var_t* ret = _sfvar_deep_copy(var);
+
+    if (ret)
+        sfvar_compile(ret);
+
+    return ret;
+}
+
 static sfip_node_t* merge_lists(sfip_node_t* list1, sfip_node_t* list2, uint16_t list1_len,
     uint16_t list2_len, uint32_t& merge_len)
 {
@@ -418,17 +434,19 @@ static sfip_node_t* merge_lists(sfip_node_t* list1, sfip_node_t* list2, uint16_t
     return listHead;
 }
 
-SfIpRet sfvar_add(sfip_var_t* dst, sfip_var_t* src)
+static SfIpRet _sfvar_add(sfip_var_t* dst, sfip_var_t* src)
 {
     sfip_var_t* copiedvar;
 
     assert(dst and src);
 
-    if ((copiedvar = sfvar_deep_copy(src)) == nullptr)
+    if ((copiedvar = _sfvar_deep_copy(src)) == nullptr)
     {
         return SFIP_ALLOC_ERR;
     }
 
+    sfvar_decompile(dst);
+
     dst->head = merge_lists(dst->head, copiedvar->head, dst->head_count,
         copiedvar->head_count, dst->head_count);
     dst->neg_head = merge_lists(dst->neg_head, copiedvar->neg_head, dst->neg_head_count,
@@ -439,6 +457,16 @@ SfIpRet sfvar_add(sfip_var_t* dst, sfip_var_t* src)
     return SFIP_SUCCESS;
 }
 
+SfIpRet sfvar_add(sfip_var_t* dst, sfip_var_t* src)
+{
+    SfIpRet ret = _sfvar_add(dst, src);
+
+    if (ret == SFIP_SUCCESS)
+        sfvar_compile(dst);
+
+    return ret;
+}
+
 // Adds the nodes in 'src' to the variable 'dst'
 // The mismatch of types is for ease-of-supporting Snort4 and
 // Snort6 simultaneously
@@ -452,6 +480,8 @@ static SfIpRet sfvar_add_node(sfip_var_t* var, sfip_node_t* node, int negated)
     if (!var || !node)
         return SFIP_ARG_ERR;
 
+    sfvar_decompile(var);
+
     // As of this writing, 11/20/06, nodes are always added to
     // the list, regardless of the mode (list or table).
 
@@ -675,6 +705,8 @@ static void _negate_lists(sfip_var_t* var)
     sfip_node_t* temp;
     uint32_t temp_count;
 
+    sfvar_decompile(var);
+
     for (node = var->head; node; node=node->next)
         _negate_node(node);
 
@@ -692,7 +724,7 @@ static void _negate_lists(sfip_var_t* var)
     var->head_count = temp_count;
 }
 
-SfIpRet sfvar_parse_iplist(vartable_t* table, sfip_var_t* var,
+static SfIpRet _sfvar_parse_iplist(vartable_t* table, sfip_var_t* var,
     const char* str, int negation)
 {
     const char* end;
@@ -747,7 +779,7 @@ SfIpRet sfvar_parse_iplist(vartable_t* table, sfip_var_t* var,
             str++;
             list_tok = snort_strndup(str, end - str);
 
-            if ((ret = sfvar_parse_iplist(table, var, list_tok,
+            if ((ret = _sfvar_parse_iplist(table, var, list_tok,
                     negation ^ neg_ip)) != SFIP_SUCCESS)
             {
                 snort_free(list_tok);
@@ -774,7 +806,7 @@ SfIpRet sfvar_parse_iplist(vartable_t* table, sfip_var_t* var,
                 return SFIP_LOOKUP_FAILURE;
             }
 
-            copy_var = sfvar_deep_copy(tmp_var);
+            copy_var = _sfvar_deep_copy(tmp_var);
             /* Apply the negation */
             if (negation ^ neg_ip)
             {
@@ -797,7 +829,7 @@ SfIpRet sfvar_parse_iplist(vartable_t* table, sfip_var_t* var,
                 _negate_lists(copy_var);
             }
 
-            sfvar_add(var, copy_var);
+            _sfvar_add(var, copy_var);
             sfvar_free(copy_var);
         }
         else if (*str == LIST_CLOSE)
@@ -864,6 +896,17 @@ SfIpRet sfvar_parse_iplist(vartable_t* table, sfip_var_t* var,
     return SFIP_SUCCESS;
 }
 
+SfIpRet sfvar_parse_iplist(vartable_t* table, sfip_var_t* var,
+    const char* str, int negation)
+{
+    SfIpRet ret = _sfvar_parse_iplist(table, var, str, negation);
+
+    if (ret == SFIP_SUCCESS)
+        sfvar_compile(var);
+
+    return ret;
+}
+
 SfIpRet sfvar_validate(sfip_var_t* var)
 {
     sfip_node_t* idx, * neg_idx;
@@ -1017,6 +1060,226 @@ sfip_var_t* sfvar_alloc(vartable_t* table, const char* variable, SfIpRet* status
     return ret;
 }
 
+//-------------------------------------------------------------------------
+// compiled lookup
+//
+// For each family the variable is folded to (all or union of positives)
+// minus (union of negatives), kept as sorted, disjoint, inclusive ranges.
+// Node containment follows fast_cont4 / fast_cont6 exactly, including
+// their quirks (0.0.0.0 contains everything, host bits in the last
+// compared word never match); anything those don't define (like a v4
+// prefix shorter than /0) leaves the variable on the list walk.
+//-------------------------------------------------------------------------
+
+typedef std::pair<uint64_t, uint64_t> Ip6Val;   // high, low in host order
+
+template<typename T>
+using Ranges = std::vector<std::pair<T, T>>;
+
+struct sfip_ranges_t
+{
+    Ranges<uint32_t> v4;
+    Ranges<Ip6Val> v6;
+};
+
+static inline uint32_t next_val(uint32_t v)
+{ return v + 1; }
+
+static inline uint32_t prev_val(uint32_t v)
+{ return v - 1; }
+
+static inline Ip6Val next_val(const Ip6Val& v)
+{ return v.second == UINT64_MAX ? Ip6Val(v.first + 1, 0) : Ip6Val(v.first, v.second + 1); }
+
+static inline Ip6Val prev_val(const Ip6Val& v)
+{ return v.second == 0 ? Ip6Val(v.first - 1, UINT64_MAX) : Ip6Val(v.first, v.second - 1); }
+
+static inline Ip6Val get_ip6_val(const SfIp* ip)
+{
+    const uint32_t* w = ip->get_ip6_ptr();
+    return Ip6Val(((uint64_t)ntohl(w[0]) << 32) | ntohl(w[1]),
+        ((uint64_t)ntohl(w[2]) << 32) | ntohl(w[3]));
+}
+
+// sort and coalesce overlapping ranges
+template<typename T>
+static void normalize_ranges(Ranges<T>& r)
+{
+    if (r.empty())
+        return;
+
+    std::sort(r.begin(), r.end());
+    size_t n = 0;
+
+    for (size_t i = 1; i < r.size(); i++)
+    {
+        if (r[i].first <= r[n].second)
+        {
+            if (r[n].second < r[i].second)
+                r[n].second = r[i].second;
+        }
+        else
+            r[++n] = r[i];
+    }
+    r.resize(n + 1);
+}
+
+// a - b; both normalized
+template<typename T>
+static Ranges<T> subtract_ranges(const Ranges<T>& a, const Ranges<T>& b)
+{
+    Ranges<T> out;
+    size_t j = 0;
+
+    for (const auto& x : a)
+    {
+        T lo = x.first;
+        bool open = true;
+
+        while (j < b.size() and b[j].second < lo)
+            j++;
+
+        for (size_t k = j; open and k < b.size() and b[k].first <= x.second; k++)
+        {
+            if (lo < b[k].first)
+                out.emplace_back(lo, prev_val(b[k].first));
+
+            if (x.second <= b[k].second)
+                open = false;
+            else
+                lo = next_val(b[k].second);
+        }
+        if (open)
+            out.emplace_back(lo, x.second);
+    }
+    return out;
+}
+
+template<typename T>
+static inline bool in_ranges(const Ranges<T>& r, const T& v)
+{
+    auto it = std::upper_bound(r.begin(), r.end(), v,
+        [](const T& val, const std::pair<T, T>& x) { return val < x.first; });
+
+    return it != r.begin() and v <= (it - 1)->second;
+}
+
+// false if the node's containment can't be expressed as a range
+static bool add_range4(Ranges<uint32_t>& r, const SfCidr* cidr)
+{
+    uint32_t haystack = ntohl(cidr->get_addr()->get_ip4_value());
+
+    if (haystack == 0)
+    {
+        r.emplace_back(0, UINT32_MAX);
+        return true;
+    }
+
+    uint32_t shift = 128 - cidr->get_bits();
+
+    if (shift >= 32)
+        return false;
+
+    uint32_t host = (uint32_t)((1ull << shift) - 1);
+
+    if (!(haystack & host))
+        r.emplace_back(haystack, haystack | host);
+
+    return true;
+}
+
+static bool add_range6(Ranges<Ip6Val>& r, const SfCidr* cidr)
+{
+    unsigned bits = cidr->get_bits();
+
+    if (bits > 128)
+        return false;
+
+    if (bits % 32)
+    {
+        uint32_t word = ntohl(cidr->get_addr()->get_ip6_ptr()[bits / 32]);
+
+        if (word & ((1u << (32 - bits % 32)) - 1))
+            return true;
+    }
+
+    Ip6Val mask;
+
+    if (bits == 0)
+        mask = Ip6Val(0, 0);
+    else if (bits <= 64)
+        mask = Ip6Val(UINT64_MAX << (64 - bits), 0);
+    else
+        mask = Ip6Val(UINT64_MAX, UINT64_MAX << (128 - bits));
+
+    Ip6Val addr = get_ip6_val(cidr->get_addr());
+    Ip6Val lo(addr.first & mask.first, addr.second & mask.second);
+
+    r.emplace_back(lo, Ip6Val(lo.first | ~mask.first, lo.second | ~mask.second));
+    return true;
+}
+
+static void sfvar_decompile(sfip_var_t* var)
+{
+    delete var->ranges;
+    var->ranges = nullptr;
+}
+
+static void sfvar_compile(sfip_var_t* var)
+{
+    sfvar_decompile(var);
+
+    Ranges<uint32_t> pos4, neg4;
+    Ranges<Ip6Val> pos6, neg6;
+    bool all = !var->head;
+
+    for (sfip_node_t* p = var->head; p; p = p->next)
+    {
+        if (!p->ip->is_set())
+            all = true;
+
+        else if (p->ip->get_family() == AF_INET)
+        {
+            if (!add_range4(pos4, p->ip))
+                return;
+        }
+        else if (p->ip->get_family() == AF_INET6)
+        {
+            if (!add_range6(pos6, p->ip))
+                return;
+        }
+    }
+
+    for (sfip_node_t* p = var->neg_head; p; p = p->next)
+    {
+        if (p->ip->get_family() == AF_INET)
+        {
+            if (!add_range4(neg4, p->ip))
+                return;
+        }
+        else if (p->ip->get_family() == AF_INET6)
+        {
+            if (!add_range6(neg6, p->ip))
+                return;
+        }
+    }
+
+    if (all)
+    {
+        pos4.assign(1, { 0, UINT32_MAX });
+        pos6.assign(1, { Ip6Val(0, 0), Ip6Val(UINT64_MAX, UINT64_MAX) });
+    }
+
+    normalize_ranges(pos4);
+    normalize_ranges(neg4);
+    normalize_ranges(pos6);
+    normalize_ranges(neg6);
+
+    var->ranges = new sfip_ranges_t;
+    var->ranges->v4 = subtract_ranges(pos4, neg4);
+    var->ranges->v6 = subtract_ranges(pos6, neg6);
+}
+
 /* Support function for sfvar_ip_in  */
 static inline bool sfvar_ip_in4(sfip_var_t* var, const SfIp* ip)
 {
@@ -1156,6 +1419,14 @@ bool sfvar_ip_in(sfip_var_t* var, const SfIp* ip)
     if (!var || !ip)
         return false;
 
+    if (var->ranges)
+    {
+        if (ip->get_family() == AF_INET)
+            return in_ranges(var->ranges->v4, (uint32_t)ntohl(ip->get_ip4_value()));
+
+        return in_ranges(var->ranges->v6, get_ip6_val(ip));
+    }
+
     /* Since this is a performance-critical function it uses different
      * codepaths for IPv6 and IPv4 traffic, rather than the dual-stack
      * functions. */
@@ -1469,5 +1740,122 @@ TEST_CASE("SfIpVarAny", "[SfIpVar]")
     sfvt_free_table(table);
 }
 
-#endif
+// the compiled ranges must give the same answer as the list walk
+static void check_equivalent(sfip_var_t* var, const SfIp& ip)
+{
+    bool list = (ip.get_family() == AF_INET) ? sfvar_ip_in4(var, &ip) : sfvar_ip_in6(var, &ip);
+    CHECK(sfvar_ip_in(var, &ip) == list);
+}
+
+// every node address with each of its bits flipped hits both sides of
+// every prefix boundary in the variable
+static void check_node_neighbors(sfip_var_t* var, sfip_node_t* node)
+{
+    for (; node; node = node->next)
+    {
+        const SfIp* addr = node->ip->get_addr();
+        uint32_t w[4];
+        memcpy(w, addr->get_ip6_ptr(), sizeof(w));
+
+        SfIp ip;
+        if (addr->get_family() == AF_INET)
+        {
+            for (unsigned b = 0; b <= 32; b++)
+            {
+                uint32_t v = ntohl(w[3]) ^ (b < 32 ? (1u << b) : 0);
+                v = htonl(v);
+                ip.set(&v, AF_INET);
+                check_equivalent(var, ip);
+            }
+        }
+        else if (addr->get_family() == AF_INET6)
+        {
+            for (unsigned b = 0; b <= 128; b++)
+            {
+                uint32_t x[4];
+                memcpy(x, w, sizeof(x));
+
+                if (b < 128)
+                    x[b / 32] = htonl(ntohl(x[b / 32]) ^ (1u << (b % 32)));
+
+                ip.set(x, AF_INET6);
+                check_equivalent(var, ip);
+            }
+        }
+    }
+}
 
+TEST_CASE("SfIpVarCompiled", "[SfIpVar]")
+{
+    const char* vars[] =
+    {
+        "v1 [ 192.168.0.0/16, 10.0.0.0/8, 172.16.0.0/12 ]",
+        "v2 [ 192.168.0.0/16, !192.168.1.0/24, !192.168.2.7 ]",
+        "v3 [ !10.1.0.0/16, !10.2.3.4 ]",
+        "v4 any",
+        "v5 [ 1.2.3.4, 1.2.3.5, 1.2.3.6, 9.9.9.0/31 ]",
+        "v6 [ 2001:db8::/32, !2001:db8:1::/48, 10.0.0.0/8 ]",
+        "v7 [ !fe80::/10, !::1 ]",
+        "v8 [ 0.0.0.0/0, !127.0.0.0/8 ]",
+        "v9 [ ::/0, !2001:db8::1 ]",
+        "v10 [ $v1, !$v5, 8.8.8.8 ]",
+        "v11 [ [ 11.0.0.0/8, !11.1.0.0/16 ], [ 12.0.0.0/8, !12.2.0.0/16 ] ]",
+        "v12 [ 255.255.255.255, 0.0.0.1, 128.0.0.0/1 ]",
+        "v13 [ ffff:ffff::/32, ::/128, ::1/128 ]",
+    };
+
+    vartable_t* table = sfvt_alloc_table();
+    uint32_t seed = 0x1234567;
+
+    for (auto str : vars)
+    {
+        sfip_var_t* var;
+        CHECK(sfvt_add_str(table, str, &var) == SFIP_SUCCESS);
+        CHECK(var->ranges != nullptr);
+
+        check_node_neighbors(var, var->head);
+        check_node_neighbors(var, var->neg_head);
+
+        for (unsigned i = 0; i < 2000; i++)
+        {
+            uint32_t x[4];
+
+            for (auto& w : x)
+            {
+                seed = seed * 1103515245 + 12345;
+                w = seed;
+            }
+            // bias toward the ranges used above
+            if (i & 1)
+                x[3] = htonl((ntohl(x[3]) & 0x00ffffff) | ((i % 13) << 24));
+
+            SfIp ip;
+            ip.set(&x[3], AF_INET);
+            check_equivalent(var, ip);
+
+            if (i & 2)
+                x[0] = htonl(0x20010db8);
+
+            ip.set(x, AF_INET6);
+            check_equivalent(var, ip);
+        }
+    }
+
+    // any change drops back to the list walk until recompiled
+    sfip_var_t* var;
+    CHECK(sfvt_add_str(table, "v14 [ 1.1.1.0/24 ]", &var) == SFIP_SUCCESS);
+    CHECK(var->ranges != nullptr);
+    sfip_node_t* node = sfipnode_alloc("!1.1.1.1", nullptr);
+    CHECK(SFIP_SUCCESS == sfvar_add_node(var, node, 1));
+    CHECK(var->ranges == nullptr);
+
+    SfIp ip;
+    ip.set("1.1.1.1");
+    CHECK(sfvar_ip_in(var, &ip) == false);
+    ip.set("1.1.1.2");
+    CHECK(sfvar_ip_in(var, &ip) == true);
+
+    sfvt_free_table(table);
+}
+
+#endif
@@ -64,6 +64,9 @@ typedef struct _ip_node
                     /* Should merge them later */
 } sfip_node_t;
 
+/* Sorted, disjoint address ranges compiled from the lists below */
+struct sfip_ranges_t;
+
 /* An IP variable onkect */
 struct sfip_var_t
 {
@@ -75,6 +78,10 @@ struct sfip_var_t
     sfip_node_t* head;
     sfip_node_t* neg_head;
 
+    /* The lists above folded into ranges for lookups; null when the lists
+     * have changed since the last compile or can't be folded exactly */
+    sfip_ranges_t* ranges;
+
     /* The mode above will select whether to use the sfip_node_t linked list
      * or the IP routing table */
 //    sfrt rt;
@@ -36,6 +36,7 @@ struct SnortConfig;
 struct IcmpStats
 {
     SESSION_STATS;
+    PegCount pooled;
 };
 
 //-------------------------------------------------------------------------
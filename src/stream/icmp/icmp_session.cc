@@ -43,12 +43,17 @@ using namespace snort;
 const PegInfo icmp_pegs[] =
 {
     SESSION_PEGS("icmp"),
+    { CountType::SUM, "pooled", "icmp session trackers reused from the thread pool" },
     { CountType::END, nullptr, nullptr }
 };
 
 THREAD_LOCAL IcmpStats icmpStats;
 THREAD_LOCAL ProfileStats icmp_perf_stats;
 
+#define ICMP_POOL_MAX 1024
+
+static THREAD_LOCAL SessionPool* icmp_pool = nullptr;
+
 //------------------------------------------------------------------------
 // private functions
 //------------------------------------------------------------------------
@@ -190,6 +195,30 @@ IcmpSession::IcmpSession(Flow* f) : Session(f)
 IcmpSession::~IcmpSession()
 { memory::MemoryCap::update_deallocations(sizeof(*this)); }
 
+void* IcmpSession::operator new(size_t n)
+{
+    assert(n == sizeof(IcmpSession));
+    return icmp_pool ? icmp_pool->get(n, icmpStats.pooled) : ::operator new(n);
+}
+
+void IcmpSession::operator delete(void* p)
+{
+    if ( icmp_pool )
+        icmp_pool->put(p);
+    else
+        ::operator delete(p);
+}
+
+void IcmpSession::tinit()
+{ icmp_pool = new SessionPool(ICMP_POOL_MAX); }
+
+// sessions still held after this are freed directly instead of pooled
+void IcmpSession::tterm()
+{
+    delete icmp_pool;
+    icmp_pool = nullptr;
+}
+
 bool IcmpSession::setup(Packet*)
 {
     echo_count = 0;
@@ -32,6 +32,12 @@ public:
     int process(snort::Packet*) override;
     void clear() override;
 
+    static void* operator new(size_t);
+    static void operator delete(void*);
+
+    static void tinit();
+    static void tterm();
+
 public:
     uint32_t echo_count;
     struct timeval ssn_time;
@@ -109,11 +109,13 @@ static Inspector* icmp_ctor(Module* m)
 static void icmp_tinit()
 {
     IcmpHAManager::tinit();
+    IcmpSession::tinit();
 }
 
 static void icmp_tterm()
 {
     IcmpHAManager::tterm();
+    IcmpSession::tterm();
 }
 
 static void icmp_dtor(Inspector* p)
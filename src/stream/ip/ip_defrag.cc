@@ -70,6 +70,8 @@
 
 #include "ip_defrag.h"
 
+#include <vector>
+
 #include "detection/detect.h"
 #include "detection/detection_engine.h"
 #include "log/messages.h"
@@ -89,6 +91,11 @@
 #include "ip_session.h"
 #include "stream_ip.h"
 
+#ifdef UNIT_TEST
+#include "catch/snort_bench.h"
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
 /*  D E F I N E S  **************************************************/
@@ -119,15 +126,205 @@ using namespace snort;
 /*  D A T A   S T R U C T U R E S  **********************************/
 
 
+/*  F R A G M E N T   P O O L S  ************************************/
+// Fragment nodes and payload copies are recycled per packet thread so floods
+// of tiny or overlapping fragments don't go to the heap for each one.
+// Payloads come from a few slab sizes and are reference counted so a
+// fragment split around an overlap shares its payload instead of copying it.
+//
+// The memcap is charged when a node or slab comes from the heap and credited
+// when it goes back, so idle pooled memory stays charged.  Once over the
+// memcap threshold the free lists are emptied and nothing more is pooled so
+// that pruning flows actually gives memory back.
+
+static const unsigned s_mem_tag = memory::MemoryCap::register_tag("stream_ip");
+
+struct FragSlab
+{
+    uint32_t refs;
+    uint32_t cls;
+
+    uint8_t* data()
+    { return reinterpret_cast<uint8_t*>(this + 1); }
+
+    static FragSlab* get(uint8_t* data)
+    { return reinterpret_cast<FragSlab*>(data) - 1; }
+};
+
+static const unsigned frag_slab_sizes[] = { 256, 1536, 9216, 65536 };
+static const unsigned frag_slab_max[] = { 1024, 1024, 128, 16 };
+
+#define FRAG_SLAB_CLASSES (sizeof(frag_slab_sizes) / sizeof(frag_slab_sizes[0]))
+#define FRAG_POOL_MAX_NODES 8192
+
+static inline size_t slab_bytes(unsigned cls)
+{ return sizeof(FragSlab) + frag_slab_sizes[cls]; }
+
+static FragSlab* new_slab(unsigned cls)
+{
+    memory::MemoryCap::update_allocations(slab_bytes(cls), s_mem_tag);
+    FragSlab* fs = reinterpret_cast<FragSlab*>(new uint8_t[slab_bytes(cls)]);
+    fs->cls = cls;
+    return fs;
+}
+
+static void delete_slab(FragSlab* fs)
+{
+    memory::MemoryCap::update_deallocations(slab_bytes(fs->cls), s_mem_tag);
+    delete[] reinterpret_cast<uint8_t*>(fs);
+}
+
+static void* new_node(size_t n)
+{
+    memory::MemoryCap::update_allocations(n, s_mem_tag);
+    return ::operator new(n);
+}
+
+static void delete_node(void* p, size_t n)
+{
+    memory::MemoryCap::update_deallocations(n, s_mem_tag);
+    ::operator delete(p);
+}
+
+class FragPool
+{
+public:
+    ~FragPool()
+    { release(); }
+
+    void* get_node(size_t);
+    void put_node(void*, size_t);
+
+    FragSlab* get_slab(unsigned cls);
+    void put_slab(FragSlab*);
+
+private:
+    bool trim();
+    void release();
+
+private:
+    std::vector<void*> nodes;
+    std::vector<FragSlab*> slabs[FRAG_SLAB_CLASSES];
+    size_t node_size = 0;
+};
+
+static THREAD_LOCAL FragPool* frag_pool = nullptr;
+
+void FragPool::release()
+{
+    for ( auto* n : nodes )
+        delete_node(n, node_size);
+
+    nodes.clear();
+
+    for ( auto& v : slabs )
+    {
+        for ( auto* fs : v )
+            delete_slab(fs);
+
+        v.clear();
+    }
+}
+
+// empty the free lists when memory is short; true if items shouldn't be pooled
+bool FragPool::trim()
+{
+    if ( !memory::MemoryCap::over_threshold() )
+        return false;
+
+    release();
+    return true;
+}
+
+void* FragPool::get_node(size_t n)
+{
+    if ( nodes.empty() )
+        return new_node(n);
+
+    void* p = nodes.back();
+    nodes.pop_back();
+    return p;
+}
+
+void FragPool::put_node(void* p, size_t n)
+{
+    node_size = n;
+
+    if ( nodes.size() < FRAG_POOL_MAX_NODES and !trim() )
+        nodes.emplace_back(p);
+    else
+        delete_node(p, n);
+}
+
+FragSlab* FragPool::get_slab(unsigned cls)
+{
+    if ( slabs[cls].empty() )
+        return nullptr;
+
+    FragSlab* fs = slabs[cls].back();
+    slabs[cls].pop_back();
+    ip_stats.slabs_reused++;
+    return fs;
+}
+
+void FragPool::put_slab(FragSlab* fs)
+{
+    if ( slabs[fs->cls].size() < frag_slab_max[fs->cls] and !trim() )
+        slabs[fs->cls].emplace_back(fs);
+    else
+        delete_slab(fs);
+}
+
+static uint8_t* get_payload(uint16_t len)
+{
+    unsigned cls = 0;
+
+    while ( frag_slab_sizes[cls] < len )
+        ++cls;
+
+    FragSlab* fs = frag_pool ? frag_pool->get_slab(cls) : nullptr;
+
+    if ( !fs )
+        fs = new_slab(cls);
+
+    fs->refs = 1;
+    return fs->data();
+}
+
+static uint8_t* share_payload(uint8_t* data)
+{
+    FragSlab::get(data)->refs++;
+    ip_stats.payloads_shared++;
+    return data;
+}
+
+static void put_payload(uint8_t* data)
+{
+    FragSlab* fs = FragSlab::get(data);
+
+    if ( --fs->refs )
+        return;
+
+    if ( frag_pool )
+        frag_pool->put_slab(fs);
+    else
+        delete_slab(fs);
+}
+
 struct Fragment
 {
     Fragment(uint16_t flen, const uint8_t* fptr, int ord)
-    { init(flen, fptr, ord); }
+    {
+        init(flen, ord);
+        this->fptr = get_payload(flen);
+        memcpy(this->fptr, fptr, flen);
+    }
 
     Fragment(Fragment* other, int ord)
     {
-        init(other->flen, other->fptr, ord);
-        data = fptr + (other->data - other->fptr);
+        init(other->flen, ord);
+        fptr = share_payload(other->fptr);
+        data = other->data;
         size = other->size;
         offset = other->offset;
         last = other->last;
@@ -135,16 +332,27 @@ struct Fragment
 
     ~Fragment()
     {
-        delete[] fptr;
+        put_payload(fptr);
         ip_stats.nodes_released++;
-        memory::MemoryCap::update_deallocations(sizeof(*this) + flen);
+    }
+
+    // the pool charges the memcap for nodes and payloads
+    static void* operator new(size_t n)
+    { return frag_pool ? frag_pool->get_node(n) : new_node(n); }
+
+    static void operator delete(void* p, size_t n)
+    {
+        if ( frag_pool )
+            frag_pool->put_node(p, n);
+        else
+            delete_node(p, n);
     }
 
     uint8_t* data = nullptr;    /* ptr to adjusted start position */
     uint16_t size = 0;          /* adjusted frag size */
     uint16_t offset = 0;        /* adjusted offset position */
 
-    uint8_t* fptr = nullptr;    /* free pointer */
+    uint8_t* fptr = nullptr;    /* free pointer, shared by dups */
     uint16_t flen = 0;          /* free len, unneeded? */
 
     Fragment* prev = nullptr;
@@ -154,17 +362,13 @@ struct Fragment
     char last = 0;
 
 private:
-    inline void init(uint16_t flen, const uint8_t* fptr, int ord)
+    inline void init(uint16_t flen, int ord)
     {
         assert(flen > 0);
-        memory::MemoryCap::update_allocations(sizeof(*this) + flen);
 
         this->flen = flen;
-        this->fptr = new uint8_t[flen];
         this->ord = ord;
 
-        memcpy(this->fptr, fptr, flen);
-
         ip_stats.nodes_created++;
     }
 };
@@ -761,6 +965,51 @@ static inline void add_node(FragTracker* ft, Fragment* prev, Fragment* node)
     ft->fraglist_count++;
 }
 
+/**
+ * Find the neighbors of a new fragment in the offset ordered fraglist
+ *
+ * Fragments usually arrive in order or in reverse order (some stacks send
+ * the last one first) so the walk starts from whichever end is closer to
+ * the new offset, making those cases constant time.
+ *
+ * @param ft FragTracker to search
+ * @param frag_offset offset of the new fragment
+ * @param left last node with an offset before frag_offset, if any
+ * @param right first node with an offset at or after frag_offset, if any
+ */
+static inline void find_neighbors(
+    FragTracker* ft, uint16_t frag_offset, Fragment*& left, Fragment*& right)
+{
+    left = right = nullptr;
+
+    if ( !ft->fraglist )
+        return;
+
+    int from_head = frag_offset - ft->fraglist->offset;
+    int from_tail = ft->fraglist_tail->offset - frag_offset;
+
+    if ( from_tail < from_head )
+    {
+        left = ft->fraglist_tail;
+
+        while ( left and left->offset >= frag_offset )
+        {
+            right = left;
+            left = left->prev;
+        }
+    }
+    else
+    {
+        right = ft->fraglist;
+
+        while ( right and right->offset < frag_offset )
+        {
+            left = right;
+            right = right->next;
+        }
+    }
+}
+
 static inline void delete_node(FragTracker* ft, Fragment* node)
 {
     debug_logf(stream_ip_trace, nullptr, "Deleting list node %p (p %p n %p)\n",
@@ -831,6 +1080,18 @@ static void release_tracker(FragTracker* ft)
 
 Defrag::Defrag(FragEngine& e) : engine(e), layers(DEFAULT_LAYERMAX) { }
 
+void Defrag::tinit()
+{
+    frag_pool = new FragPool;
+}
+
+// fragments still held after this are freed directly instead of pooled
+void Defrag::tterm()
+{
+    delete frag_pool;
+    frag_pool = nullptr;
+}
+
 bool Defrag::configure(SnortConfig* sc)
 {
     // FIXIT-L kinda squiffy ... set for each instance (but to same value) ... move to tinit() ?
@@ -1060,7 +1321,6 @@ int Defrag::insert(Packet* p, FragTracker* ft, FragEngine* fe)
     int16_t slide = 0;      /* slide up the front of the current frag */
     int done = 0;           /* flag for right-side overlap handling loop */
     int addthis = 1;        /* flag for right-side overlap handling loop */
-    int i = 0;              /* counter */
     int firstLastOk;
     int ret = FRAG_INSERT_OK;
     unsigned char lastfrag = 0;     /* Set to 1 when this is the 'last' frag */
@@ -1068,7 +1328,6 @@ int Defrag::insert(Packet* p, FragTracker* ft, FragEngine* fe)
     Fragment* right = nullptr;      /* frag ptr for right-side overlap loop */
     Fragment* newfrag = nullptr;    /* new frag container */
     Fragment* left = nullptr;       /* left-side overlap fragment ptr */
-    Fragment* idx = nullptr;        /* indexing fragment pointer for loops */
     Fragment* dump_me = nullptr;    /* frag ptr for complete overlaps to dump */
     const uint8_t* fragStart;
     int16_t fragLength;
@@ -1201,28 +1460,9 @@ int Defrag::insert(Packet* p, FragTracker* ft, FragEngine* fe)
      * Need to figure out where in the frag list this frag should go
      * and who its neighbors are
      */
-    for (idx = ft->fraglist; idx; idx = idx->next)
-    {
-        i++;
-        right = idx;
+    find_neighbors(ft, frag_offset, left, right);
 
-        debug_logf(stream_ip_trace, p, "%d right o %d s %d ptr %p prv %p nxt %p\n",
-            i, right->offset, right->size, (void*) right,
-            (void*) right->prev, (void*) right->next);
-
-        if (right->offset >= frag_offset)
-        {
-            break;
-        }
-
-        left = right;
-    }
-
-    /*
-     * null things out if we walk to the end of the list
-     */
-    if (idx == nullptr)
-        right = nullptr;
+    debug_logf(stream_ip_trace, p, "left %p right %p\n", (void*) left, (void*) right);
 
     /*
      * handle forward (left-side) overlaps...
@@ -2028,3 +2268,258 @@ inline int Defrag::expired(Packet* p, FragTracker* ft, FragEngine* fe)
     return false;
 }
 
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+static const uint8_t* test_payload()
+{
+    static uint8_t data[IP_MAXPACKET];
+    static bool init = false;
+
+    if ( !init )
+    {
+        for ( unsigned i = 0; i < sizeof(data); ++i )
+            data[i] = (uint8_t)i;
+        init = true;
+    }
+    return data;
+}
+
+// as add_frag_node without trimming
+static Fragment* add_frag(FragTracker* ft, uint16_t off, uint16_t len)
+{
+    Fragment* left;
+    Fragment* right;
+    find_neighbors(ft, off, left, right);
+
+    Fragment* frag = new Fragment(len, test_payload(), ft->ordinal++);
+    frag->data = frag->fptr;
+    frag->size = len;
+    frag->offset = off;
+
+    add_node(ft, left, frag);
+    return frag;
+}
+
+// as dup_frag_node, used when a new fragment splits an old one
+static Fragment* dup_frag(FragTracker* ft, Fragment* left)
+{
+    Fragment* frag = new Fragment(left, ft->ordinal++);
+    add_node(ft, left, frag);
+    return frag;
+}
+
+static size_t mem_used()
+{ return memory::MemoryCap::get_tag_usage(s_mem_tag); }
+
+TEST_CASE("defrag slab charging", "[ip_defrag]")
+{
+    size_t base = mem_used();
+
+    SECTION("slab")
+    {
+        FragSlab* fs = new_slab(1);
+        CHECK(fs->cls == 1);
+        CHECK(mem_used() >= base + slab_bytes(1));
+
+        delete_slab(fs);
+        CHECK(mem_used() == base);
+    }
+    SECTION("node")
+    {
+        void* p = new_node(sizeof(Fragment));
+        CHECK(mem_used() >= base + sizeof(Fragment));
+
+        delete_node(p, sizeof(Fragment));
+        CHECK(mem_used() == base);
+    }
+    SECTION("fragment")
+    {
+        // without a pool everything goes straight back to the heap
+        Fragment* frag = new Fragment(100, test_payload(), 0);
+        CHECK(mem_used() >= base + sizeof(Fragment) + slab_bytes(0));
+
+        delete frag;
+        CHECK(mem_used() == base);
+    }
+}
+
+TEST_CASE("defrag slab refs", "[ip_defrag]")
+{
+    size_t base = mem_used();
+    Defrag::tinit();
+
+    FragTracker ft { };
+    PegCount shared = ip_stats.payloads_shared;
+
+    Fragment* frag = add_frag(&ft, 0, 100);
+    FragSlab* fs = FragSlab::get(frag->fptr);
+    CHECK(fs->refs == 1);
+
+    Fragment* dup = dup_frag(&ft, frag);
+    CHECK(dup->fptr == frag->fptr);
+    CHECK(fs->refs == 2);
+    CHECK(ip_stats.payloads_shared == shared + 1);
+    CHECK(ft.fraglist == frag);
+    CHECK(ft.fraglist_tail == dup);
+
+    // the duplicate keeps the payload alive
+    delete_node(&ft, frag);
+    CHECK(fs->refs == 1);
+    CHECK(!memcmp(dup->fptr, test_payload(), 100));
+
+    // the last ref returns the slab to the pool
+    delete_node(&ft, dup);
+    CHECK(ft.fraglist == nullptr);
+
+    PegCount reused = ip_stats.slabs_reused;
+    frag = add_frag(&ft, 0, 200);
+    CHECK(FragSlab::get(frag->fptr) == fs);
+    CHECK(ip_stats.slabs_reused == reused + 1);
+
+    release_tracker(&ft);
+    Defrag::tterm();
+    CHECK(mem_used() == base);
+}
+
+TEST_CASE("defrag tracker release", "[ip_defrag]")
+{
+    const uint16_t lens[] = { 100, 1000, 5000, 20000 };
+
+    size_t base = mem_used();
+    Defrag::tinit();
+
+    FragTracker ft { };
+    uint16_t off = 0;
+
+    // overlaps split a fragment into two that share a payload
+    for ( auto len : lens )
+    {
+        dup_frag(&ft, add_frag(&ft, off, len));
+        off += len;
+    }
+    CHECK(ft.fraglist_count == 8);
+
+    size_t used = mem_used();
+    CHECK(used > base);
+
+    release_tracker(&ft);
+    CHECK(ft.fraglist == nullptr);
+
+    // pooled memory stays charged
+    CHECK(mem_used() == used);
+
+    PegCount reused = ip_stats.slabs_reused;
+    off = 0;
+
+    for ( auto len : lens )
+    {
+        dup_frag(&ft, add_frag(&ft, off, len));
+        off += len;
+    }
+    CHECK(ip_stats.slabs_reused == reused + 4);
+    CHECK(mem_used() == used);
+
+    release_tracker(&ft);
+    CHECK(mem_used() == used);
+
+    // the pool gives back what it holds and fragments still held after that
+    // go straight to the heap
+    add_frag(&ft, 0, 100);
+    Defrag::tterm();
+    CHECK(mem_used() > base);
+    CHECK(mem_used() < used);
+
+    release_tracker(&ft);
+    CHECK(mem_used() == base);
+}
+
+TEST_CASE("defrag find_neighbors", "[ip_defrag]")
+{
+    Defrag::tinit();
+
+    FragTracker ft { };
+    Fragment* left;
+    Fragment* right;
+
+    find_neighbors(&ft, 0, left, right);
+    CHECK(left == nullptr);
+    CHECK(right == nullptr);
+
+    // arrives in reverse order
+    Fragment* f48 = add_frag(&ft, 48, 8);
+    Fragment* f32 = add_frag(&ft, 32, 16);
+    Fragment* f16 = add_frag(&ft, 16, 16);
+    Fragment* f0 = add_frag(&ft, 0, 16);
+
+    CHECK(ft.fraglist == f0);
+    CHECK(ft.fraglist_tail == f48);
+
+    const struct { uint16_t off; Fragment* left; Fragment* right; } expect[] =
+    {
+        { 0, nullptr, f0 },
+        { 8, f0, f16 },
+        { 16, f0, f16 },
+        { 24, f16, f32 },  // nearer the head
+        { 40, f32, f48 },  // nearer the tail
+        { 48, f32, f48 },
+        { 56, f48, nullptr },
+    };
+
+    for ( const auto& e : expect )
+    {
+        find_neighbors(&ft, e.off, left, right);
+        CHECK(left == e.left);
+        CHECK(right == e.right);
+    }
+
+    release_tracker(&ft);
+    Defrag::tterm();
+}
+
+// trackers filled with tiny fragments, every fourth split by an overlap,
+// then released, with and without the pool
+TEST_CASE("defrag fragment flood", "[.bench][ip_defrag]")
+{
+    const unsigned num_trackers = 64;
+    const unsigned num_frags = 32;
+
+    std::vector<FragTracker> trackers(num_trackers);
+
+    auto flood = [&]()
+    {
+        for ( auto& ft : trackers )
+        {
+            ft = { };
+
+            for ( unsigned i = 0; i < num_frags; ++i )
+            {
+                Fragment* frag = add_frag(&ft, i * 8, 8);
+
+                if ( !(i % 4) )
+                    dup_frag(&ft, frag);
+            }
+        }
+        for ( auto& ft : trackers )
+            release_tracker(&ft);
+    };
+
+    size_t base = mem_used();
+    {
+        Benchmark bench("ip_defrag.flood_heap", num_trackers * num_frags, "frags");
+        bench.run(flood);
+    }
+
+    Defrag::tinit();
+    {
+        Benchmark bench("ip_defrag.flood_pooled", num_trackers * num_frags, "frags");
+        bench.run(flood);
+    }
+    Defrag::tterm();
+
+    CHECK(mem_used() == base);
+}
+#endif
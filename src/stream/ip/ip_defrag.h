@@ -45,7 +45,8 @@ public:
     void process(snort::Packet*, FragTracker*);
     void cleanup(FragTracker*);
 
-    static void init();
+    static void tinit();
+    static void tterm();
 
 private:
     int insert(snort::Packet*, FragTracker*, FragEngine*);
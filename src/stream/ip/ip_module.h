@@ -81,6 +81,9 @@ struct IpStats
     PegCount nodes_released;
     PegCount reassembled_bytes; // total_ipreassembled_bytes
     PegCount fragmented_bytes;  // total_ipfragmented_bytes
+    PegCount slabs_reused;
+    PegCount payloads_shared;
+    PegCount pooled;
 };
 
 extern const PegInfo ip_pegs[];
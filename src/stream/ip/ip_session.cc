@@ -60,12 +60,19 @@ const PegInfo ip_pegs[] =
     { CountType::SUM, "nodes_deleted", "fragments deleted from tracker" },
     { CountType::SUM, "reassembled_bytes", "total reassembled bytes" },
     { CountType::SUM, "fragmented_bytes", "total fragmented bytes" },
+    { CountType::SUM, "slabs_reused", "fragment payload buffers taken from the pool" },
+    { CountType::SUM, "payloads_shared", "fragment payloads shared instead of copied on overlap" },
+    { CountType::SUM, "pooled", "ip session trackers reused from the thread pool" },
     { CountType::END, nullptr, nullptr }
 };
 
 THREAD_LOCAL IpStats ip_stats;
 THREAD_LOCAL ProfileStats ip_perf_stats;
 
+#define IP_POOL_MAX 1024
+
+static THREAD_LOCAL SessionPool* ip_pool = nullptr;
+
 //-------------------------------------------------------------------------
 // private methods
 //-------------------------------------------------------------------------
@@ -135,6 +142,30 @@ IpSession::IpSession(Flow* f) : Session(f)
 IpSession::~IpSession()
 { memory::MemoryCap::update_deallocations(sizeof(*this)); }
 
+void* IpSession::operator new(size_t n)
+{
+    assert(n == sizeof(IpSession));
+    return ip_pool ? ip_pool->get(n, ip_stats.pooled) : ::operator new(n);
+}
+
+void IpSession::operator delete(void* p)
+{
+    if ( ip_pool )
+        ip_pool->put(p);
+    else
+        ::operator delete(p);
+}
+
+void IpSession::tinit()
+{ ip_pool = new SessionPool(IP_POOL_MAX); }
+
+// sessions still held after this are freed directly instead of pooled
+void IpSession::tterm()
+{
+    delete ip_pool;
+    ip_pool = nullptr;
+}
+
 void IpSession::clear()
 {
     if(tracker.engine)
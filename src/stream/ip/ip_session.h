@@ -85,6 +85,12 @@ public:
     bool add_alert(snort::Packet*, uint32_t gid, uint32_t sid) override;
     bool check_alerted(snort::Packet*, uint32_t gid, uint32_t sid) override;
 
+    static void* operator new(size_t);
+    static void operator delete(void*);
+
+    static void tinit();
+    static void tterm();
+
 public:
     FragTracker tracker;
 };
@@ -137,11 +137,15 @@ static void mod_dtor(Module* m)
 static void ip_tinit()
 {
     IpHAManager::tinit();
+    IpSession::tinit();
+    Defrag::tinit();
 }
 
 static void ip_tterm()
 {
     IpHAManager::tterm();
+    IpSession::tterm();
+    Defrag::tterm();
 }
 
 static Inspector* ip_ctor(Module* m)
@@ -378,6 +378,14 @@ void Stream::prune_flows()
         flow_con->prune_one(PruneReason::MEMCAP, false);
 }
 
+void Stream::get_top_memory_flows(std::vector<std::pair<size_t, Flow*>>& top, unsigned max)
+{
+    if ( flow_con )
+        flow_con->get_top_memory_flows(top, max);
+    else
+        top.clear();
+}
+
 //-------------------------------------------------------------------------
 // app proto id foo
 //-------------------------------------------------------------------------
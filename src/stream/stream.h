@@ -25,6 +25,8 @@
 // provides a common flow management interface
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include <daq_common.h>
 
@@ -78,6 +80,9 @@ public:
 
     static void handle_timeouts(bool idle);
     static void prune_flows();
+
+    // flows of this thread with the most flow data memory, largest first
+    static void get_top_memory_flows(std::vector<std::pair<size_t, Flow*>>&, unsigned max);
     static bool expected_flow(Flow*, Packet*);
 
     // Looks in the flow cache for flow session with specified key and returns
@@ -42,7 +42,7 @@ void HeldPacket::adjust_expiration(const timeval& delta, bool up)
 }
 
 HeldPacket::HeldPacket(DAQ_Msg_h msg, uint32_t seq, const timeval& exp, TcpStreamTracker& trk)
-    : daq_msg(msg), seq_num(seq), expiration(exp), tracker(trk), expired(false)
+    : daq_msg(msg), seq_num(seq), expiration(exp), tracker(&trk), expired(false)
 { }
 
 HeldPacketQueue::iter_t HeldPacketQueue::append(DAQ_Msg_h msg, uint32_t seq,
@@ -52,13 +52,19 @@ HeldPacketQueue::iter_t HeldPacketQueue::append(DAQ_Msg_h msg, uint32_t seq,
     packet_gettimeofday(&now);
     timeradd(&now, &timeout, &expiration);
 
-    q.emplace_back(msg, seq, expiration, trk);
+    if ( free_list.empty() )
+        q.emplace_back(msg, seq, expiration, trk);
+    else
+    {
+        free_list.front() = HeldPacket(msg, seq, expiration, trk);
+        q.splice(q.end(), free_list, free_list.begin());
+    }
     return --q.end();
 }
 
 void HeldPacketQueue::erase(iter_t it)
 {
-    q.erase(it);
+    free_list.splice(free_list.begin(), q, it);
 }
 
 bool HeldPacketQueue::execute(const timeval& cur_time, int max_remove)
@@ -43,7 +43,7 @@ public:
     bool has_expired()
     { return expired; }
 
-    TcpStreamTracker& get_tracker() const { return tracker; }
+    TcpStreamTracker& get_tracker() const { return *tracker; }
     DAQ_Msg_h get_daq_msg() const { return daq_msg; }
     uint32_t get_seq_num() const { return seq_num; }
     void adjust_expiration(const timeval& delta, bool up);
@@ -52,7 +52,7 @@ private:
     DAQ_Msg_h daq_msg;
     uint32_t seq_num;
     timeval expiration;
-    TcpStreamTracker& tracker;
+    TcpStreamTracker* tracker;
     bool expired;
 };
 
@@ -88,6 +88,10 @@ public:
 private:
     timeval timeout = {1, 0};
     list_t q;
+
+    // erased nodes are spliced here and reused by append so holding a
+    // packet does not allocate once the queue has reached its working size
+    list_t free_list;
 };
 
 #endif
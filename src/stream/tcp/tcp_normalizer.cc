@@ -25,6 +25,8 @@
 
 #include "tcp_normalizer.h"
 
+#include "codecs/ip/checksum.h"
+
 #include "tcp_module.h"
 #include "tcp_stream_session.h"
 #include "tcp_stream_tracker.h"
@@ -33,6 +35,15 @@ using namespace snort;
 
 THREAD_LOCAL PegCount tcp_norm_stats[PC_TCP_MAX][NORM_MODE_MAX];
 
+// header edits adjust the tcp checksum from a copy of the original header
+// so the packet doesn't need a full checksum update
+static void header_modified(TcpSegmentDescriptor& tsd, const uint8_t* orig)
+{
+    tcp::TCPHdr* tcph = const_cast<tcp::TCPHdr*>(tsd.get_tcph());
+    tcph->th_sum = checksum::adjust(tcph->th_sum, orig, tcph, tcph->hlen());
+    PacketManager::header_modified(tsd.get_pkt());
+}
+
 static const PegInfo pegName[] =
 {
     { CountType::SUM, "tcp_trim_syn", "tcp segments trimmed on SYN" },
@@ -83,9 +94,12 @@ bool TcpNormalizer::strip_tcp_timestamp(
 
     if (mode == NORM_MODE_ON)
     {
+        uint8_t orig[tcp::TCP_MAX_HEADER_LEN];
+        memcpy(orig, tsd.get_tcph(), tsd.get_tcph()->hlen());
+
         // set raw option bytes to nops
         memset((void*)opt, (uint32_t)tcp::TcpOptCode::NOP, tcp::TCPOLEN_TIMESTAMP);
-        tsd.set_packet_flags(PKT_MODIFIED);
+        header_modified(tsd, orig);
         return true;
     }
 
@@ -162,8 +176,11 @@ void TcpNormalizer::ecn_stripper(
     {
         if (tns.strip_ecn == NORM_MODE_ON)
         {
+            uint8_t orig[tcp::TCP_MAX_HEADER_LEN];
+            memcpy(orig, tcph, tcph->hlen());
+
             (const_cast<tcp::TCPHdr*>(tcph))->th_flags &= ~(TH_ECE | TH_CWR);
-            tsd.set_packet_flags(PKT_MODIFIED);
+            header_modified(tsd, orig);
         }
 
         tcp_norm_stats[PC_TCP_ECN_SSN][tns.strip_ecn]++;
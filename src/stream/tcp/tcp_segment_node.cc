@@ -32,6 +32,8 @@
 #include "segment_overlap_editor.h"
 #include "tcp_module.h"
 
+static const unsigned s_mem_tag = memory::MemoryCap::register_tag("stream_tcp");
+
 #define USE_RESERVE
 #ifdef USE_RESERVE
 static THREAD_LOCAL TcpSegmentNode* reserved = nullptr;
@@ -57,7 +59,7 @@ void TcpSegmentNode::clear()
     {
         TcpSegmentNode* tsn = reserved;
         reserved = reserved->next;
-        memory::MemoryCap::update_deallocations(sizeof(*tsn) + tsn->size);
+        memory::MemoryCap::update_deallocations(sizeof(*tsn) + tsn->size, s_mem_tag);
         tcpStats.mem_in_use -= tsn->size;
         snort_free(tsn);
     }
@@ -85,7 +87,7 @@ TcpSegmentNode* TcpSegmentNode::create(
 #endif
     {
         size_t size = sizeof(*tsn) + len;
-        memory::MemoryCap::update_allocations(size);
+        memory::MemoryCap::update_allocations(size, s_mem_tag);
         tsn = (TcpSegmentNode*)snort_alloc(size);
         tsn->size = len;
         tcpStats.mem_in_use += len;
@@ -124,7 +126,7 @@ void TcpSegmentNode::term()
     else
 #endif
     {
-        memory::MemoryCap::update_deallocations(sizeof(*this) + size);
+        memory::MemoryCap::update_deallocations(sizeof(*this) + size, s_mem_tag);
         tcpStats.mem_in_use -= size;
         snort_free(this);
     }
@@ -66,6 +66,8 @@
 
 using namespace snort;
 
+static const unsigned s_mem_tag = memory::MemoryCap::register_tag("stream_tcp");
+
 void TcpSession::sinit()
 {
     TcpSegmentDescriptor::setup();
@@ -87,13 +89,13 @@ TcpSession::TcpSession(Flow* f) : TcpStreamSession(f)
     server.session = this;
     tcpStats.instantiated++;
 
-    memory::MemoryCap::update_allocations(sizeof(*this));
+    memory::MemoryCap::update_allocations(sizeof(*this), s_mem_tag);
 }
 
 TcpSession::~TcpSession()
 {
     clear_session(true, false, false);
-    memory::MemoryCap::update_deallocations(sizeof(*this));
+    memory::MemoryCap::update_deallocations(sizeof(*this), s_mem_tag);
 }
 
 bool TcpSession::setup(Packet*)
@@ -45,6 +45,8 @@ using namespace snort;
 
 THREAD_LOCAL HeldPacketQueue* hpq = nullptr;
 
+static const unsigned s_mem_tag = memory::MemoryCap::register_tag("stream_tcp");
+
 const std::list<HeldPacket>::iterator TcpStreamTracker::null_iterator { };
 
 const char* tcp_state_names[] =
@@ -636,7 +638,7 @@ bool TcpStreamTracker::set_held_packet(Packet* p)
 
     // Temporarily increase memcap until message is finalized in case
     // DAQ makes a copy of the data buffer.
-    memory::MemoryCap::update_allocations(daq_msg_get_data_len(p->daq_msg));
+    memory::MemoryCap::update_allocations(daq_msg_get_data_len(p->daq_msg), s_mem_tag);
 
     held_packet = hpq->append(p->daq_msg, p->ptrs.tcph->seq(), *this);
     held_pkt_seq = p->ptrs.tcph->seq();
@@ -709,7 +711,7 @@ void TcpStreamTracker::finalize_held_packet(Packet* cp)
             tcp_session->held_packet_dir = SSN_DIR_NONE;
         }
 
-        memory::MemoryCap::update_deallocations(msglen);
+        memory::MemoryCap::update_deallocations(msglen, s_mem_tag);
 
         hpq->erase(held_packet);
         held_packet = null_iterator;
@@ -742,7 +744,7 @@ void TcpStreamTracker::finalize_held_packet(Flow* flow)
             tcpStats.held_packets_passed++;
         }
 
-        memory::MemoryCap::update_deallocations(msglen);
+        memory::MemoryCap::update_deallocations(msglen, s_mem_tag);
 
         hpq->erase(held_packet);
         held_packet = null_iterator;
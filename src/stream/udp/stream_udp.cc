@@ -104,11 +104,13 @@ static Session* udp_ssn(Flow* lws)
 static void udp_tinit()
 {
     UdpHAManager::tinit();
+    UdpSession::tinit();
 }
 
 static void udp_tterm()
 {
     UdpHAManager::tterm();
+    UdpSession::tterm();
 }
 
 static Inspector* udp_ctor(Module* m)
@@ -34,6 +34,7 @@ struct UdpStats
     SESSION_STATS;
     PegCount total_bytes;
     PegCount ignored;
+    PegCount pooled;
 };
 
 extern const PegInfo udp_pegs[];
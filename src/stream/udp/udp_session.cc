@@ -34,6 +34,13 @@
 #include "udp_module.h"
 #include "stream_udp.h"
 
+#ifdef UNIT_TEST
+#include <vector>
+
+#include "catch/snort_bench.h"
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
 // NOTE:  sender is assumed to be client
@@ -44,12 +51,17 @@ const PegInfo udp_pegs[] =
     SESSION_PEGS("udp"),
     { CountType::SUM, "total_bytes", "total number of bytes processed" },
     { CountType::SUM, "ignored", "udp packets ignored" },
+    { CountType::SUM, "pooled", "udp session trackers reused from the thread pool" },
     { CountType::END, nullptr, nullptr }
 };
 
 THREAD_LOCAL UdpStats udpStats;
 THREAD_LOCAL ProfileStats udp_perf_stats;
 
+#define UDP_POOL_MAX 4096
+
+static THREAD_LOCAL SessionPool* udp_pool = nullptr;
+
 //-------------------------------------------------------------------------
 
 static void UdpSessionCleanup(Flow* lwssn)
@@ -109,6 +121,30 @@ UdpSession::UdpSession(Flow* f) : Session(f)
 UdpSession::~UdpSession()
 { memory::MemoryCap::update_deallocations(sizeof(*this)); }
 
+void* UdpSession::operator new(size_t n)
+{
+    assert(n == sizeof(UdpSession));
+    return udp_pool ? udp_pool->get(n, udpStats.pooled) : ::operator new(n);
+}
+
+void UdpSession::operator delete(void* p)
+{
+    if ( udp_pool )
+        udp_pool->put(p);
+    else
+        ::operator delete(p);
+}
+
+void UdpSession::tinit()
+{ udp_pool = new SessionPool(UDP_POOL_MAX); }
+
+// sessions still held after this are freed directly instead of pooled
+void UdpSession::tterm()
+{
+    delete udp_pool;
+    udp_pool = nullptr;
+}
+
 bool UdpSession::setup(Packet* p)
 {
     ssn_time.tv_sec = p->pkth->ts.tv_sec;
@@ -191,3 +227,56 @@ int UdpSession::process(Packet* p)
     return 0;
 }
 
+#ifdef UNIT_TEST
+TEST_CASE("udp session pool", "[udp_session]")
+{
+    UdpSession::tinit();
+
+    Session* ssn = new UdpSession(nullptr);
+    void* mem = ssn;
+    delete ssn;
+
+    PegCount pooled = udpStats.pooled;
+    ssn = new UdpSession(nullptr);
+
+    CHECK(ssn == mem);
+    CHECK(udpStats.pooled == pooled + 1);
+
+    delete ssn;
+    UdpSession::tterm();
+
+    // without the pool sessions go straight to the heap
+    ssn = new UdpSession(nullptr);
+    CHECK(udpStats.pooled == pooled + 1);
+    delete ssn;
+}
+
+//-------------------------------------------------------------------------
+// benchmark
+//-------------------------------------------------------------------------
+
+// session create / release as done when the flow cache moves flows between
+// protocols, with and without the thread pool
+TEST_CASE("udp session churn", "[.bench][udp_session]")
+{
+    const unsigned batch = 1024;
+    std::vector<Session*> ssns(batch);
+
+    auto churn = [&ssns]()
+    {
+        for ( auto& ssn : ssns )
+            ssn = new UdpSession(nullptr);
+
+        for ( auto* ssn : ssns )
+            delete ssn;
+    };
+
+    Benchmark heap("udp session churn heap", batch, "sessions");
+    heap.run(churn);
+
+    UdpSession::tinit();
+    Benchmark pool("udp session churn pool", batch, "sessions");
+    pool.run(churn);
+    UdpSession::tterm();
+}
+#endif
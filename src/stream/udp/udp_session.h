@@ -35,6 +35,12 @@ public:
     int process(snort::Packet*) override;
     void clear() override;
 
+    static void* operator new(size_t);
+    static void operator delete(void*);
+
+    static void tinit();
+    static void tterm();
+
 public:
     struct timeval ssn_time;
 };
@@ -25,11 +25,22 @@
 
 #include "host_attributes.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include "hash/lru_cache_shared.h"
 #include "main/shell.h"
 #include "main/snort.h"
 #include "main/snort_config.h"
 #include "main/thread.h"
+#include "main/thread_config.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
 
 using namespace snort;
 
@@ -41,6 +52,8 @@ static const PegInfo host_attribute_pegs[] =
     { CountType::SUM, "dynamic_service_adds", "number of service additions after initial host file load" },
     { CountType::SUM, "dynamic_service_updates", "number of service updates after initial host file load" },
     { CountType::SUM, "service_list_overflows", "number of service additions that failed due to configured resource limits" },
+    { CountType::SUM, "service_update_drops", "number of service updates dropped because the update queue was full" },
+    { CountType::SUM, "stale_service_updates", "number of appid service updates discarded because appid services were cleared after they were queued" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -72,18 +85,176 @@ public:
     { return true; }
 };
 
-static THREAD_LOCAL HostAttributesSharedCache* active_cache = nullptr;
-static HostAttributesSharedCache* swap_cache = nullptr;
+// Immutable open-addressing snapshot of the host table.  Packet threads look hosts up
+// here without locking; the writer builds a new table each time it publishes.
+class HostAttributesTable
+{
+public:
+    HostAttributesTable(const std::vector<std::pair<SfIp, HostAttributesEntry>>& hosts)
+    {
+        size_t cap = 16;
+
+        while ( cap < 2 * hosts.size() )
+            cap <<= 1;
+
+        mask = cap - 1;
+        slots.resize(cap);
+
+        for ( const auto& h : hosts )
+        {
+            size_t i = HostAttributesCacheKey()(h.first) & mask;
+
+            while ( slots[i].host )
+                i = (i + 1) & mask;
+
+            slots[i].ip = h.first;
+            slots[i].host = h.second;
+        }
+        num_hosts = hosts.size();
+    }
+
+    const HostAttributesDescriptor* find(const SfIp& ip) const
+    {
+        size_t i = HostAttributesCacheKey()(ip) & mask;
+
+        while ( slots[i].host )
+        {
+            if ( slots[i].ip == ip )
+                return slots[i].host.get();
+
+            i = (i + 1) & mask;
+        }
+        return nullptr;
+    }
+
+    size_t size() const
+    { return num_hosts; }
+
+private:
+    struct Slot
+    {
+        SfIp ip;
+        HostAttributesEntry host;
+    };
+
+    std::vector<Slot> slots;
+    size_t mask;
+    size_t num_hosts;
+};
+
+typedef std::shared_ptr<const HostAttributesTable> HostAttributesSnapshot;
+
+// the service limit is taken from the packet thread's config when the update is
+// queued since the writer thread has no config of its own
+struct HostServiceUpdate
+{
+    SfIp ip;
+    uint16_t port;
+    uint16_t protocol;
+    SnortProtocolId snort_protocol_id;
+    bool appid_service;
+    unsigned clear_epoch;
+    uint32_t max_services;
+};
+
+// counts kept by the writer and collected by packet threads without writer_lock
+struct HostWriterStats
+{
+    std::atomic<PegCount> dynamic_host_adds { 0 };
+    std::atomic<PegCount> dynamic_service_adds { 0 };
+    std::atomic<PegCount> dynamic_service_updates { 0 };
+    std::atomic<PegCount> service_list_overflows { 0 };
+    std::atomic<PegCount> stale_service_updates { 0 };
+
+    // set with each publish
+    std::atomic<PegCount> hosts_pruned { 0 };
+    std::atomic<PegCount> total_hosts { 0 };
+};
+
+// single producer, single consumer ring of service updates from one packet thread
+// to the writer; neither side locks
+class HostUpdateQueue
+{
+public:
+    bool put(const HostServiceUpdate& u)
+    {
+        unsigned h = head.load(std::memory_order_relaxed);
+
+        if ( h - tail.load(std::memory_order_acquire) == max_updates )
+            return false;
+
+        ring[h & (max_updates - 1)] = u;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool get(HostServiceUpdate& u)
+    {
+        unsigned t = tail.load(std::memory_order_relaxed);
+
+        if ( t == head.load(std::memory_order_acquire) )
+            return false;
+
+        u = ring[t & (max_updates - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    unsigned size() const
+    { return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed); }
+
+    static const unsigned max_updates = 1024;  // must be a power of 2
+
+private:
+    HostServiceUpdate ring[max_updates];
+    std::atomic<unsigned> head { 0 };
+    std::atomic<unsigned> tail { 0 };
+};
+
+// per packet thread view of the published snapshot and its update queue
+struct HostAttributesReader
+{
+    HostAttributesSnapshot table;
+    unsigned gen = 0;
+    HostUpdateQueue* queue = nullptr;
+    unsigned clear_epoch = 0;
+};
+
+// the writer is woken when a queue holds this many updates and otherwise drains
+// the queues at this interval
+static const unsigned max_update_batch = 64;
+static const std::chrono::seconds max_update_delay { 1 };
+
+// the writer state is only touched under writer_lock, which is held by the writer
+// thread and the main thread; packet threads never take it on the packet path
+static std::mutex writer_lock;
+static std::condition_variable writer_cv;
+static std::thread* writer = nullptr;
+static bool writer_running = false;
+static HostAttributesSharedCache* writer_cache = nullptr;
 static HostAttributesSharedCache* next_cache = nullptr;
-static HostAttributesSharedCache* old_cache = nullptr;
+static HostAttributesSharedCache* swap_cache = nullptr;
+static HostWriterStats writer_stats;
+static unsigned cleared_epoch = 0;
+
+// one queue per packet thread, allocated on the main thread before it is used
+static HostUpdateQueue* update_queues = nullptr;
+
+// set by packet threads, acted on by the writer
+static std::atomic<bool> swap_requested { false };
+static std::atomic<unsigned> clear_epoch { 0 };
+
+// published with std::atomic_store, readers reload it when published_gen moves
+static HostAttributesSnapshot published;
+static std::atomic<unsigned> published_gen { 0 };
+
+static THREAD_LOCAL HostAttributesReader* reader = nullptr;
 static THREAD_LOCAL HostAttributeStats host_attribute_stats;
 
 bool HostAttributesDescriptor::update_service
     (uint16_t port, uint16_t protocol, SnortProtocolId snort_protocol_id, bool& updated,
-    bool is_appid_service)
+    uint32_t max_services, bool is_appid_service)
 {
-    std::lock_guard<std::mutex> lck(host_attributes_lock);
-
     for ( auto& s : services)
     {
         if ( s.ipproto == protocol && (uint16_t)s.port == port )
@@ -99,7 +270,7 @@ bool HostAttributesDescriptor::update_service
     }
 
     // service not found, add it
-    if ( services.size() < SnortConfig::get_conf()->get_max_services_per_host() )
+    if ( services.size() < max_services )
     {
         updated = false;
         services.emplace_back(HostServiceDescriptor(port, protocol, snort_protocol_id, is_appid_service));
@@ -109,9 +280,29 @@ bool HostAttributesDescriptor::update_service
     return false;
 }
 
+bool HostAttributesDescriptor::has_service
+    (uint16_t port, uint16_t protocol, SnortProtocolId snort_protocol_id) const
+{
+    for ( auto& s : services )
+    {
+        if ( s.ipproto == protocol && (uint16_t)s.port == port )
+            return s.snort_protocol_id == snort_protocol_id;
+    }
+    return false;
+}
+
+bool HostAttributesDescriptor::has_appid_services() const
+{
+    for ( auto& s : services )
+    {
+        if ( s.appid_service and s.snort_protocol_id != UNKNOWN_PROTOCOL_ID )
+            return true;
+    }
+    return false;
+}
+
 void HostAttributesDescriptor::clear_appid_services()
 {
-    std::lock_guard<std::mutex> lck(host_attributes_lock);
     for ( auto s = services.begin(); s != services.end(); )
     {
         if ( s->appid_service and s->snort_protocol_id != UNKNOWN_PROTOCOL_ID )
@@ -123,7 +314,6 @@ void HostAttributesDescriptor::clear_appid_services()
 
 void HostAttributesDescriptor::get_host_attributes(uint16_t port,HostAttriInfo* host_info) const
 {
-    std::lock_guard<std::mutex> slk(host_attributes_lock);
     host_info->frag_policy = policies.fragPolicy;
     host_info->stream_policy = policies.streamPolicy;
     host_info->snort_protocol_id = UNKNOWN_PROTOCOL_ID;
@@ -136,6 +326,192 @@ void HostAttributesDescriptor::get_host_attributes(uint16_t port,HostAttriInfo*
         }
     }
 }
+
+// caller must hold writer_lock
+static void publish(HostAttributesSharedCache* cache)
+{
+    HostAttributesSnapshot table;
+
+    if ( cache )
+    {
+        table = std::make_shared<const HostAttributesTable>(cache->get_all_data());
+
+        LruCacheSharedStats* cache_stats = (LruCacheSharedStats*)cache->get_counts();
+        writer_stats.hosts_pruned = cache_stats->alloc_prunes;
+        writer_stats.total_hosts = table->size();
+    }
+
+    std::atomic_store(&published, table);
+    published_gen.fetch_add(1, std::memory_order_release);
+}
+
+static const HostAttributesTable* get_table()
+{
+    if ( !reader )
+        return nullptr;
+
+    unsigned gen = published_gen.load(std::memory_order_acquire);
+
+    if ( gen != reader->gen )
+    {
+        reader->table = std::atomic_load(&published);
+        reader->gen = gen;
+    }
+    return reader->table.get();
+}
+
+// caller must hold writer_lock; descriptors already published are copied before they
+// are changed so readers of older snapshots are never disturbed
+static void apply_update(const HostServiceUpdate& u)
+{
+    bool created = false;
+    HostAttributesEntry host = writer_cache->find_else_create(u.ip, &created);
+
+    if ( !host )
+        return;
+
+    if ( created )
+    {
+        host->set_ip_addr(u.ip);
+        writer_stats.dynamic_host_adds++;
+    }
+    else
+    {
+        host = std::make_shared<HostAttributesDescriptor>(*host);
+        writer_cache->find_else_insert(u.ip, host, true);
+    }
+
+    bool updated = false;
+    if ( host->update_service(u.port, u.protocol, u.snort_protocol_id, updated, u.max_services,
+        u.appid_service) )
+    {
+        if ( updated )
+            writer_stats.dynamic_service_updates++;
+        else
+            writer_stats.dynamic_service_adds++;
+    }
+    else
+        writer_stats.service_list_overflows++;
+}
+
+// caller must hold writer_lock
+static void clear_writer_appid_services()
+{
+    auto hosts = writer_cache->get_all_data();
+
+    for ( auto& h : hosts )
+    {
+        if ( !h.second->has_appid_services() )
+            continue;
+
+        HostAttributesEntry host = std::make_shared<HostAttributesDescriptor>(*h.second);
+        host->clear_appid_services();
+        writer_cache->find_else_insert(h.first, host, true);
+    }
+}
+
+// caller must hold writer_lock.  the outgoing cache is retired here; published
+// snapshots hold their own references to its descriptors.
+static void swap_writer_cache()
+{
+    delete writer_cache;
+    writer_cache = swap_cache;
+    swap_cache = nullptr;
+}
+
+// caller must hold writer_lock.  each update carries the clear epoch its thread had
+// reached when it was queued.  a newer epoch means that thread already ran the clear
+// so it is done here before the update is applied; appid updates from an older epoch
+// were queued before the clear and are discarded so they don't restore cleared services.
+static void drain_updates()
+{
+    bool changed = false;
+
+    if ( swap_requested.exchange(false) and swap_cache )
+    {
+        swap_writer_cache();
+        changed = true;
+    }
+
+    unsigned epoch = clear_epoch.load(std::memory_order_acquire);
+
+    if ( epoch > cleared_epoch and writer_cache )
+    {
+        clear_writer_appid_services();
+        cleared_epoch = epoch;
+        changed = true;
+    }
+
+    unsigned num_queues = update_queues ? ThreadConfig::get_instance_max() : 0;
+
+    for ( unsigned i = 0; i < num_queues; ++i )
+    {
+        HostServiceUpdate u;
+
+        while ( update_queues[i].get(u) )
+        {
+            if ( !writer_cache )
+                continue;
+
+            if ( u.clear_epoch > cleared_epoch )
+            {
+                clear_writer_appid_services();
+                cleared_epoch = u.clear_epoch;
+            }
+            else if ( u.appid_service and u.clear_epoch < cleared_epoch )
+            {
+                writer_stats.stale_service_updates++;
+                continue;
+            }
+            apply_update(u);
+            changed = true;
+        }
+    }
+
+    if ( changed )
+        publish(writer_cache);
+}
+
+static void writer_main()
+{
+    std::unique_lock<std::mutex> lck(writer_lock);
+
+    while ( writer_running )
+    {
+        writer_cv.wait_for(lck, max_update_delay);
+        drain_updates();
+    }
+}
+
+static void start_writer()
+{
+    if ( writer )
+        return;
+
+    update_queues = new HostUpdateQueue[ThreadConfig::get_instance_max()];
+    writer_running = true;
+    writer = new std::thread(writer_main);
+}
+
+static void stop_writer()
+{
+    if ( !writer )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lck(writer_lock);
+        writer_running = false;
+    }
+    writer_cv.notify_one();
+
+    writer->join();
+    delete writer;
+    writer = nullptr;
+
+    delete[] update_queues;
+    update_queues = nullptr;
+}
+
 bool HostAttributesManager::load_hosts_file(snort::SnortConfig* sc, const char* fname)
 {
     delete next_cache;
@@ -161,21 +537,48 @@ bool HostAttributesManager::add_host(HostAttributesEntry host, snort::SnortConfi
     return next_cache->find_else_insert(host->get_ip_addr(), host, true);
 }
 
+// the loaded table is published at once on startup.  on reload it is staged here
+// and published by the writer once a packet thread reaches initialize(), ie when
+// the reload resource tuner or the swap command runs.
 void HostAttributesManager::activate(SnortConfig* sc)
 {
     if ( next_cache == nullptr )
         return;
-    old_cache = active_cache;
-    active_cache = next_cache;
-    swap_cache = next_cache;
-    next_cache = nullptr;
 
-    if( active_cache != old_cache and Snort::is_reloading() )
+    {
+        std::lock_guard<std::mutex> lck(writer_lock);
+        delete swap_cache;
+        swap_cache = next_cache;
+        next_cache = nullptr;
+
+        if ( !writer )
+        {
+            swap_writer_cache();
+            publish(writer_cache);
+        }
+    }
+    start_writer();
+
+    if ( Snort::is_reloading() )
         sc->register_reload_resource_tuner(new HostAttributesReloadTuner);
 }
 
 void HostAttributesManager::initialize()
-{ active_cache = swap_cache; }
+{
+    if ( !reader )
+    {
+        reader = new HostAttributesReader;
+        reader->clear_epoch = clear_epoch.load(std::memory_order_acquire);
+    }
+
+    if ( update_queues )
+        reader->queue = update_queues + get_instance_id();
+
+    swap_requested = true;
+    writer_cv.notify_one();
+
+    get_table();
+}
 
 void HostAttributesManager::load_failure_cleanup()
 {
@@ -183,21 +586,34 @@ void HostAttributesManager::load_failure_cleanup()
     next_cache = nullptr;
 }
 
-void HostAttributesManager::swap_cleanup()
+void HostAttributesManager::term()
 {
-    delete old_cache;
-    old_cache = nullptr;
+    stop_writer();
+
+    std::lock_guard<std::mutex> lck(writer_lock);
+    publish(nullptr);
+
+    delete writer_cache;
+    writer_cache = nullptr;
+    delete swap_cache;
+    swap_cache = nullptr;
 }
 
-void HostAttributesManager::term()
-{ delete active_cache; }
+void HostAttributesManager::thread_term()
+{
+    flush_updates();
+    delete reader;
+    reader = nullptr;
+}
 
 bool HostAttributesManager::get_host_attributes(const snort::SfIp& host_ip, uint16_t port, HostAttriInfo* host_info)
 {
-    if ( !active_cache )
+    const HostAttributesTable* table = get_table();
+
+    if ( !table )
         return false;
 
-    HostAttributesEntry h = active_cache->find(host_ip);
+    const HostAttributesDescriptor* h = table->find(host_ip);
     if (h)
     {
         h->get_host_attributes(port, host_info);
@@ -209,45 +625,67 @@ bool HostAttributesManager::get_host_attributes(const snort::SfIp& host_ip, uint
 void HostAttributesManager::update_service(const snort::SfIp& host_ip, uint16_t port,
     uint16_t protocol, SnortProtocolId snort_protocol_id, bool is_appid_service)
 {
-    if ( active_cache )
+    const HostAttributesTable* table = get_table();
+
+    if ( !table )
+        return;
+
+    // rediscovering a known service is the common case and needs no writer
+    const HostAttributesDescriptor* h = table->find(host_ip);
+
+    if ( h and h->has_service(port, protocol, snort_protocol_id) )
     {
-        bool created = false;
-        HostAttributesEntry host = active_cache->find_else_create(host_ip, &created);
-        if ( host )
-        {
-            if ( created )
-            {
-                host_attribute_stats.dynamic_host_adds++;
-            }
+        host_attribute_stats.dynamic_service_updates++;
+        return;
+    }
 
-            bool updated = false;
-            if ( host->update_service(port, protocol, snort_protocol_id, updated, is_appid_service) )
-            {
-                if ( updated )
-                    host_attribute_stats.dynamic_service_updates++;
-                else
-                    host_attribute_stats.dynamic_service_adds++;
-            }
-            else
-                host_attribute_stats.service_list_overflows++;
-        }
+    if ( !reader->queue )
+        return;
+
+    if ( !reader->queue->put({ host_ip, port, protocol, snort_protocol_id, is_appid_service,
+        reader->clear_epoch, SnortConfig::get_conf()->get_max_services_per_host() }) )
+    {
+        host_attribute_stats.service_update_drops++;
+        return;
     }
+
+    if ( reader->queue->size() == max_update_batch )
+        writer_cv.notify_one();
+}
+
+// updates are applied by the writer; this just hurries it along
+void HostAttributesManager::flush_updates()
+{
+    if ( reader and reader->queue and reader->queue->size() )
+        writer_cv.notify_one();
 }
 
+// called on each packet thread; the writer clears once per epoch and discards appid
+// updates queued before this thread reached it
 void HostAttributesManager::clear_appid_services()
 {
-    if ( active_cache )
-    {
-        auto hosts = active_cache->get_all_data();
-        for ( auto& h : hosts )
-            h.second->clear_appid_services();
-    }
+    if ( !reader )
+        return;
+
+    unsigned epoch = ++reader->clear_epoch;
+    unsigned prev = clear_epoch.load(std::memory_order_relaxed);
+
+    while ( prev < epoch and !clear_epoch.compare_exchange_weak(prev, epoch,
+        std::memory_order_release, std::memory_order_relaxed) )
+        ;
+
+    writer_cv.notify_one();
 }
 
 int32_t HostAttributesManager::get_num_host_entries()
 {
-    if ( active_cache )
-        return active_cache->size();
+    std::lock_guard<std::mutex> lck(writer_lock);
+
+    if ( swap_cache )
+        return swap_cache->size();
+
+    if ( writer_cache )
+        return writer_cache->size();
 
     return -1;
 }
@@ -257,13 +695,172 @@ const PegInfo* HostAttributesManager::get_pegs()
 
 PegCount* HostAttributesManager::get_peg_counts()
 {
-    if ( active_cache )
+    // the writer's counts are handed to the first thread that asks so they are summed once
+    host_attribute_stats.dynamic_host_adds += writer_stats.dynamic_host_adds.exchange(0);
+    host_attribute_stats.dynamic_service_adds += writer_stats.dynamic_service_adds.exchange(0);
+    host_attribute_stats.dynamic_service_updates += writer_stats.dynamic_service_updates.exchange(0);
+    host_attribute_stats.service_list_overflows += writer_stats.service_list_overflows.exchange(0);
+    host_attribute_stats.stale_service_updates += writer_stats.stale_service_updates.exchange(0);
+
+    host_attribute_stats.hosts_pruned = writer_stats.hosts_pruned;
+    host_attribute_stats.total_hosts = writer_stats.total_hosts;
+
+    return (PegCount*)&host_attribute_stats;
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+TEST_CASE("host attributes table lookup", "[host_attributes]")
+{
+    std::vector<std::pair<SfIp, HostAttributesEntry>> hosts;
+    char buf[32];
+
+    for ( unsigned i = 0; i < 1000; ++i )
     {
-        LruCacheSharedStats* cache_stats = (LruCacheSharedStats*) active_cache->get_counts();
-        host_attribute_stats.hosts_pruned = cache_stats->alloc_prunes;
-        host_attribute_stats.total_hosts = active_cache->size();
+        snprintf(buf, sizeof(buf), "10.%u.%u.1", i >> 8, i & 0xff);
+
+        SfIp ip;
+        ip.set(buf);
+
+        HostAttributesEntry h = std::make_shared<HostAttributesDescriptor>();
+        h->set_ip_addr(ip);
+        h->set_frag_policy(i & 0x7f);
+        hosts.emplace_back(ip, h);
     }
 
-    return (PegCount*)&host_attribute_stats;
+    HostAttributesTable table(hosts);
+    CHECK(table.size() == hosts.size());
+
+    for ( const auto& h : hosts )
+        CHECK(table.find(h.first) == h.second.get());
+
+    SfIp miss;
+    miss.set("192.168.1.1");
+    CHECK(table.find(miss) == nullptr);
+
+    std::vector<std::pair<SfIp, HostAttributesEntry>> none;
+    HostAttributesTable empty(none);
+    CHECK(empty.find(miss) == nullptr);
+}
+
+TEST_CASE("host attributes clear ordering", "[host_attributes]")
+{
+    std::lock_guard<std::mutex> lck(writer_lock);
+    REQUIRE(!writer);
+
+    writer_cache = new HostAttributesSharedCache(16);
+    update_queues = new HostUpdateQueue[ThreadConfig::get_instance_max()];
+
+    unsigned base = clear_epoch.load();
+    cleared_epoch = base;
+
+    SfIp ip;
+    ip.set("10.1.1.1");
+    HostUpdateQueue& q = update_queues[0];
+
+    auto host = [&ip]()
+    { return std::atomic_load(&published)->find(ip); };
+
+    // appid service discovered before the clear
+    q.put({ ip, 80, 6, 20, true, base, 8 });
+    drain_updates();
+    REQUIRE(host());
+    CHECK(host()->has_service(80, 6, 20));
+
+    // queued before its thread reached the clear but drained after another thread did
+    q.put({ ip, 443, 6, 21, true, base, 8 });
+    q.put({ ip, 22, 6, 24, false, base, 8 });
+    clear_epoch = base + 1;
+    q.put({ ip, 8080, 6, 22, true, base + 1, 8 });
+    drain_updates();
+    CHECK(!host()->has_service(80, 6, 20));
+    CHECK(!host()->has_service(443, 6, 21));
+    CHECK(host()->has_service(22, 6, 24));
+    CHECK(host()->has_service(8080, 6, 22));
+
+    // an update from a newer epoch means its thread cleared before queueing it
+    q.put({ ip, 25, 6, 23, true, base + 2, 8 });
+    drain_updates();
+    CHECK(!host()->has_service(8080, 6, 22));
+    CHECK(host()->has_service(25, 6, 23));
+    CHECK(cleared_epoch == base + 2);
+
+    publish(nullptr);
+    delete writer_cache;
+    writer_cache = nullptr;
+    delete[] update_queues;
+    update_queues = nullptr;
+    clear_epoch = base + 2;
+}
+
+TEST_CASE("host attributes writer thread", "[host_attributes]")
+{
+    {
+        std::lock_guard<std::mutex> lck(writer_lock);
+        REQUIRE(!writer);
+        writer_cache = new HostAttributesSharedCache(16);
+        cleared_epoch = clear_epoch.load();
+    }
+    HostAttributesManager::get_peg_counts();
+    start_writer();
+
+    SfIp ip;
+    ip.set("10.2.2.2");
+
+    // the writer thread has no config so the service limit comes with the update
+    unsigned epoch = clear_epoch.load();
+    update_queues[0].put({ ip, 80, 6, 20, false, epoch, 1 });
+    update_queues[0].put({ ip, 81, 6, 21, false, epoch, 1 });
+    writer_cv.notify_one();
+
+    for ( int i = 0; i < 300 and (update_queues[0].size() or !writer_stats.service_list_overflows); ++i )
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    stop_writer();
+
+    HostAttributesSnapshot table = std::atomic_load(&published);
+    REQUIRE(table);
+    REQUIRE(table->find(ip));
+    CHECK(table->find(ip)->has_service(80, 6, 20));
+    CHECK(!table->find(ip)->has_service(81, 6, 21));
+    CHECK(writer_stats.dynamic_host_adds.exchange(0) == 1);
+    CHECK(writer_stats.dynamic_service_adds.exchange(0) == 1);
+    CHECK(writer_stats.service_list_overflows.exchange(0) == 1);
+    CHECK(writer_stats.total_hosts == 1);
+
+    std::lock_guard<std::mutex> lck(writer_lock);
+    publish(nullptr);
+    delete writer_cache;
+    writer_cache = nullptr;
 }
 
+TEST_CASE("host attributes swap", "[host_attributes]")
+{
+    std::lock_guard<std::mutex> lck(writer_lock);
+    REQUIRE(!writer);
+
+    SfIp ip;
+    ip.set("10.3.3.3");
+
+    HostAttributesEntry h = std::make_shared<HostAttributesDescriptor>();
+    h->set_ip_addr(ip);
+
+    writer_cache = new HostAttributesSharedCache(16);
+    swap_cache = new HostAttributesSharedCache(16);
+    swap_cache->find_else_insert(ip, h, true);
+
+    // the writer retires the outgoing cache when it swaps
+    swap_requested = true;
+    drain_updates();
+    CHECK(!swap_cache);
+    CHECK(writer_cache->size() == 1);
+    CHECK(std::atomic_load(&published)->find(ip) == h.get());
+
+    publish(nullptr);
+    delete writer_cache;
+    writer_cache = nullptr;
+}
+#endif
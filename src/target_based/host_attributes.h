@@ -26,10 +26,10 @@
 
 #include <functional>
 #include <memory>
-#include <mutex>
 #include <vector>
 
 #include "framework/counts.h"
+#include "hash/hash_key_operations.h"
 #include "sfip/sf_ip.h"
 #include "target_based/snort_protocols.h"
 
@@ -46,6 +46,8 @@ struct HostAttributeStats
     PegCount dynamic_service_adds = 0;
     PegCount dynamic_service_updates = 0;
     PegCount service_list_overflows = 0;
+    PegCount service_update_drops = 0;
+    PegCount stale_service_updates = 0;
 };
 
 class HostServiceDescriptor
@@ -84,18 +86,23 @@ struct HostAttriInfo
     uint8_t frag_policy = 0;
 };
 
+// Descriptors reachable from a published snapshot are never modified; the writer
+// copies a descriptor, updates the copy, and publishes it with the next snapshot.
 class HostAttributesDescriptor
 {
 public:
     HostAttributesDescriptor() = default;
+    HostAttributesDescriptor(const HostAttributesDescriptor&) = default;
     ~HostAttributesDescriptor() = default;
 
     bool update_service(uint16_t port, uint16_t protocol, SnortProtocolId, bool& updated,
-        bool is_appid_service = false);
+        uint32_t max_services, bool is_appid_service = false);
+    bool has_service(uint16_t port, uint16_t protocol, SnortProtocolId) const;
+    bool has_appid_services() const;
     void clear_appid_services();
     void get_host_attributes(uint16_t, HostAttriInfo*) const;
 
-    // Note: the following get/set are only called from main thread on a temp LRU table
+    // Note: the following get/set are only called by the writer on unpublished descriptors
     const snort::SfIp& get_ip_addr() const
     { return ip_address; }
 
@@ -115,7 +122,6 @@ public:
     }
 
 private:
-    mutable std::mutex host_attributes_lock; // ensure updates to this shared object are safe
     snort::SfIp ip_address;
     HostPolicyDescriptor policies;
     std::vector<HostServiceDescriptor> services;
@@ -132,9 +138,8 @@ struct HostAttributesCacheKey
 {
     size_t operator()(const snort::SfIp& ip) const
     {
-        const uint64_t* ip64 = (const uint64_t*) ip.get_ip6_ptr();
-        return std::hash<uint64_t>() (ip64[0]) ^
-               std::hash<uint64_t>() (ip64[1]);
+        const uint8_t* ip8 = (const uint8_t*) ip.get_ip6_ptr();
+        return snort::hash_16(snort::hash_read64(ip8), snort::hash_read64(ip8 + 8), 0);
     }
 };
 
@@ -144,14 +149,15 @@ public:
     static bool load_hosts_file(snort::SnortConfig*, const char* fname);
     static void activate(snort::SnortConfig*);
     static void initialize();
-    static void swap_cleanup();
     static void load_failure_cleanup();
     static void term();
+    static void thread_term();
 
     static bool add_host(HostAttributesEntry, snort::SnortConfig*);
     static bool get_host_attributes(const snort::SfIp&, uint16_t, HostAttriInfo*);
     static void update_service(const snort::SfIp&, uint16_t port, uint16_t protocol,
         SnortProtocolId, bool is_appid_service = false);
+    static void flush_updates();
     static void clear_appid_services();
     static int32_t get_num_host_entries();
     static const PegInfo* get_pegs();
@@ -221,6 +221,8 @@ const PegInfo pc_names[] =
     { CountType::SUM, "pcre_match_limit", "total number of times pcre hit the match limit" },
     { CountType::SUM, "pcre_recursion_limit", "total number of times pcre hit the recursion limit" },
     { CountType::SUM, "pcre_error", "total number of times pcre returns error" },
+    { CountType::SUM, "tag_lookups", "packets checked against active tags" },
+    { CountType::SUM, "tag_prunes", "tags released for being idle or to stay under the memcap" },
     { CountType::END, nullptr, nullptr }
 };
 
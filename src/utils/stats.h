@@ -72,6 +72,8 @@ struct PacketCount
     PegCount pcre_match_limit;
     PegCount pcre_recursion_limit;
     PegCount pcre_error;
+    PegCount tag_lookups;
+    PegCount tag_prunes;
 };
 
 struct ProcessCount
@@ -0,0 +1,189 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// util_unfold_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/catch.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "utils/util_unfold.h"
+
+using namespace snort;
+
+static std::string unfold(const std::string& in, int trim, int* folded = nullptr,
+    uint32_t out_size = 0)
+{
+    std::vector<uint8_t> out(out_size ? out_size : in.size() + 1, 0xff);
+    uint32_t n = 0;
+
+    CHECK(sf_unfold_header((const uint8_t*)in.data(), in.size(), out.data(), out.size(), &n,
+        trim, folded) == 0);
+
+    REQUIRE(n <= out.size());
+    return std::string((const char*)out.data(), n);
+}
+
+static std::string strip_crlf(const std::string& in, uint32_t out_size)
+{
+    std::vector<uint8_t> out(out_size);
+    uint32_t n = 0;
+
+    CHECK(sf_strip_CRLF((const uint8_t*)in.data(), in.size(), out.data(), out.size(), &n) == 0);
+    REQUIRE(n <= out.size());
+    return std::string((const char*)out.data(), n);
+}
+
+static std::string strip_lws(const std::string& in, uint32_t out_size)
+{
+    std::vector<uint8_t> out(out_size);
+    uint32_t n = 0;
+
+    CHECK(sf_strip_LWS((const uint8_t*)in.data(), in.size(), out.data(), out.size(), &n) == 0);
+    REQUIRE(n <= out.size());
+    return std::string((const char*)out.data(), n);
+}
+
+// mostly base64 style text with line breaks and blanks mixed in
+static std::string make_text(std::mt19937& gen, unsigned len)
+{
+    static const char chars[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=:";
+    static const char special[] = " \t\r\n";
+
+    std::string s;
+
+    for ( unsigned i = 0; i < len; ++i )
+    {
+        if ( gen() % 8 )
+            s += chars[gen() % (sizeof(chars) - 1)];
+        else
+            s += special[gen() % (sizeof(special) - 1)];
+    }
+    return s;
+}
+
+TEST_CASE("unfold single line", "[util_unfold]")
+{
+    int folded = -1;
+    CHECK(unfold("Subject: hello world", 0, &folded) == "Subject: hello world");
+    CHECK(folded == 0);
+
+    CHECK(unfold("Subject: hello world", 1) == "Subject:helloworld");
+}
+
+TEST_CASE("unfold stops at end of header", "[util_unfold]")
+{
+    int folded = -1;
+    CHECK(unfold("Subject: hello\r\nTo: you\r\n", 0, &folded) == "Subject: hello");
+    CHECK(folded == 0);
+
+    CHECK(unfold("Subject: hello\nTo: you\n", 0) == "Subject: hello");
+}
+
+TEST_CASE("unfold folded header", "[util_unfold]")
+{
+    int folded = -1;
+    CHECK(unfold("Subject: a long\r\n  subject line\r\nTo: you", 0, &folded) ==
+        "Subject: a long subject line");
+    CHECK(folded == 3);
+
+    folded = -1;
+    CHECK(unfold("Content-Type: text/plain;\r\n\tcharset=us-ascii\r\n\r\n", 1, &folded) ==
+        "Content-Type:text/plain;charset=us-ascii");
+    CHECK(folded == 1);
+}
+
+TEST_CASE("unfold bounded by output size", "[util_unfold]")
+{
+    std::string in = "X-Header: " + std::string(100, 'a') + " " + std::string(100, 'b');
+
+    for ( uint32_t size : { 1u, 8u, 16u, 110u, 111u, 150u } )
+    {
+        std::vector<uint8_t> out(size + 16, 0xee);
+        uint32_t n = 0;
+
+        sf_unfold_header((const uint8_t*)in.data(), in.size(), out.data(), size, &n, 0, nullptr);
+
+        CHECK(n <= size);
+        CHECK(out[std::min(n, size - 1)] == 0);
+        CHECK(out[size] == 0xee);
+        CHECK(!memcmp(out.data(), in.data(), n < size ? n : size - 1));
+    }
+}
+
+TEST_CASE("strip crlf", "[util_unfold]")
+{
+    std::mt19937 gen(23);
+
+    for ( unsigned i = 0; i < 200; ++i )
+    {
+        std::string in = make_text(gen, gen() % 2000);
+        std::string expect;
+
+        for ( auto c : in )
+            if ( c != '\r' and c != '\n' )
+                expect += c;
+
+        CHECK(strip_crlf(in, in.size() + 1) == expect);
+
+        uint32_t limit = 1 + gen() % (in.size() + 1);
+        CHECK(strip_crlf(in, limit) == expect.substr(0, limit));
+    }
+}
+
+TEST_CASE("strip lws", "[util_unfold]")
+{
+    CHECK(strip_lws("=3D  \r\nabc\t \nxyz  ", 64) == "=3D\r\nabc\nxyz  ");
+
+    std::mt19937 gen(29);
+
+    for ( unsigned i = 0; i < 200; ++i )
+    {
+        std::string in = make_text(gen, gen() % 2000);
+        std::string expect;
+
+        for ( auto c : in )
+        {
+            if ( c == '\r' or c == '\n' )
+            {
+                while ( !expect.empty() and (expect.back() == ' ' or expect.back() == '\t') )
+                    expect.pop_back();
+            }
+            expect += c;
+        }
+
+        CHECK(strip_lws(in, in.size() + 1) == expect);
+    }
+}
+
+TEST_CASE("null buffers", "[util_unfold]")
+{
+    uint8_t buf[8];
+    uint32_t n = 0;
+
+    CHECK(sf_strip_CRLF(nullptr, 4, buf, sizeof(buf), &n) == -1);
+    CHECK(sf_strip_LWS(buf, sizeof(buf), nullptr, 4, &n) == -1);
+}
@@ -0,0 +1,239 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// util_utf_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/catch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "catch/snort_bench.h"
+#include "utils/util_utf.h"
+
+using namespace snort;
+
+// encode text in the given charset, optionally with a BOM
+static std::vector<uint8_t> encode(const std::string& text, CharsetCode cs, bool bom)
+{
+    std::vector<uint8_t> out;
+    unsigned size = (cs == CHARSET_UTF16LE or cs == CHARSET_UTF16BE) ? 2 : 4;
+    bool be = (cs == CHARSET_UTF16BE or cs == CHARSET_UTF32BE);
+
+    auto put = [&](uint32_t c)
+    {
+        for ( unsigned i = 0; i < size; ++i )
+        {
+            unsigned shift = be ? 8 * (size - 1 - i) : 8 * i;
+            out.emplace_back((uint8_t)(c >> shift));
+        }
+    };
+
+    if ( bom )
+        put(0xfeff);
+
+    for ( auto c : text )
+        put((uint8_t)c);
+
+    return out;
+}
+
+static std::string make_text(std::mt19937& gen, unsigned len)
+{
+    static const char chars[] =
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 <>/=\"'\n";
+
+    std::string s;
+
+    for ( unsigned i = 0; i < len; ++i )
+        s += chars[gen() % (sizeof(chars) - 1)];
+
+    return s;
+}
+
+// feed src through a session in random sized pieces with a small output buffer
+static std::string decode_pieces(
+    std::mt19937& gen, const std::vector<uint8_t>& src, CharsetCode cs, bool& clean)
+{
+    UtfDecodeSession session;
+    session.set_decode_utf_state_charset(cs);
+
+    std::string out;
+    uint8_t buf[1460];
+    size_t pos = 0;
+    clean = true;
+
+    while ( pos < src.size() )
+    {
+        unsigned len = 1 + gen() % 200;
+
+        if ( len > src.size() - pos )
+            len = src.size() - pos;
+
+        int copied = 0;
+        if ( !session.decode_utf(src.data() + pos, len, buf, sizeof(buf), &copied) )
+            clean = false;
+
+        out.append((const char*)buf, copied);
+        pos += len;
+    }
+    return out;
+}
+
+static const CharsetCode charsets[] =
+    { CHARSET_UTF16LE, CHARSET_UTF16BE, CHARSET_UTF32LE, CHARSET_UTF32BE };
+
+TEST_CASE("decode split across pdus", "[UtfDecodeSession]")
+{
+    std::mt19937 gen(7);
+
+    for ( auto cs : charsets )
+    {
+        for ( unsigned n = 0; n < 50; ++n )
+        {
+            std::string text = make_text(gen, gen() % 3000);
+            std::vector<uint8_t> src = encode(text, cs, false);
+
+            bool clean;
+            CHECK(decode_pieces(gen, src, cs, clean) == text);
+            CHECK(clean);
+        }
+    }
+}
+
+TEST_CASE("non ascii units are flagged", "[UtfDecodeSession]")
+{
+    std::mt19937 gen(11);
+
+    for ( auto cs : charsets )
+    {
+        std::string text = make_text(gen, 1000);
+        std::vector<uint8_t> src = encode(text, cs, false);
+
+        unsigned size = (cs == CHARSET_UTF16LE or cs == CHARSET_UTF16BE) ? 2 : 4;
+        bool be = (cs == CHARSET_UTF16BE or cs == CHARSET_UTF32BE);
+
+        // set a byte other than the kept one in one unit deep in the buffer
+        size_t unit = 700;
+        src[unit * size + (be ? 0 : size - 1)] = 0x04;
+
+        bool clean;
+        std::string out = decode_pieces(gen, src, cs, clean);
+
+        CHECK(out.size() == text.size());
+        CHECK(!clean);
+    }
+}
+
+TEST_CASE("bom detection", "[UtfDecodeSession]")
+{
+    std::mt19937 gen(13);
+    std::string text = make_text(gen, 500);
+
+    for ( auto cs : charsets )
+    {
+        std::vector<uint8_t> src = encode(text, cs, true);
+
+        UtfDecodeSession session;
+        session.set_decode_utf_state_charset(CHARSET_UNKNOWN);
+
+        std::vector<uint8_t> dst(src.size());
+        int copied = 0;
+
+        CHECK(session.decode_utf(src.data(), src.size(), dst.data(), dst.size(), &copied));
+        CHECK(session.get_decode_utf_state_charset() == cs);
+        CHECK(std::string((const char*)dst.data(), copied) == text);
+    }
+}
+
+TEST_CASE("output limited by dst", "[UtfDecodeSession]")
+{
+    std::mt19937 gen(17);
+    std::string text = make_text(gen, 100);
+    std::vector<uint8_t> src = encode(text, CHARSET_UTF16LE, false);
+
+    UtfDecodeSession session;
+    session.set_decode_utf_state_charset(CHARSET_UTF16LE);
+
+    uint8_t dst[37];
+    int copied = 0;
+
+    CHECK(session.decode_utf(src.data(), src.size(), dst, sizeof(dst), &copied));
+    CHECK(copied == sizeof(dst));
+    CHECK(std::string((const char*)dst, copied) == text.substr(0, sizeof(dst)));
+
+    // the last unit was cut short after its low byte, so the next byte seen is
+    // taken as the high byte of that unit
+    const uint8_t next[] = { 0x00, 'B', 0x00 };
+
+    CHECK(session.decode_utf(next, sizeof(next), dst, sizeof(dst), &copied));
+    CHECK(copied == 1);
+    CHECK(dst[0] == 'B');
+}
+
+TEST_CASE("large utf-16 document throughput", "[.bench][UtfDecodeSession]")
+{
+    std::mt19937 gen(19);
+    std::string text = make_text(gen, 8 * 1024 * 1024);
+
+    for ( auto cs : { CHARSET_UTF16LE, CHARSET_UTF16BE } )
+    {
+        std::vector<uint8_t> src = encode(text, cs, false);
+        std::vector<uint8_t> dst(text.size());
+        size_t out = 0;
+        bool clean = true;
+
+        Benchmark bench(cs == CHARSET_UTF16LE ? "utf.decode_utf16le" : "utf.decode_utf16be",
+            src.size(), "bytes");
+
+        bench.run([&]()
+        {
+            UtfDecodeSession session;
+            session.set_decode_utf_state_charset(cs);
+
+            // decode in typical segment sized pieces
+            size_t in = 0;
+            out = 0;
+            clean = true;
+
+            while ( in < src.size() )
+            {
+                unsigned len = std::min<size_t>(1460, src.size() - in);
+                int copied = 0;
+
+                if ( !session.decode_utf(src.data() + in, len, dst.data() + out, dst.size() - out,
+                    &copied) )
+                    clean = false;
+
+                in += len;
+                out += copied;
+            }
+        });
+
+        CHECK(clean);
+        CHECK(out == text.size());
+        CHECK(!memcmp(dst.data(), text.data(), text.size()));
+    }
+}
@@ -24,8 +24,64 @@
 
 #include "util_unfold.h"
 
+#include <algorithm>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace snort
 {
+static inline bool is_eol(uint8_t c)
+{ return c == '\r' or c == '\n'; }
+
+static inline bool is_lws(uint8_t c)
+{ return c == ' ' or c == '\t'; }
+
+/* Returns the first CR or LF in [cursor, end), or end.  With Lws, spaces
+ * and tabs also stop the scan.  Everything before the returned position
+ * can be copied as a block.
+ */
+template<bool Lws>
+static const uint8_t* find_special(const uint8_t* cursor, const uint8_t* end)
+{
+#ifdef __SSE2__
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i sp = _mm_set1_epi8(' ');
+    const __m128i ht = _mm_set1_epi8('\t');
+
+    while ( end - cursor >= 16 )
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)cursor);
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf));
+
+        if ( Lws )
+            m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, ht)));
+
+        if ( int bits = _mm_movemask_epi8(m) )
+            return cursor + __builtin_ctz(bits);
+
+        cursor += 16;
+    }
+#endif
+    while ( cursor < end and !is_eol(*cursor) and !(Lws and is_lws(*cursor)) )
+        ++cursor;
+
+    return cursor;
+}
+
+// copy up to stop, bounded by the space left in outbuf
+static inline uint32_t copy_run(
+    const uint8_t*& cursor, const uint8_t* stop, uint8_t* outbuf, uint32_t n, uint32_t outbuf_size)
+{
+    uint32_t len = std::min<size_t>(stop - cursor, outbuf_size - n);
+    memcpy(outbuf + n, cursor, len);
+    cursor += len;
+    return n + len;
+}
+
 /* Given a string, removes header folding (\r\n followed by linear whitespace)
  * and exits when the end of a header is found, defined as \n followed by a
  * non-whitespace.  This is especially helpful for HTML.
@@ -35,7 +91,6 @@ int sf_unfold_header(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
 {
     int num_spaces = 0;
     const uint8_t* cursor, * endofinbuf;
-    uint8_t* outbuf_ptr;
 
     uint32_t n = 0;
 
@@ -44,7 +99,6 @@ int sf_unfold_header(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
 
     cursor = inbuf;
     endofinbuf = inbuf + inbuf_size;
-    outbuf_ptr = outbuf;
 
     /* Keep adding chars until we get to the end of the line.  If we get to the
      * end of the line and the next line starts with a tab or space, add the space
@@ -52,7 +106,16 @@ int sf_unfold_header(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
      * tab or space, stop reading because that's the end of the header. */
     while ((cursor < endofinbuf) && (n < outbuf_size))
     {
-        if (((*cursor == ' ') || (*cursor == '\t')))
+        if ( !httpheaderfolding )
+        {
+            /* Ordinary header text is copied in blocks */
+            n = copy_run(cursor, find_special<true>(cursor, endofinbuf), outbuf, n, outbuf_size);
+
+            if ( cursor == endofinbuf or n == outbuf_size )
+                break;
+        }
+
+        if (is_lws(*cursor))
         {
             if (folding_present)
                 num_spaces++;
@@ -65,7 +128,7 @@ int sf_unfold_header(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
             else if (!trim_spaces)
             {
                 /* Spaces are valid except after CRs */
-                *outbuf_ptr++ = *cursor;
+                outbuf[n++] = *cursor;
             }
         }
         else if ((*cursor == '\n') && (httpheaderfolding != 1))
@@ -79,11 +142,6 @@ int sf_unfold_header(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
             /* CR needs to be followed by LF and can't start a line */
             httpheaderfolding = 2;
         }
-        else if (!httpheaderfolding)
-        {
-            *outbuf_ptr++ = *cursor;
-            n++;
-        }
         else
         {
             /* We have reached the end of the header
@@ -93,11 +151,11 @@ int sf_unfold_header(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
         cursor++;
     }
     if (n < outbuf_size)
-        *outbuf_ptr = '\0';
+        outbuf[n] = '\0';
     else
         outbuf[outbuf_size - 1] = '\0';
 
-    *output_bytes = outbuf_ptr - outbuf;
+    *output_bytes = n;
     if (folded)
         *folded = num_spaces;
     return 0;
@@ -109,7 +167,6 @@ int sf_strip_CRLF(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
     uint32_t outbuf_size, uint32_t* output_bytes)
 {
     const uint8_t* cursor, * endofinbuf;
-    uint8_t* outbuf_ptr;
     uint32_t n = 0;
 
     if ( !inbuf || !outbuf)
@@ -117,19 +174,21 @@ int sf_strip_CRLF(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
 
     cursor = inbuf;
     endofinbuf = inbuf + inbuf_size;
-    outbuf_ptr = outbuf;
+
     while ((cursor < endofinbuf) && (n < outbuf_size))
     {
-        if ((*cursor != '\n') && (*cursor != '\r'))
+        const uint8_t* eol = find_special<false>(cursor, endofinbuf);
+        n = copy_run(cursor, eol, outbuf, n, outbuf_size);
+
+        if ( cursor == eol )
         {
-            *outbuf_ptr++ = *cursor;
-            n++;
+            while ( cursor < endofinbuf and is_eol(*cursor) )
+                cursor++;
         }
-        cursor++;
     }
 
     if (output_bytes)
-        *output_bytes = outbuf_ptr - outbuf;
+        *output_bytes = n;
 
     return(0);
 }
@@ -142,7 +201,6 @@ int sf_strip_LWS(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
     uint32_t outbuf_size, uint32_t* output_bytes)
 {
     const uint8_t* cursor, * endofinbuf;
-    uint8_t* outbuf_ptr;
     uint32_t n = 0;
     uint8_t lws = 0;
 
@@ -151,40 +209,28 @@ int sf_strip_LWS(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
 
     cursor = inbuf;
     endofinbuf = inbuf + inbuf_size;
-    outbuf_ptr = outbuf;
+
     while ((cursor < endofinbuf) && (n < outbuf_size))
     {
-        if ((*cursor != '\n') && (*cursor != '\r'))
+        if (!is_eol(*cursor))
         {
-            if ((*cursor != ' ') && (*cursor != '\t'))
-                lws = 0;
-            else
-                lws = 1;
-            *outbuf_ptr++ = *cursor;
-            n++;
+            n = copy_run(cursor, find_special<false>(cursor, endofinbuf), outbuf, n, outbuf_size);
+            lws = is_lws(outbuf[n - 1]);
+            continue;
         }
-        else
-        {
-            if (lws)
-            {
-                lws = 0;
-                while ( n > 0 )
-                {
-                    if ((*(outbuf_ptr-1) != ' ') && (*(outbuf_ptr-1) !='\t'))
-                        break;
-                    n--;
-                    outbuf_ptr--;
-                }
-            }
 
-            *outbuf_ptr++ = *cursor;
-            n++;
+        if (lws)
+        {
+            lws = 0;
+            while ( n > 0 and is_lws(outbuf[n - 1]) )
+                n--;
         }
-        cursor++;
+
+        outbuf[n++] = *cursor++;
     }
 
     if (output_bytes)
-        *output_bytes = outbuf_ptr - outbuf;
+        *output_bytes = n;
 
     return(0);
 }
@@ -28,6 +28,10 @@
 #include <cassert>
 #include <cstring>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #ifdef HAVE_ICONV
 #include <iconv.h>
 #endif
@@ -39,6 +43,133 @@
 
 using namespace snort;
 
+//--------------------------------------------------------------------------
+// bulk narrowing
+//
+// Copies n whole code units of Size bytes from src to dst, keeping the byte at
+// offset Keep of each unit, and returns false if any other byte is nonzero.
+// This is what the per byte state machines below do from DSTATE_FIRST; they
+// only handle the partial units left at the ends of a buffer.
+//--------------------------------------------------------------------------
+
+template<unsigned Size, unsigned Keep>
+static bool narrow_units_scalar(const uint8_t* src, uint8_t* dst, unsigned n)
+{
+    uint8_t others = 0;
+
+    for ( unsigned i = 0; i < n; ++i, src += Size )
+    {
+        dst[i] = src[Keep];
+
+        for ( unsigned b = 0; b < Size; ++b )
+            others |= (b == Keep) ? 0 : src[b];
+    }
+    return !others;
+}
+
+#ifdef __SSE2__
+
+// 16 units per iteration: the kept bytes are shifted to the bottom of each
+// lane and packed down, everything else is or'd into the check vector
+template<unsigned Keep>
+static bool narrow_units_16(const uint8_t* src, uint8_t* dst, unsigned n)
+{
+    const __m128i low = _mm_set1_epi16(0x00ff);
+    __m128i others = _mm_setzero_si128();
+    unsigned i = 0;
+
+    for ( ; i + 16 <= n; i += 16, src += 32 )
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)src);
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 16));
+
+        if ( Keep )
+        {
+            others = _mm_or_si128(others, _mm_or_si128(_mm_and_si128(a, low), _mm_and_si128(b, low)));
+            a = _mm_srli_epi16(a, 8);
+            b = _mm_srli_epi16(b, 8);
+        }
+        else
+        {
+            others = _mm_or_si128(others, _mm_or_si128(_mm_andnot_si128(low, a), _mm_andnot_si128(low, b)));
+            a = _mm_and_si128(a, low);
+            b = _mm_and_si128(b, low);
+        }
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(a, b));
+    }
+
+    bool clean = _mm_movemask_epi8(_mm_cmpeq_epi8(others, _mm_setzero_si128())) == 0xffff;
+    return narrow_units_scalar<2, Keep>(src, dst + i, n - i) and clean;
+}
+
+template<unsigned Keep>
+static bool narrow_units_32(const uint8_t* src, uint8_t* dst, unsigned n)
+{
+    const __m128i keep = _mm_set1_epi32((int)(0xffu << (8 * Keep)));
+    __m128i others = _mm_setzero_si128();
+    unsigned i = 0;
+
+    for ( ; i + 16 <= n; i += 16, src += 64 )
+    {
+        __m128i v[4];
+
+        for ( unsigned j = 0; j < 4; ++j )
+        {
+            v[j] = _mm_loadu_si128((const __m128i*)(src + 16 * j));
+            others = _mm_or_si128(others, _mm_andnot_si128(keep, v[j]));
+            v[j] = _mm_srli_epi32(_mm_and_si128(v[j], keep), 8 * Keep);
+        }
+
+        __m128i lo = _mm_packs_epi32(v[0], v[1]);
+        __m128i hi = _mm_packs_epi32(v[2], v[3]);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+
+    bool clean = _mm_movemask_epi8(_mm_cmpeq_epi8(others, _mm_setzero_si128())) == 0xffff;
+    return narrow_units_scalar<4, Keep>(src, dst + i, n - i) and clean;
+}
+
+template<unsigned Size, unsigned Keep>
+static bool narrow_units(const uint8_t* src, uint8_t* dst, unsigned n)
+{
+    if ( Size == 2 )
+        return narrow_units_16<Keep>(src, dst, n);
+
+    return narrow_units_32<Keep>(src, dst, n);
+}
+
+#else
+
+template<unsigned Size, unsigned Keep>
+static bool narrow_units(const uint8_t* src, uint8_t* dst, unsigned n)
+{ return narrow_units_scalar<Size, Keep>(src, dst, n); }
+
+#endif
+
+// consume as many whole units as fit in both buffers when at a unit boundary
+template<unsigned Size, unsigned Keep>
+static bool narrow_bulk(
+    int state, const uint8_t*& src, const uint8_t* src_end, uint8_t*& dst, const uint8_t* dst_end)
+{
+    if ( state != DSTATE_FIRST )
+        return true;
+
+    unsigned n = (unsigned)(src_end - src) / Size;
+    unsigned room = (unsigned)(dst_end - dst);
+
+    // when the output fills up, the last unit is left to the byte loop so
+    // the state ends where it always has, part way through that unit
+    if ( n >= room )
+        n = room ? room - 1 : 0;
+
+    bool result = narrow_units<Size, Keep>(src, dst, n);
+
+    src += n * Size;
+    dst += n;
+
+    return result;
+}
+
 UtfDecodeSession::UtfDecodeSession()
 {
     init_decode_utf_state();
@@ -89,6 +220,9 @@ bool UtfDecodeSession::DecodeUTF16LE(const uint8_t* src, unsigned int src_len, u
     uint8_t* dst_index = dst;
     bool result = true;
 
+    if ( !narrow_bulk<2, 0>(dstate.state, src_index, src + src_len, dst_index, dst + dst_len) )
+        result = false;
+
     while ((src_index < (src + src_len)) &&
         (dst_index < (dst + dst_len)))
     {
@@ -132,6 +266,9 @@ bool UtfDecodeSession::DecodeUTF16BE(const uint8_t* src, unsigned int src_len, u
     uint8_t* dst_index = dst;
     bool result = true;
 
+    if ( !narrow_bulk<2, 1>(dstate.state, src_index, src + src_len, dst_index, dst + dst_len) )
+        result = false;
+
     while ((src_index < (src + src_len)) &&
         (dst_index < (dst + dst_len)))
     {
@@ -175,6 +312,9 @@ bool UtfDecodeSession::DecodeUTF32LE(const uint8_t* src, unsigned int src_len, u
     uint8_t* dst_index = dst;
     bool result = true;
 
+    if ( !narrow_bulk<4, 0>(dstate.state, src_index, src + src_len, dst_index, dst + dst_len) )
+        result = false;
+
     while ((src_index < (src + src_len)) &&
         (dst_index < (dst + dst_len)))
     {
@@ -223,6 +363,9 @@ bool UtfDecodeSession::DecodeUTF32BE(const uint8_t* src, unsigned int src_len, u
     uint8_t* dst_index = dst;
     bool result = true;
 
+    if ( !narrow_bulk<4, 3>(dstate.state, src_index, src + src_len, dst_index, dst + dst_len) )
+        result = false;
+
     while ((src_index < (src + src_len)) &&
         (dst_index < (dst + dst_len)))
     {
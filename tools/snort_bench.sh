@@ -0,0 +1,82 @@
+#!/bin/bash
+
+##--------------------------------------------------------------------------
+## Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+##
+## This program is free software; you can redistribute it and/or modify it
+## under the terms of the GNU General Public License Version 2 as published
+## by the Free Software Foundation.  You may not use, modify or distribute
+## this program under any other version of the GNU General Public License.
+##
+## This program is distributed in the hope that it will be useful, but
+## WITHOUT ANY WARRANTY; without even the implied warranty of
+## MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+## General Public License for more details.
+##
+## You should have received a copy of the GNU General Public License along
+## with this program; if not, write to the Free Software Foundation, Inc.,
+## 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+##--------------------------------------------------------------------------
+
+##--------------------------------------------------------------------
+## End to end throughput of a snort build over pcap and hext captures.
+## Each capture is run several times through the file or hext DAQ and
+## one JSON object per capture is printed with the median and worst
+## run so results can be compared between builds.
+##--------------------------------------------------------------------
+
+usage()
+{
+    echo "usage: $0 [-s snort] [-c conf] [-d daq_dir] [-n runs] capture..."
+    echo "  captures ending in .hext use the hext DAQ, all others the file DAQ"
+    exit 1
+}
+
+snort=snort
+conf=
+daq_dir=
+runs=5
+
+while getopts "s:c:d:n:h" opt; do
+    case $opt in
+        s) snort=$OPTARG ;;
+        c) conf=$OPTARG ;;
+        d) daq_dir=$OPTARG ;;
+        n) runs=$OPTARG ;;
+        *) usage ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+[ $# -gt 0 ] || usage
+
+args=()
+[ -n "$conf" ] && args+=(-c "$conf")
+[ -n "$daq_dir" ] && args+=(--daq-dir "$daq_dir")
+
+for cap in "$@"; do
+    if [[ "$cap" == *.hext ]]; then
+        daq=hext
+    else
+        daq=file
+    fi
+
+    for ((i = 0; i < runs; i++)); do
+        # the timing summary gives run seconds and the daq counts give packets
+        "$snort" "${args[@]}" --daq "$daq" -r "$cap" -z 1 2>&1 |
+            awk '$1 == "seconds:" { secs = $2 }
+                 $1 == "analyzed:" && !pkts { pkts = $2 }
+                 END { if ( secs > 0 && pkts > 0 ) printf "%.0f %.3f\n", pkts / secs, 1e6 * secs / pkts }'
+    done |
+    sort -n |
+    awk -v cap="$cap" -v daq="$daq" '
+        { pps[NR] = $1; usecs[NR] = $2 }
+        END {
+            if ( !NR ) { printf "{\"capture\": \"%s\", \"error\": \"no timing output\"}\n", cap; exit }
+            mid = int((NR + 1) / 2)
+            printf "{\"capture\": \"%s\", \"daq\": \"%s\", \"runs\": %d, ", cap, daq, NR
+            printf "\"pkts_per_sec_p50\": %s, \"pkts_per_sec_min\": %s, ", pps[mid], pps[1]
+            printf "\"usecs_per_pkt_p50\": %s, \"usecs_per_pkt_max\": %s}\n", usecs[mid], usecs[1]
+        }'
+done
+